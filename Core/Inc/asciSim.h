@@ -0,0 +1,182 @@
+#ifndef INC_ASCISIM_H_
+#define INC_ASCISIM_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"
+#include "bmbInterface.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Unused interrupt the simulated SPI completions and ASCI INT edges are delivered from. The SPDIF
+// receiver is not used on the BMS
+#define ASCI_SIM_IRQn			SPDIF_RX_IRQn
+#define ASCI_SIM_IRQHandler		SPDIF_RX_IRQHandler
+
+// Longest simulated daisy chain
+#define ASCI_SIM_MAX_BMBS		MAX_BMBS_PER_CHAIN
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// Rewrites a frame that returned to a simulated ASCI before it is placed in the receive buffer
+typedef void (*SimReturnFrameHook)(uint32_t chainIdx, uint8_t* frame, uint32_t* length);
+
+typedef struct
+{
+	uint32_t numTransfers;		// SPI transfers served by the model
+	uint32_t numFramesSent;		// Load queues released onto a daisy chain
+	uint32_t numFramesReturned;	// Frames that made it back to the ASCI receive buffer
+	uint32_t numFramesLost;		// Frames lost at a broken hop or the open end of a chain
+	uint32_t numRxOverflows;	// Frames dropped because the ASCI receive buffer was full
+	uint32_t numBitErrors;		// Bit errors injected on the daisy chain
+	uint32_t numPowerOnResets;	// BMB power-on resets injected
+	uint32_t numScans;			// Scans started on all simulated BMBs
+	uint32_t numEventsDropped;	// Completions or interrupts lost because the event queue was full
+} Asci_Sim_Stats_S;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Connect an ASCI daisy chain to the model. The first time a chain is connected its
+		   BMBs are created with the pack expected by the BMS
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   intPin - The ASCI INT external interrupt pin
+*/
+void simAsciAttach(uint32_t chainIdx, SPI_HandleTypeDef* hspi, uint16_t intPin);
+
+/*!
+  @brief   Power the simulated ASCI on or off. Powering it on resets the ASCI registers and buffers
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   enabled - True to power on the ASCI, false to shut it down
+*/
+void simAsciSetPower(SPI_HandleTypeDef* hspi, bool enabled);
+
+/*!
+  @brief   Run an SPI transfer against the simulated ASCI. Received data is available on return.
+		   The transfer complete callback and any ASCI INT edge are delivered later from the
+		   simulation interrupt, the same way the SPI and EXTI interrupts would deliver them
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   txData - The bytes sent to the ASCI
+  @param   rxData - Updated with the bytes received from the ASCI. NULL for a transmit only transfer
+  @param   size - The number of bytes in the transfer
+  @return  HAL_OK if the transfer was accepted, HAL_ERROR otherwise
+*/
+HAL_StatusTypeDef simAsciTransmit(SPI_HandleTypeDef* hspi, const uint8_t* txData, uint8_t* rxData, uint16_t size);
+
+/*!
+  @brief   Abort the transfer in progress on the simulated ASCI. Its completion callback is dropped
+  @param   hspi - The SPI bus the ASCI is connected to
+  @return  HAL_OK
+*/
+HAL_StatusTypeDef simAsciAbort(SPI_HandleTypeDef* hspi);
+
+/*!
+  @brief   Set the number of BMBs on a simulated daisy chain. New BMBs start powered on reset
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   numBmbs - The number of BMBs on the chain. Limited to ASCI_SIM_MAX_BMBS
+*/
+void simSetNumBmbs(uint32_t chainIdx, uint32_t numBmbs);
+
+/*!
+  @brief   Set the voltage of a simulated brick. Takes effect on the next scan
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   brickIdx - The brick on the BMB
+  @param   voltage - The brick voltage in V
+*/
+void simSetBrickVoltage(uint32_t chainIdx, uint32_t bmbIdx, uint32_t brickIdx, float voltage);
+
+/*!
+  @brief   Set the temperature of a simulated brick. Takes effect on the next scan of its mux channel
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   brickIdx - The brick on the BMB
+  @param   temp - The brick temperature in C
+*/
+void simSetBrickTemp(uint32_t chainIdx, uint32_t bmbIdx, uint32_t brickIdx, float temp);
+
+/*!
+  @brief   Set the temperature of a simulated BMB board temperature sensor. Takes effect on the next
+		   scan of its mux channel
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   sensorIdx - The board temperature sensor
+  @param   temp - The board temperature in C
+*/
+void simSetBoardTemp(uint32_t chainIdx, uint32_t bmbIdx, uint32_t sensorIdx, float temp);
+
+/*!
+  @brief   Shorten simulated scans to run the firmware faster than real time. The firmware scan
+		   prediction follows the shorter scans
+  @param   divisor - The scan duration is divided by this. 1 for real time
+*/
+void simSetScanTimeDivisor(uint32_t divisor);
+
+/*!
+  @brief   Corrupt a bit of every Nth frame crossing a hop of a simulated daisy chain
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   hopIdx - The hop into BMB hopIdx. Hop 0 is between the ASCI and the first BMB
+  @param   period - Corrupt one frame out of every period frames. 0 to stop injecting bit errors
+*/
+void simInjectBitErrors(uint32_t chainIdx, uint32_t hopIdx, uint32_t period);
+
+/*!
+  @brief   Break a hop of a simulated daisy chain. Frames can not cross a broken hop
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   hopIdx - The hop into BMB hopIdx. Hop numBmbs is the external loopback. -1 to repair the chain
+*/
+void simBreakHop(uint32_t chainIdx, int32_t hopIdx);
+
+/*!
+  @brief   Connect or disconnect the external loopback at the end of a simulated daisy chain
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   connected - True if frames passing the last BMB return to the ASCI
+*/
+void simSetExternalLoopback(uint32_t chainIdx, bool connected);
+
+/*!
+  @brief   Power-on reset a simulated BMB. Its registers return to their reset values and ALRTRST
+		   is set. The BMB keeps its daisy chain address
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+*/
+void simPowerOnReset(uint32_t chainIdx, uint32_t bmbIdx);
+
+/*!
+  @brief   Get the time until the oldest pending SPI completion or ASCI INT edge would occur on the
+		   real bus. Events are delivered as soon as the simulation interrupt runs, so only a host
+		   harness that keeps its own clock needs this to follow the bus timing
+  @return  The number of DWT cycles until the oldest event is due, 0 if it is due or none is pending
+*/
+uint32_t simPendingEventDelayCycles(void);
+
+/*!
+  @brief   Add random noise to every sample of a simulated brick voltage. Oversampling averages
+		   it down by the square root of the number of samples
+  @param   noiseUv - The noise of a single sample in uV rms. 0 for noise free measurements
+*/
+void simSetMeasurementNoise(float noiseUv);
+
+/*!
+  @brief   Set a hook that can rewrite every frame returning to a simulated ASCI. Frames are
+		   rewritten after the BMBs have processed them, so the model still follows every command
+  @param   hook - The hook, NULL to return the frames built by the model
+*/
+void simSetReturnFrameHook(SimReturnFrameHook hook);
+
+
+#endif /* INC_ASCISIM_H_ */
@@ -14,7 +14,22 @@
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
+// Scan period while cells are balancing. Balancing is paused during every scan so scans are spaced out
 #define BMB_DATA_REFRESH_DELAY_MS 50
+// Time allowed for a scan to complete before it is restarted
+#define BMB_SCAN_TIMEOUT_MS 50
+// Time allowed for reading out a scan, including all retries. Registers not read in time are marked BAD
+#define BMB_SCAN_COMMS_BUDGET_MS 30
+// Period of the read back audit of the BMB configuration. Per scan writes are not verified
+#define BMB_CONFIG_AUDIT_PERIOD_MS 1000
+
+// Default target refresh period of each scan data product. See planBmbScans
+#define SCAN_CELL_V_PERIOD_MS		20
+#define SCAN_CELL_EXTREMES_PERIOD_MS	5
+#define SCAN_SEGMENT_V_PERIOD_MS	100
+#define SCAN_BRICK_TEMP_PERIOD_MS	500
+#define SCAN_BOARD_TEMP_PERIOD_MS	1000
+#define SCAN_DIAGNOSTICS_PERIOD_MS	BMB_CONFIG_AUDIT_PERIOD_MS
 
 #define VERSION			0x00
 #define ADDRESS			0x01
@@ -31,6 +46,8 @@
 #define GPIO 			0x11
 #define MEASUREEN 		0x12
 #define SCANCTRL		0x13
+#define ALRTOVEN		0x14
+#define ALRTUVEN		0x15
 #define WATCHDOG		0x18
 #define ACQCFG			0x19
 #define BALSWEN			0x1A
@@ -39,18 +56,35 @@
 #define VBLOCK			0x2C
 #define AIN1			0x2D
 #define AIN2			0x2E
+#define OVTHCLR			0x40
+#define OVTHSET			0x41
+#define UVTHCLR			0x42
+#define UVTHSET			0x43
 #define ALRTRST			0x8000
+// MINMAXCELL holds the index of the highest brick in [11:8] and of the lowest brick in [3:0]
+#define MINMAXCELL_MAX_SHIFT	8
+#define MINMAXCELL_INDEX_MASK	0x000F
 
 #define NUM_BRICKS_PER_BMB		12
 #define NUM_BOARD_TEMP_PER_BMB 	4
 
 // 3.3V range & 12 bit reading - 3.3/(2^12) = 805.664 uV/bit
-#define CONVERT_12BIT_TO_3V3				0.000805664f;
+#define CONVERT_12BIT_TO_3V3				0.000805664f
 // 5V range & 14 bit reading   - 5/(2^14)   = 305.176 uV/bit
 #define CONVERT_14BIT_TO_5V					0.000305176f
 // 60V range & 14 bit reading  - 60/(2^14)  = 3.6621 mV/bit
 #define CONVERT_14BIT_TO_60V				0.0036621f
 
+// Sensor readings are kept as the raw ADC code in [13:0] with its Sensor_Status_E in [15:14]. They
+// are only converted to engineering units where needed. See convertBrickV and friends
+#define SENSOR_CODE_MASK					0x3FFF
+#define SENSOR_STATUS_SHIFT					14
+#define SENSOR_CODE(reading)				((uint16_t)((reading) & SENSOR_CODE_MASK))
+#define SENSOR_STATUS(reading)				((Sensor_Status_E)((reading) >> SENSOR_STATUS_SHIFT))
+#define SENSOR_READING(code, status)		((uint16_t)(((code) & SENSOR_CODE_MASK) | ((status) << SENSOR_STATUS_SHIFT)))
+// Brick voltage threshold as a 14 bit code, rounded to the nearest LSB. Folded at compile time for constants
+#define BRICK_V_TO_CODE(v)					((uint16_t)(((v) / CONVERT_14BIT_TO_5V) + 0.5f))
+
 // The minimum voltage that we can bleed to
 #define MIN_BLEED_TARGET_VOLTAGE_V 			3.5f
 // The maximum allowed board temp where bleeding is allowed
@@ -84,42 +118,71 @@ typedef enum
 	NUM_MUX_CHANNELS
 } Mux_State_E;
 
+// Data refreshed by the BMB scans. Each product is scheduled at its own rate by planBmbScans
+typedef enum
+{
+	SCAN_CELL_V = 0,	// Brick voltages
+	SCAN_CELL_EXTREMES,	// Highest and lowest brick voltages. Located by MINMAXCELL, only the bricks between them are read
+	SCAN_SEGMENT_V,		// Block voltage
+	SCAN_BRICK_TEMP,	// Brick temperatures. A refresh takes mux channels 1-6
+	SCAN_BOARD_TEMP,	// Board temperatures. A refresh takes mux channels 7 and 8
+	SCAN_DIAGNOSTICS,	// Read back audit of the BMB configuration
+	NUM_SCAN_PRODUCTS
+} Scan_Product_E;
+
+// Scan acquisition settings. Each sample is tagged with the profile that produced it
+typedef enum
+{
+	ACQ_PROFILE_PRECISE = 0,	// 32 oversamples and full settling time. Low noise data at rest
+	ACQ_PROFILE_FAST,			// 4 oversamples, short settling time and no VBLOCK. Low latency data under load
+	NUM_ACQ_PROFILES
+} Acq_Profile_E;
+
 
 /* ==================================================================== */
 /* ============================== STRUCTS============================== */
 /* ==================================================================== */
 
+// Scan latency and brick voltage noise of an acquisition profile. See measureAcqProfile
+typedef struct
+{
+	float latencyMs;		// Average time from the start of a scan until its data was decoded
+	float noiseUv;			// Brick voltage noise in uV rms
+	uint32_t numSamples;	// Scans that produced brick voltages with the profile
+} Acq_Profile_Result_S;
+
 // TODO add description
 typedef struct
 {
-	const uint32_t bmbIdx;
 	uint32_t numBricks;
-	// TODO - set initial status value to UNINITIALIZED
-	// The status of all the brick sensors
-	Sensor_Status_E brickVStatus[NUM_BRICKS_PER_BMB];
-	// The brick voltages for the bmb
-	float brickV[NUM_BRICKS_PER_BMB];
+	// Sensor readings hold the raw ADC code and its status. A zeroed reading is UNINITIALIZED
+	// The brick voltage readings for the bmb. 14 bit codes, see convertBrickV
+	uint16_t brickVCode[NUM_BRICKS_PER_BMB];
+	// The acquisition profile of the scan the brick voltages came from. Tags are Acq_Profile_E
+	// values stored in a byte so they stay smaller than the codes they tag
+	uint8_t brickVProfile;
 	
 	// The resistance of the brick
 	float brickResistance[NUM_BRICKS_PER_BMB];
 
-	// The segment voltage measurement status 
-	Sensor_Status_E segmentVStatus;
-	// The segment voltage measurement is the total BMB voltage
-	float segmentV;
+	// The segment voltage reading is the total BMB voltage. 14 bit code, see convertSegmentV
+	uint16_t segmentVCode;
+	uint8_t segmentVProfile;
 
-	// The status of the brick temp sensors
-	Sensor_Status_E brickTempStatus[NUM_BRICKS_PER_BMB];
-	// The converted temperatures for all the brick temp sensors
-	float brickTemp[NUM_BRICKS_PER_BMB];
+	// The brick temp sensor readings. 12 bit AUX codes, see convertBrickTemp
+	uint16_t brickTempCode[NUM_BRICKS_PER_BMB];
+	uint8_t brickTempProfile[NUM_BRICKS_PER_BMB];
 	
-	// The status of the board temp sensors
-	Sensor_Status_E boardTempStatus[NUM_BOARD_TEMP_PER_BMB];
-	// The converted temperature for all board temp sensors
-	float boardTemp[NUM_BOARD_TEMP_PER_BMB];
+	// The board temp sensor readings. 12 bit AUX codes, see convertBoardTemp
+	uint16_t boardTempCode[NUM_BOARD_TEMP_PER_BMB];
+	uint8_t boardTempProfile[NUM_BOARD_TEMP_PER_BMB];
 
 	float sumBrickV;
 
+	// Brick voltage extremes as codes for threshold checks
+	uint16_t maxBrickVCode;
+	uint16_t minBrickVCode;
+
 	float maxBrickV;
 	float minBrickV;
 	float avgBrickV;
@@ -135,8 +198,16 @@ typedef struct
 	float avgBoardTemp;
 	uint32_t numBadBoardTemp;
 
+	// Bricks over or under the hardware alert thresholds at the last alert poll, bit n is brick n
+	uint16_t ovBrickAlerts;
+	uint16_t uvBrickAlerts;
+
 	// Indicates that a BMB reinitialization is required
 	bool reinitRequired;
+	// Configuration registers found to have drifted by the configuration audit
+	uint32_t numConfigDrifts;
+	// Full brick readouts where MINMAXCELL did not point at the highest and lowest brick
+	uint32_t numMinMaxMismatches;
 
 	// Balancing Configuration
 	bool balSwRequested[NUM_BRICKS_PER_BMB];	// Set by BMS to determine which cells need to be balanced
@@ -155,12 +226,88 @@ typedef struct
 void initBmbs(uint32_t numBmbs);
 
 /*!
-  @brief   Update BMB voltages and temperature data. Once new data gathered start new
-		   data acquisition scan
-  @param   bmb - BMB array data
-  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @brief   Update BMB voltages and temperature data on every daisy chain. All chains scan in
+		   lockstep and are read out concurrently. Data is read out as soon as the scan is
+		   predicted to be done, then a new data acquisition scan is started
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+*/
+void updateBmbData(Bmb_S* bmb, const uint32_t* chainNumBmbs);
+
+/*!
+  @brief   Run the scan loop until the next scan is read out. Gives up once a scan and its slot
+		   should have completed
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @return  True if a scan was read out, false if it timed out
+*/
+bool runBmbScanToReadout(Bmb_S* bmb, const uint32_t* chainNumBmbs);
+
+/*!
+  @brief   Measure the scan latency and the brick voltage noise of the first BMB with an
+		   acquisition profile. Noise is estimated from the difference of successive samples so
+		   the pack must be at rest. The profile is left selected
+  @param   profile - The acquisition profile
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   numScans - The number of scan readouts to run
+  @param   result - Updated with the latency, noise and number of samples measured
+*/
+void measureAcqProfile(Acq_Profile_E profile, Bmb_S* bmb, const uint32_t* chainNumBmbs, uint32_t numScans, Acq_Profile_Result_S* result);
+
+/*!
+  @brief   Plan the repeating scan schedule used by updateBmbData. Every scan slot is long enough
+		   for the scan and readout of the data it refreshes at the current ASCI SPI clock. The
+		   slot period follows the fastest target rate. Only the channels and registers a slot
+		   needs are scanned and read, and the temperatures share the mux one channel per slot
+  @param   periodMs - The target refresh period of each data product in ms, indexed by Scan_Product_E
+  @param   numBmbs - The number of BMBs on the longest daisy chain
+  @return  True if every target rate is met, false if some data is refreshed slower
+*/
+bool planBmbScans(const uint32_t* periodMs, uint32_t numBmbs);
+
+/*!
+  @brief   Read the hardware alert registers of all BMBs on every daisy chain. The BMBs compare
+		   every brick against the OV/UV thresholds after each scan, so this catches a brick
+		   limit without waiting for a scan readout. It is far cheaper than a readout and can run
+		   between them. BMBs found reset are flagged for reinitialization
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @return  True if the alert registers were read from all BMBs, false otherwise
+*/
+bool pollBmbAlerts(Bmb_S* bmb, const uint32_t* chainNumBmbs);
+
+/*!
+  @brief   Select the acquisition profile used from the next scan on
+  @param   profile - The acquisition profile
+*/
+void setAcqProfile(Acq_Profile_E profile);
+
+/*!
+  @brief   Get the acquisition profile selected for the next scan
+  @return  The acquisition profile
+*/
+Acq_Profile_E getAcqProfile();
+
+/*!
+  @brief   Get the time from the start of the last scan read out to its data being decoded
+  @return  The scan latency in ms
 */
-void updateBmbData(Bmb_S* bmb, uint32_t numBmbs);
+uint32_t getLastScanLatencyMs();
+
+/*!
+  @brief   Get the scan slot period planned for an acquisition profile
+  @param   profile - The acquisition profile
+  @return  The slot period in ms
+*/
+uint32_t getScanSlotMs(Acq_Profile_E profile);
+
+/*!
+  @brief   Estimate the SPI transfer time of a scan readout on the selected daisy chain
+  @param   numBmbs - The number of BMBs on the daisy chain
+  @return  The estimated transfer time in us
+*/
+uint32_t estimateScanReadoutUs(uint32_t numBmbs);
 
 /*!
   @brief   Set a given mux configuration on all BMBs
@@ -176,6 +323,42 @@ void setMux(uint32_t numBmbs, uint8_t muxSetting);
 */
 void aggregateBmbData(Bmb_S* bmb,uint32_t numBmbs);
 
+/*!
+  @brief   Convert a brick voltage reading to volts
+  @param   reading - The brick voltage reading
+  @return  The brick voltage in V
+*/
+float convertBrickV(uint16_t reading);
+
+/*!
+  @brief   Convert a segment voltage reading to volts
+  @param   reading - The segment voltage reading
+  @return  The segment voltage in V
+*/
+float convertSegmentV(uint16_t reading);
+
+/*!
+  @brief   Convert a brick temp sensor reading to degrees
+  @param   reading - The brick temp sensor reading
+  @return  The brick temperature in C
+*/
+float convertBrickTemp(uint16_t reading);
+
+/*!
+  @brief   Convert a board temp sensor reading to degrees
+  @param   reading - The board temp sensor reading
+  @return  The board temperature in C
+*/
+float convertBoardTemp(uint16_t reading);
+
+/*!
+  @brief   Convert a brick temperature threshold to a brick temp sensor code. The code falls as
+		   the temperature rises
+  @param   temp - The brick temperature in C
+  @return  The 12 bit AUX code
+*/
+uint16_t convertBrickTempToCode(float temp);
+
 
 /*!
   @brief   Set or clear the internal loopback mode for a specific BMB.
@@ -186,7 +369,9 @@ void aggregateBmbData(Bmb_S* bmb,uint32_t numBmbs);
 bool setBmbInternalLoopback(uint32_t bmbIdx, bool enabled);
 
 /*!
-  @brief   Determine where a BMB daisy chain break has occured
+  @brief   Determine where a break has occured on the selected BMB daisy chain. The break is located
+		   by bisection so only O(log n) BMBs have internal loopback enabled. The last known break
+		   location on the chain is checked first
   @param   bmb - The array containing BMB data
   @param   numBmbs - The expected number of BMBs in the daisy chain
   @returns bmb index of BMB where communication failed (1 indexed)
@@ -195,15 +380,41 @@ bool setBmbInternalLoopback(uint32_t bmbIdx, bool enabled);
 int32_t detectBmbDaisyChainBreak(Bmb_S* bmb, uint32_t numBmbs);
 
 /*!
-  @brief   Determine if a power-on reset (POR) occurred and if so properly reset the device
+  @brief   Determine if a power-on reset (POR) occurred on any BMB and flag it for reinitialization
+  @param   bmb - The array containing BMB data
+  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @return  True if the STATUS register was read from all BMBs, false otherwise
+*/
+bool detectPowerOnReset(Bmb_S* bmb, uint32_t numBmbs);
+
+/*!
+  @brief   Detect BMBs that were reset since they were configured and rewrite only their
+		   configuration
   @param   bmb - The array containing BMB data
   @param   numBmbs - The expected number of BMBs in the daisy chain
+  @returns The number of BMBs reinitialized, -1 if the BMBs could not be checked or reinitialized
 */
-void detectPowerOnReset(Bmb_S* bmb, uint32_t numBmbs);
+int32_t reinitResetBmbs(Bmb_S* bmb, uint32_t numBmbs);
 
 /*!
-  @brief   Handles balancing the cells based on BMS control
+  @brief   Determine whether any BMB was found reset and still needs its configuration rewritten
   @param   bmb - The array containing BMB data
+  @param   numBmbs - The number of BMBs in the array
+  @returns True if any BMB requires reinitialization, false otherwise
+*/
+bool bmbReinitRequired(Bmb_S* bmb, uint32_t numBmbs);
+
+/*!
+  @brief   Run a targeted diagnostic read on the BMB with the worst link error rate, if any link
+		   is suspect. The result is recorded in the BMB link statistics
+  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @returns The daisy chain position of the BMB checked, -1 if no link is suspect
+*/
+int32_t diagnoseSuspectBmbLink(uint32_t numBmbs);
+
+/*!
+  @brief   Handles balancing the cells on the selected daisy chain based on BMS control
+  @param   bmb - The array containing BMB data of the selected daisy chain
   @param   numBmbs - The expected number of BMBs in the daisy chain
 */
 void balanceCells(Bmb_S* bmb, uint32_t numBmbs);
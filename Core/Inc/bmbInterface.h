@@ -7,20 +7,93 @@
 /* ==================================================================== */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
+#include "main.h"
 
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
-#define SPI_BUFF_SIZE 64
+// Number of ASCIs, each driving its own BMB daisy chain on a separate SPI bus. Scan readouts run on
+// all chains concurrently. A second chain needs hspi3, CS_ASCI2, SHDN2 and INT2 set up in CubeMX.
+// The host simulation in test/sim also builds a two chain configuration from the command line
+#ifndef NUM_ASCI_CHAINS
+#define NUM_ASCI_CHAINS 1
+#endif
+// The number of BMBs expected on each ASCI daisy chain. bms.h checks that the chains add up to
+// NUM_BMBS_IN_ACCUMULATOR
+#if NUM_ASCI_CHAINS > 1
+#define ASCI_CHAIN0_NUM_BMBS 4
+#define ASCI_CHAIN1_NUM_BMBS 3
+#define ASCI_CHAIN_NUM_BMBS { ASCI_CHAIN0_NUM_BMBS, ASCI_CHAIN1_NUM_BMBS }
+#define ASCI_CHAIN_TOTAL_NUM_BMBS (ASCI_CHAIN0_NUM_BMBS + ASCI_CHAIN1_NUM_BMBS)
+#else
+#define ASCI_CHAIN_NUM_BMBS { NUM_BMBS_IN_ACCUMULATOR }
+#define ASCI_CHAIN_TOTAL_NUM_BMBS NUM_BMBS_IN_ACCUMULATOR
+#endif
 // The number of read + write attempts we will do to verify the integrity of the data written
 #define NUM_DATA_CHECKS 3
 
 // Timeout
 #define TIMEOUT_SPI_COMPLETE_MS 10
+// Max time allowed for a single message in the ASCI transaction engine
+#define TIMEOUT_ASCI_MESSAGE_MS 10
+
+// Fastest SPI clock supported by the ASCI
+#define ASCI_MAX_SPI_CLOCK_HZ 4000000
+// SPI prescaler and keep-alive used until a calibrated link configuration is set. 0x05 = 160us keep-alive
+#define ASCI_DEFAULT_SPI_PRESCALER SPI_BAUDRATEPRESCALER_128
+#define ASCI_DEFAULT_KEEP_ALIVE 0x05
+
+// The max number of messages the ASCI transaction engine can process in one run
+#define ASCI_MESSAGE_QUEUE_SIZE 16
+// Number of ASCI load queues (L0-L6) messages can be preloaded into and sent back to back
+#define ASCI_NUM_LOAD_QUEUES 7
+// Size of the ASCI receive buffer. Limits how many responses can be drained together
+#define ASCI_RX_BUFFER_SIZE 62
+
+// Longest daisy chain supported. A readAll response of 5 bytes plus 2 bytes per BMB must fit in the
+// ASCI receive buffer, which limits a chain to 28 BMBs. Longer packs are split across ASCI chains
+#define MAX_BMBS_PER_CHAIN ((ASCI_RX_BUFFER_SIZE - 5) / 2)
+// Holds the read command byte plus a readAll response from the longest chain, rounded up to whole words
+#define SPI_BUFF_SIZE (((1 + 5 + (2 * MAX_BMBS_PER_CHAIN)) + 3) & ~3)
+
+// Number of log2 latency histogram buckets per ASCI command type. Bucket 0 holds latencies
+// under 1us and bucket n holds latencies in [2^(n-1), 2^n) us. The last bucket holds everything longer
+#define ASCI_LATENCY_HIST_BUCKETS 16
+
+// Record raw BMB command and response frames into a RAM ring buffer for offline analysis
+#ifndef ASCI_FRAME_CAPTURE
+#define ASCI_FRAME_CAPTURE 0
+#endif
+// Number of frames held by the frame capture ring buffer
+#ifndef ASCI_CAPTURE_NUM_FRAMES
+#define ASCI_CAPTURE_NUM_FRAMES 32
+#endif
+
+// Replace the ASCI and BMB daisy chains with the behavioural model in asciSim.c so the BMS can run
+// on a bare board. The host simulation build in test/sim sets this from the command line
+#ifndef ASCI_SIMULATION
+#define ASCI_SIMULATION 0
+#endif
+
+// Number of daisy chain positions link quality statistics are kept for
+#define LINK_STATS_MAX_BMBS MAX_BMBS_PER_CHAIN
+// Link error rates are exponentially weighted moving averages with a weight of 1/2^LINK_STATS_DECAY_SHIFT
+// per frame that reaches the BMB
+#define LINK_STATS_DECAY_SHIFT 5
+// Full scale link error rate. Every frame that reached the BMB was corrupted
+#define LINK_ERROR_RATE_FULL_SCALE 0xFFFF
+// Link error rate at which a BMB is reported as a suspect hop (~3%)
+#define LINK_SUSPECT_ERROR_RATE 0x0800
+
+// Default load queue verification policy and interval used by QUEUE_VERIFY_EVERY_NTH. Every load
+// queue is verified unless a caller opts in to a cheaper policy with setQueueVerifyPolicy
+#define DEFAULT_QUEUE_VERIFY_POLICY   QUEUE_VERIFY_ALWAYS
+#define DEFAULT_QUEUE_VERIFY_INTERVAL 8
 
 // REGISTERS
 #define R_RX_STATUS             (0x01 - 1)		// Non writable
@@ -73,10 +146,143 @@
 #define CMD_HELLO_ALL 		  0x57	      // Hello All Initialization
 
 
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+	QUEUE_VERIFY_ALWAYS = 0,	// Read back and verify the load queue on every transaction
+	QUEUE_VERIFY_EVERY_NTH,		// Verify the load queue on every Nth transaction
+	QUEUE_VERIFY_WHILE_ERRORS	// Verify the load queue only while the ASCI comms leaky bucket is not empty
+} Queue_Verify_Policy_E;
+
+typedef enum
+{
+	ASCI_FRAME_TX = 0,	// Command frame written to a load queue
+	ASCI_FRAME_RX		// Response frame read from the receive buffer, including the read command echo
+} Asci_Frame_Dir_E;
+
+typedef enum
+{
+	ASCI_CMD_READ_ALL = 0,
+	ASCI_CMD_READ_ALL_QUEUED,	// A whole readAllQueued call. Latency covers every queued read
+	ASCI_CMD_WRITE_ALL,
+	ASCI_CMD_READ_DEVICE,
+	ASCI_CMD_WRITE_DEVICE,
+	ASCI_CMD_HELLO_ALL,
+	NUM_ASCI_CMD_TYPES
+} Asci_Cmd_Type_E;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	uint32_t numTransfers;			// SPI transfers on the ASCI link
+	uint32_t numInterrupts;			// SPI1, SPI1 DMA and EXTI9_5 (ASCI INT, shared with ePaper BUSY) interrupts serviced
+	uint32_t isrCycles;				// CPU cycles spent servicing those interrupts
+	uint32_t numRuns;				// Number of ASCI transaction engine runs
+	uint32_t numBatches;			// Number of load queue batches sent by the transaction engine
+	uint32_t numQueueVerifies;		// Load queue read backs performed
+	uint32_t numQueueVerifiesSkipped;	// Load queue read backs skipped by the verification policy
+	uint32_t queueVerifyBytesSaved;	// SPI bytes not transferred due to skipped read backs
+	uint32_t numConfigWritesSkipped;	// Configuration register write and read backs skipped by the shadow cache
+	uint32_t lastUpdateTransfers;	// SPI transfers used to read out the most recent BMB data update
+	uint32_t lastUpdateCycles;		// Cycles used to read out the most recent BMB data update
+	uint32_t numBudgetsExhausted;	// Communication time budgets that ran out before the work completed
+	uint32_t lastBudgetUsedMs;		// Time used within the most recent communication time budget
+	uint32_t maxBudgetUsedMs;		// Worst case time used within a communication time budget
+	uint32_t numUnlocatedLinkErrors;	// Chain wide frames corrupted at an unknown daisy chain position
+
+	// Cost of the most recent ASCI transaction engine run. For a data update this is the whole scan read
+	uint32_t lastRunMessages;
+	uint32_t lastRunTransfers;
+	uint32_t lastRunInterrupts;
+	uint32_t lastRunIsrCycles;
+	uint32_t lastRunQueueVerifyBytesSaved;
+	uint32_t lastRunCycles;			// Cycles from the start of the run until the calling task resumed
+} Asci_Stats_S;
+
+typedef struct
+{
+	uint32_t numCalls;
+	uint32_t numFailures;				// Calls that failed after all retries
+	uint32_t numRetries;				// Attempts beyond the first
+	uint32_t numCrcErrors;				// Responses with a bad CRC or command echo
+	uint32_t numAliveCounterErrors;		// Responses with an unexpected alive-counter
+	uint32_t numTimeouts;				// Transaction engine runs that timed out
+	uint32_t numBudgetAborts;			// Calls abandoned because the communication time budget ran out. Not included in the other counters
+	uint32_t maxLatencyUs;
+	uint32_t latencyHist[ASCI_LATENCY_HIST_BUCKETS];	// Call latency including retries
+} Asci_Cmd_Stats_S;
+
+typedef struct
+{
+	uint32_t timestampMs;
+	uint8_t  direction;				// Asci_Frame_Dir_E
+	uint8_t  length;
+	uint8_t  data[SPI_BUFF_SIZE];
+} Asci_Frame_S;
+
+typedef struct
+{
+	bool     enabled;				// Frames are only recorded while enabled
+	uint32_t head;					// Index the next frame is written to
+	uint32_t numFrames;				// Number of valid frames, saturates at ASCI_CAPTURE_NUM_FRAMES
+	uint32_t numDropped;			// Frames overwritten since capture was enabled
+	Asci_Frame_S frames[ASCI_CAPTURE_NUM_FRAMES];
+} Asci_Frame_Capture_S;
+
+typedef struct
+{
+	uint32_t spiPrescaler;	// ASCI SPI baud rate prescaler (SPI_BAUDRATEPRESCALER_x)
+	uint8_t  keepAlive;		// R_CONFIG_3 keep-alive setting
+} Asci_Link_Config_S;
+
+typedef struct
+{
+	uint32_t numFrames;					// Frames known to have reached the BMB
+	uint32_t numCrcErrors;				// Frames addressed to the BMB with a bad CRC or command echo
+	uint32_t numAliveCounterShortfalls;	// Frames the BMB did not process
+	uint32_t numVersionMismatches;		// VERSION reads that returned an unexpected model number
+	uint16_t errorRate;					// Decaying error rate. LINK_ERROR_RATE_FULL_SCALE if every frame failed
+} Bmb_Link_Stats_S;
+
+typedef struct
+{
+	uint8_t  address;	// BMB register address to read from
+	uint8_t* data_p;	// Array to read in the data to
+	bool     success;	// Set by readAllQueued if the read succeeded
+} ReadAllRequest_S;
+
+typedef struct
+{
+	uint8_t  (*data_p)[SPI_BUFF_SIZE];	// Buffers to read the data of the chain in to, one per register
+	bool*    success_p;					// Set with the result of each register read. May be NULL
+	uint32_t numBmbs;					// The number of BMBs on the chain. Chains without BMBs are skipped
+} Chain_Block_Read_S;
+
+
 /* ==================================================================== */
 /* =================== GLOBAL FUNCTION DECLARATIONS =================== */
 /* ==================================================================== */
 
+/*!
+  @brief   Select the ASCI daisy chain that all following ASCI and BMB commands are sent on.
+		   BMB indexes passed to those commands are positions on the selected chain
+  @param   chainIdx - The index of the chain to select
+*/
+void selectAsciChain(uint32_t chainIdx);
+
+/*!
+  @brief   Get the ASCI daisy chain that commands are currently sent on
+  @return  The index of the selected chain
+*/
+uint32_t getAsciChain();
+
 /*!
   @brief   Power on ASCI
 */
@@ -109,6 +315,37 @@ void clearTxBuffer();
 */
 bool initASCI();
 
+/*!
+  @brief   Resynchronize with the ASCI without power cycling it. Clears the ASCI buffers and
+		   rewrites the operating configuration written by initASCI
+  @return  True if successful resynchronization, false otherwise
+*/
+bool resyncASCI();
+
+/*!
+  @brief   Set the SPI clock and keep-alive used on the ASCI link. The SPI clock is changed
+		   immediately. The keep-alive is written by the next initASCI or resyncASCI
+  @param   config - The link configuration to use
+  @return  True if the configuration was set, false if the SPI clock is too fast for the ASCI
+		   or a transaction is in progress
+*/
+bool setAsciLinkConfig(const Asci_Link_Config_S* config);
+
+/*!
+  @brief   Get the SPI clock and keep-alive currently used on the ASCI link
+  @param   config - Updated with the current link configuration
+*/
+void getAsciLinkConfig(Asci_Link_Config_S* config);
+
+/*!
+  @brief   Estimate the time the SPI bus of the selected chain is busy for a readAllBlock at the
+		   current SPI clock. Time spent waiting on the daisy chain is not included
+  @param   numRegisters - The number of registers read
+  @param   numBmbs - The number of BMBs on the chain
+  @return  The estimated transfer time in us
+*/
+uint32_t estimateReadAllBlockUs(uint32_t numRegisters, uint32_t numBmbs);
+
 /*!
   @brief   Initialize BMB Daisy Chain. Enumerate BMBs
   @param   numBmbs - The number of BMBs detected in the daisy chain
@@ -125,6 +362,19 @@ bool helloAll(uint32_t* numBmbs);
 */
 bool writeAll(uint8_t address, uint16_t value, uint32_t numBmbs);
 
+/*!
+  @brief   Write data to a list of registers on all BMBs without retrying. The writes are
+		   loaded into the ASCI load queues and sent back to back in a single transaction
+		   engine run. Echo and alive-counter errors are counted but not retried, so drift
+		   must be caught by reading the registers back later
+  @param   addresses - Array of BMB register addresses to write to, in the order to write them
+  @param   values - Array of values to write, one per address
+  @param   numWrites - The number of registers to write. Limited to ASCI_MESSAGE_QUEUE_SIZE
+  @param   numBmbs - The number of BMBs we expect to write to
+  @return  True if every write was echoed correctly, false otherwise
+*/
+bool writeAllUnverified(const uint8_t* addresses, const uint16_t* values, uint32_t numWrites, uint32_t numBmbs);
+
 /*!
   @brief   Write data to a register on single a BMB
   @param   address - BMB register address to write to
@@ -152,4 +402,152 @@ bool readAll(uint8_t address, uint8_t *data_p, uint32_t numBmbs);
 */
 bool readDevice(uint8_t address, uint8_t *data_p, uint32_t bmbIndex);
 
+/*!
+  @brief   Read data from multiple registers on all BMBs. All reads are queued in the ASCI
+		   transaction engine and run back to back in the background, blocking the calling
+		   task only once. Reads are batched across the ASCI load queues when the receive
+		   buffer can hold several responses. Any read that fails is retried with readAll
+  @param   requests - Array of registers to read and buffers to read the data in to. Each
+		   buffer must be able to hold the read command byte plus a full readAll message
+  @param   numRequests - The number of requests in the array
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if all reads succeeded, false otherwise
+*/
+bool readAllQueued(ReadAllRequest_S* requests, uint32_t numRequests, uint32_t numBmbs);
+
+/*!
+  @brief   Read data from a list of registers on all BMBs. Up to ASCI_NUM_LOAD_QUEUES reads are
+		   preloaded into the ASCI load queues, sent back to back and drained from the receive
+		   buffer together. Any read that fails is retried with readAll
+  @param   addresses - Array of BMB register addresses to read from
+  @param   numAddresses - The number of registers to read
+  @param   data_p - Array of buffers to read the data in to, one per address. Each buffer must
+		   be able to hold the read command byte plus a full readAll message
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if all reads succeeded, false otherwise
+*/
+bool readAllBatch(const uint8_t* addresses, uint32_t numAddresses, uint8_t** data_p, uint32_t numBmbs);
+
+/*!
+  @brief   Read data from a contiguous range of registers on all BMBs. The MAX17823 has no
+		   block read command so the range is read with batched readAll commands queued in
+		   the ASCI transaction engine. Any read that fails is retried with readAll
+  @param   startAddress - The first BMB register address to read from
+  @param   numRegisters - The number of consecutive registers to read
+  @param   data_p - Array of buffers to read the data in to, one per register. Each buffer holds
+		   the read command byte followed by the readAll message for that register
+  @param   success_p - Array set with the result of each register read. May be NULL
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if all reads succeeded, false otherwise
+*/
+bool readAllBlock(uint8_t startAddress, uint32_t numRegisters, uint8_t (*data_p)[SPI_BUFF_SIZE], bool* success_p, uint32_t numBmbs);
+
+/*!
+  @brief   Read data from a contiguous range of registers on all BMBs of every ASCI daisy chain.
+		   The chains are read concurrently, each by its own transaction engine, so the readout
+		   takes as long as the longest chain. Any read that fails is retried with readAll on its
+		   chain. Leaves the last chain read selected
+  @param   startAddress - The first BMB register address to read from
+  @param   numRegisters - The number of consecutive registers to read
+  @param   reads - Array of buffers and BMB counts, one per chain. See readAllBlock
+  @return  True if all reads on all chains succeeded, false otherwise
+*/
+bool readAllBlockChains(uint8_t startAddress, uint32_t numRegisters, Chain_Block_Read_S* reads);
+
+/*!
+  @brief   Set the policy used to decide when the ASCI load queue is read back and verified
+		   after being written. BMB frames carry a CRC and alive-counter so a corrupted load
+		   queue is still detected when verification is skipped. A load following a failed
+		   verify is always verified. Defaults to DEFAULT_QUEUE_VERIFY_POLICY
+  @param   policy - The verification policy to use
+  @param   interval - Verify every interval transactions. Only used by QUEUE_VERIFY_EVERY_NTH
+*/
+void setQueueVerifyPolicy(Queue_Verify_Policy_E policy, uint32_t interval);
+
+/*!
+  @brief   Start a communication time budget shared by every BMB command and retry. Once the
+		   budget is spent commands fail without being sent so that the caller can abort cleanly
+  @param   budgetMs - The time allowed for all communication until endCommsBudget is called
+*/
+void startCommsBudget(uint32_t budgetMs);
+
+/*!
+  @brief   End the current communication time budget and record how much of it was used
+  @return  True if the budget was exhausted, false otherwise
+*/
+bool endCommsBudget();
+
+/*!
+  @brief   Record a VERSION read that returned an unexpected model number against the link
+		   statistics of a BMB on the selected chain
+  @param   bmbIdx - The daisy chain position of the BMB, as used by readDevice
+*/
+void recordBmbVersionMismatch(uint32_t bmbIdx);
+
+/*!
+  @brief   Find the BMB on the selected chain with the worst link error rate, if it is high enough to be suspect. An
+		   alive-counter shortfall is charged to the first BMB that did not process the frame, so
+		   the suspect is the BMB at the far end of the failing hop
+  @param   numBmbs - The number of BMBs in the daisy chain
+  @return  The daisy chain position of the suspect BMB, -1 if no link is suspect
+*/
+int32_t getSuspectBmbLink(uint32_t numBmbs);
+
+/*!
+  @brief   Clear the link statistics of all BMBs on all chains. Should be called after a harness or BMB is replaced
+*/
+void resetBmbLinkStats();
+
+/*!
+  @brief   Start or stop recording BMB frames into the frame capture ring buffer. Starting a
+		   capture clears the buffer. Only available when ASCI_FRAME_CAPTURE is set
+  @param   enabled - True to start recording, false to stop and keep the captured frames
+*/
+void setAsciFrameCapture(bool enabled);
+
+/*!
+  @brief   Determine whether an SPI bus has an ASCI on it
+  @param   hspi - The SPI handle to check
+  @return  True if the SPI bus belongs to an ASCI daisy chain, false otherwise
+*/
+bool isAsciSpi(SPI_HandleTypeDef* hspi);
+
+/*!
+  @brief   Determine whether a GPIO pin is the INT pin of an ASCI
+  @param   pin - The GPIO pin to check
+  @return  True if the pin is an ASCI INT pin, false otherwise
+*/
+bool isAsciInterruptPin(uint16_t pin);
+
+/*!
+  @brief   Handle an SPI transfer completion for the ASCI transaction engine. Should be called
+		   from the SPI TX/RX complete callback
+  @param   hspi - The SPI handle the transfer completed on
+  @return  True if the transfer belonged to a transaction engine, false otherwise
+*/
+bool asciSpiCompleteCallback(SPI_HandleTypeDef* hspi);
+
+/*!
+  @brief   Handle an SPI transfer error for the ASCI transaction engine. Should be called
+		   from the SPI error callback
+  @param   hspi - The SPI handle the error occured on
+  @return  True if the transfer belonged to a transaction engine, false otherwise
+*/
+bool asciSpiErrorCallback(SPI_HandleTypeDef* hspi);
+
+/*!
+  @brief   Handle the ASCI external interrupt for the ASCI transaction engine. Should be called
+		   from the GPIO EXTI callback for the ASCI INT pins
+  @param   pin - The GPIO pin that triggered the interrupt
+  @return  True if the interrupt was consumed by a transaction engine, false otherwise
+*/
+bool asciInterruptCallback(uint16_t pin);
+
+/*!
+  @brief   Record an interrupt serviced on the ASCI link. Should be called at the end of the
+		   SPI1, SPI1 DMA and ASCI EXTI interrupt handlers
+  @param   startCycles - DWT cycle count sampled at the start of the interrupt handler
+*/
+void updateAsciIsrStats(uint32_t startCycles);
+
 #endif /* INC_BMBINTERFACE_H_ */
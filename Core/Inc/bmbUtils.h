@@ -18,7 +18,7 @@
 typedef struct
 {
 	int brickIdx;
-	float brickV;
+	uint16_t brickVCode;
 } Brick_S;
 
 
@@ -14,6 +14,8 @@
 #include "shared.h"
 #include "main.h"
 #include "bmb.h"
+#include "bmbInterface.h"
+#include "bmsRecovery.h"
 #include "imd.h"
 #include "soc.h"
 
@@ -21,8 +23,14 @@
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
 
-// The number of BMBs in the accumulator
+// The number of BMBs in the accumulator. The BMBs found by helloAll must match
 #define NUM_BMBS_IN_ACCUMULATOR				7 
+// The most BMBs the firmware can hold data for. Per BMB arrays are sized to this
+#define MAX_BMBS_IN_ACCUMULATOR				32
+#if NUM_BMBS_IN_ACCUMULATOR > MAX_BMBS_IN_ACCUMULATOR
+#error "NUM_BMBS_IN_ACCUMULATOR exceeds MAX_BMBS_IN_ACCUMULATOR"
+#endif
+_Static_assert(ASCI_CHAIN_TOTAL_NUM_BMBS == NUM_BMBS_IN_ACCUMULATOR, "ASCI_CHAIN_NUM_BMBS must add up to NUM_BMBS_IN_ACCUMULATOR");
 
 // Max allowable voltage difference between bricks for balancing
 #define BALANCE_THRESHOLD_V					0.001f
@@ -39,6 +47,36 @@
 // The delay between consecutive bmb updates
 #define VOLTAGE_DATA_UPDATE_PERIOD_MS		50
 
+// The delay between reads of the BMB hardware brick alerts. Much shorter than a scan readout
+#define BMB_ALERT_POLL_PERIOD_MS			5
+
+// The delay between targeted diagnostic reads of a BMB with a suspect daisy chain link
+#define BMB_LINK_DIAGNOSTIC_PERIOD_MS		1000
+
+// Calibrate the ASCI SPI clock and keep-alive after the pack is first initialized and store the
+// result in flash. Only enable for a maintenance build - the calibration takes several seconds
+#define ASCI_LINK_CALIBRATION				0
+// Scan readouts run at each calibration step and to confirm the selected configuration
+#define LINK_CAL_SCANS_PER_STEP				20
+#define LINK_CAL_CONFIRM_SCANS				100
+
+// Measure scan readout, aggregation and alert monitoring time for every pack size up to
+// MAX_BMBS_IN_ACCUMULATOR after the pack is first initialized. Only enable for a maintenance build
+#define PACK_SCALING_BENCHMARK				0
+// Runs averaged for each pack size
+#define PACK_BENCHMARK_ITERATIONS			100
+
+// Tractive current magnitude above which scans switch to the fast acquisition profile, and below
+// which they return to the precise profile. The gap keeps the profile from chattering
+#define ACQ_FAST_PROFILE_CURRENT_A			50.0f
+#define ACQ_PRECISE_PROFILE_CURRENT_A		10.0f
+
+// Measure the scan latency and brick voltage noise of every acquisition profile after the pack is
+// first initialized. Only enable for a maintenance build - run with the pack at rest
+#define ACQ_PROFILE_BENCHMARK				0
+// Scan readouts run for each acquisition profile
+#define ACQ_BENCHMARK_SCANS					200
+
 // Gophercan variable logging frequency. This value will be divided by the number of transactions
 // Frequency cannot exceed HW CONFIG max logging frequency
 #define GOPHER_CAN_LOGGING_FREQUENCY_HZ		1
@@ -69,6 +107,9 @@ typedef enum
 	NUM_GCAN_STATES
 } Gcan_State_E;
 
+// The number of BMBs that have gophercan parameters
+#define NUM_GCAN_SEGMENTS	(GCAN_SEGMENT_7 + 1)
+
 // The delay between consecutive additions to gcan logging
 #define GOPHER_CAN_LOGGING_PERIOD_MS	(1000 / (GOPHER_CAN_LOGGING_FREQUENCY_HZ * NUM_GCAN_STATES))
 
@@ -79,10 +120,19 @@ typedef enum
 typedef struct Bms
 {
 	uint32_t numBmbs;
-	Bmb_S bmb[NUM_BMBS_IN_ACCUMULATOR];
+	// The BMBs found on each ASCI daisy chain. The BMBs of each chain follow those of the previous chain in bmb
+	uint32_t chainNumBmbs[NUM_ASCI_CHAINS];
+	Bmb_S bmb[MAX_BMBS_IN_ACCUMULATOR];
 
 	float accumulatorVoltage;
 
+	// Brick voltage extremes as codes. Alerts compare these against thresholds converted with BRICK_V_TO_CODE
+	uint16_t maxBrickVCode;
+	uint16_t minBrickVCode;
+	// A brick is over or under the BMB hardware alert thresholds. Updated by the alert poll
+	bool hwOvFaultPresent;
+	bool hwUvFaultPresent;
+
 	float maxBrickV;
 	float minBrickV;
 	float avgBrickV;
@@ -116,6 +166,7 @@ typedef struct Bms
 	bool amsFaultStatus;
 
 	Bms_Hardware_State_E bmsHwState;
+	Recovery_State_S recovery;
 
 	bool chargerConnected;
 	Charger_Data_S chargerData;
@@ -126,12 +177,46 @@ typedef struct Bms
 /* =================== GLOBAL FUNCTION DECLARATIONS =================== */
 /* ==================================================================== */
 /*!
-  @brief   Initialization function for the battery pack
-  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @brief   Initialization function for the battery pack. Every ASCI daisy chain is initialized
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
   @returns bool True if initialization successful, false otherwise
 */
 bool initBatteryPack(uint32_t* numBmbs);
 
+/*!
+  @brief   Recover the battery pack after a BMB communication failure. A soft resync is tried
+		   first, then a configuration rewrite of only the BMBs that were reset, and a full
+		   initialization of the battery pack only as a last resort
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @returns bool True if the pack recovered, false otherwise
+*/
+bool recoverBatteryPack(uint32_t* numBmbs);
+
+/*!
+  @brief   Find the fastest ASCI SPI clock and keep-alive that read out scans without errors and
+		   store it in flash. The clock is backed off one step if a faster or equal clock saw
+		   errors. The previous configuration is restored if no configuration passes. All daisy
+		   chains share the configuration
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @returns bool True if a configuration was selected and stored, false otherwise
+*/
+bool calibrateAsciLink(const uint32_t* chainNumBmbs);
+
+/*!
+  @brief   Measure how the time spent on a scan readout, pack data aggregation and alert
+		   monitoring scales with the number of BMBs. The results are printed for every pack
+		   size up to MAX_BMBS_IN_ACCUMULATOR. Scan readout time is estimated from the bytes
+		   received at the current ASCI SPI clock
+*/
+void runPackScalingBenchmark();
+
+/*!
+  @brief   Measure the scan latency and the brick voltage noise of the first BMB with every
+		   acquisition profile. The results are printed as a table. Noise is estimated from the
+		   difference of successive samples so the pack must be at rest
+*/
+void runAcqProfileBenchmark();
+
 void initBmsGopherCan(CAN_HandleTypeDef* hcan);
 
 /*!
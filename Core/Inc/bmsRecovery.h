@@ -0,0 +1,98 @@
+#ifndef INC_BMSRECOVERY_H_
+#define INC_BMSRECOVERY_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bmb.h"
+
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+	RECOVERY_SOFT_RESYNC = 0,	// Resynchronize the ASCI and re-enumerate the chain
+	RECOVERY_BMB_REINIT,		// Additionally rewrite the configuration of BMBs that were reset
+	RECOVERY_COLD_INIT,			// Power cycle the ASCI and fully reinitialize the pack
+	NUM_RECOVERY_TIERS
+} Recovery_Tier_E;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	uint32_t numRecoveries[NUM_RECOVERY_TIERS];		// Successful recoveries completed by each tier
+	uint32_t lastBlackoutMs[NUM_RECOVERY_TIERS];	// Time from the BMB failure until recovery completed
+	uint32_t maxBlackoutMs[NUM_RECOVERY_TIERS];
+} Recovery_Stats_S;
+
+typedef struct
+{
+	bool inProgress;			// A BMB communication failure has not been recovered from yet
+	uint32_t startTick;			// Tick of the first recovery attempt after the failure
+	bool coldInitRequired;		// Warm recovery failed. Only a full initialization is tried until one succeeds
+	Recovery_Stats_S stats;
+} Recovery_State_S;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Initialize the BMBs on the selected ASCI daisy chain. A chain break is located if the
+		   chain can not be initialized
+  @param   expectedNumBmbs - The expected number of BMBs in the daisy chain
+  @param   bmb - The array containing BMB data of the selected daisy chain
+  @param   numBmbs - Updated with the number of BMBs found in the daisy chain
+  @returns bool True if initialization successful, false otherwise
+*/
+bool initBmbChain(uint32_t expectedNumBmbs, Bmb_S* bmb, uint32_t* numBmbs);
+
+/*!
+  @brief   Restore communication with the BMBs on the selected ASCI daisy chain without power
+		   cycling the ASCI. Only BMBs that were reset have their configuration rewritten
+  @param   expectedNumBmbs - The expected number of BMBs in the daisy chain
+  @param   bmb - The array containing BMB data of the selected daisy chain
+  @param   numBmbs - Updated with the number of BMBs found in the daisy chain
+  @param   tier - Updated with the recovery tier that was required
+  @returns bool True if the chain recovered, false otherwise
+*/
+bool recoverBmbChain(uint32_t expectedNumBmbs, Bmb_S* bmb, uint32_t* numBmbs, Recovery_Tier_E* tier);
+
+/*!
+  @brief   Initialize the BMBs on every ASCI daisy chain. Chains expected to have no BMBs are skipped
+  @param   expectedChainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - Updated with the number of BMBs found on each daisy chain
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @returns bool True if every chain initialized, false otherwise
+*/
+bool initBmbChains(const uint32_t* expectedChainNumBmbs, Bmb_S* bmb, uint32_t* chainNumBmbs, uint32_t* numBmbs);
+
+/*!
+  @brief   Recover every ASCI daisy chain after a BMB communication failure. A soft resync is
+		   tried first, then a configuration rewrite of only the BMBs that were reset. Once a
+		   warm recovery fails, only a full initialization is tried. The time the pack went
+		   unmonitored is recorded against the highest tier any chain required. Chains expected
+		   to have no BMBs are skipped
+  @param   recovery - The recovery state, kept across attempts until the pack recovers
+  @param   expectedChainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - Updated with the number of BMBs found on each daisy chain
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @param   tier - Updated with the recovery tier that was required
+  @returns bool True if the pack recovered, false otherwise
+*/
+bool recoverBmbChains(Recovery_State_S* recovery, const uint32_t* expectedChainNumBmbs, Bmb_S* bmb,
+					  uint32_t* chainNumBmbs, uint32_t* numBmbs, Recovery_Tier_E* tier);
+
+#endif /* INC_BMSRECOVERY_H_ */
@@ -23,5 +23,7 @@ typedef struct
 
 float lookup(float x, const LookupTable_S* table);
 
+float reverseLookup(float y, const LookupTable_S* table);
+
 
 #endif /* INC_LOOKUPTABLE_H_ */
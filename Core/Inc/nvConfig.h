@@ -0,0 +1,60 @@
+#ifndef INC_NVCONFIG_H_
+#define INC_NVCONFIG_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bmbInterface.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// The last flash sector (128K at 0x08060000) is reserved for the configuration. See STM32F446RETX_FLASH.ld
+#define NV_CONFIG_SECTOR	FLASH_SECTOR_7
+#define NV_CONFIG_ADDRESS	0x08060000UL
+
+// Identifies a stored configuration. Bump the version whenever Nv_Config_S changes layout
+#define NV_CONFIG_MAGIC		0x4E564346UL
+#define NV_CONFIG_VERSION	1
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// Configuration kept in flash across power cycles
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	Asci_Link_Config_S asciLink;	// ASCI SPI clock and keep-alive found by the link calibration
+	uint32_t checksum;				// Checksum of all preceding bytes
+} Nv_Config_S;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Load the configuration stored in flash
+  @param   config - Updated with the stored configuration
+  @return  True if a valid configuration was stored, false otherwise
+*/
+bool loadNvConfig(Nv_Config_S* config);
+
+/*!
+  @brief   Store a configuration in flash. Erasing the sector stalls the CPU for up to 2s so this
+		   must not be called while the car is running
+  @param   config - The configuration to store. The magic, version and checksum are filled in
+  @return  True if the configuration was stored and verified, false otherwise
+*/
+bool saveNvConfig(Nv_Config_S* config);
+
+
+#endif /* INC_NVCONFIG_H_ */
@@ -13,29 +13,29 @@
 
 static bool overvoltageWarningPresent(Bms_S* bms)
 {
-    return (bms->maxBrickV > MAX_BRICK_WARNING_VOLTAGE);
+    return (bms->maxBrickVCode > BRICK_V_TO_CODE(MAX_BRICK_WARNING_VOLTAGE));
 }
 
 static bool overvoltageFaultPresent(Bms_S* bms)
 {
-    return (bms->maxBrickV > MAX_BRICK_FAULT_VOLTAGE);
+    return (bms->maxBrickVCode > BRICK_V_TO_CODE(MAX_BRICK_FAULT_VOLTAGE)) || bms->hwOvFaultPresent;
 }
 
 static bool undervoltageWarningPresent(Bms_S* bms)
 {
-    return (bms->minBrickV < MIN_BRICK_WARNING_VOLTAGE);
+    return (bms->minBrickVCode < BRICK_V_TO_CODE(MIN_BRICK_WARNING_VOLTAGE));
 }
 
 static bool undervoltageFaultPresent(Bms_S* bms)
 {
-    return (bms->minBrickV < MIN_BRICK_FAULT_VOLTAGE);
+    return (bms->minBrickVCode < BRICK_V_TO_CODE(MIN_BRICK_FAULT_VOLTAGE)) || bms->hwUvFaultPresent;
 }
 
 static bool cellImbalancePresent(Bms_S* bms)
 {
-    const float maxCellImbalanceV = bms->maxBrickV - bms->minBrickV;
+    const int32_t maxCellImbalanceCode = (int32_t)bms->maxBrickVCode - (int32_t)bms->minBrickVCode;
 
-    return (maxCellImbalanceV > MAX_CELL_IMBALANCE_V);
+    return (maxCellImbalanceCode > BRICK_V_TO_CODE(MAX_CELL_IMBALANCE_V));
 }
 
 static bool overtemperatureWarningPresent(Bms_S* bms)
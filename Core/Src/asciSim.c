@@ -0,0 +1,1360 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <string.h>
+#include <math.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "asciSim.h"
+#include "bms.h"
+#include "bmb.h"
+#include "bmbInterface.h"
+#include "lookupTable.h"
+
+#if ASCI_SIMULATION
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// ASCI register bits
+#define RX_STATUS_EMPTY				0x01
+#define RX_STATUS_STOP				0x02
+#define RX_STATUS_BUSY				0x20
+#define RX_FLAG_STOP				0x02
+#define RX_FLAG_OVERFLOW			0x08
+#define RX_FLAG_BUSY				0x20
+#define CONFIG_2_TX_PREAMBLES		0x20
+// ASCI registers R_RX_STATUS through R_RX_SPACE are modelled. Indexed by address / 2
+#define NUM_ASCI_REGISTERS			((R_RX_SPACE >> 1) + 1)
+// Holds the data length byte and the longest command frame
+#define LOAD_QUEUE_SIZE				8
+// Responses held in the receive buffer at once
+#define RX_MAX_MESSAGES				ASCI_MESSAGE_QUEUE_SIZE
+
+// BMB commands. Device commands carry the BMB address in [7:3]
+#define BMB_DEVICE_CMD_MASK			0x07
+#define BMB_WRITE_DEVICE			0x04
+#define BMB_READ_DEVICE				0x05
+// Set in the data check byte by a BMB that received a frame with a bad PEC
+#define DATA_CHECK_PEC_ERROR		0x80
+
+// BMB registers 0x00 (VERSION) through 0x43 (UVTHSET) are modelled
+#define NUM_BMB_REGISTERS			0x44
+#define VERSION_RESET_VALUE			0x8430
+#define DEVCFG1_RESET_VALUE			0x1002
+#define DEVCFG1_ENABLE_ALIVE_COUNTER	0x0040
+#define DEVCFG2_LASTLOOP			0x8000
+#define SCANCTRL_START_SCAN			0x0001
+#define SCANCTRL_OVERSAMPLES_MASK	0x0070
+#define SCANCTRL_OVERSAMPLES_SHIFT	4
+#define SCANCTRL_ENABLE_AUTOBALSWDIS	0x0800
+#define SCANCTRL_DATARDY			0x2000
+#define SCANCTRL_SCANDONE			0x8000
+#define MEASUREEN_BRICK_CHANNELS	0x0FFF
+#define MEASUREEN_VBLOCK_CHANNEL	0xC000
+#define MEASUREEN_AIN1_CHANNEL		0x1000
+#define MEASUREEN_AIN2_CHANNEL		0x2000
+#define ACQCFG_SETTLING_TIME_MASK	0x003F
+#define AUTOBALSWDIS_TIME_MASK		0x003F
+#define GPIO_MUX_SELECT_MASK		0x0007
+
+// Daisy chain UART timing. Characters are 12 bits at 2Mbps and each hop delays a frame by a few
+// bit times. Frames are preceded by a preamble character
+#define UART_CHAR_TIME_NS			6000
+#define UART_HOP_DELAY_NS			1500
+
+// Scan timing of the MAX17823 model
+#define SCAN_CONVERSION_TIME_US		10
+#define ACQCFG_SETTLING_LSB_US		6
+#define AUTOBALSWDIS_LSB_US			96
+
+// Measurement ranges
+#define BRICK_FULL_SCALE_MV			5000
+#define VBLOCK_FULL_SCALE_MV		60000
+#define AIN_FULL_SCALE_V			3.3f
+#define MAX_14_BIT					0x3FFF
+#define MAX_12_BIT					0x0FFF
+
+// Mux channels 1-6 select brick temperatures, 7 and 8 the board temperatures
+#define NUM_BRICK_TEMP_MUX_CHANNELS	(NUM_BRICKS_PER_BMB / 2)
+
+// Default pack. Bricks are spread by a few mV so balancing has something to do
+#define DEFAULT_BRICK_MV			3700
+#define DEFAULT_BRICK_SPREAD_MV		20
+#define DEFAULT_BRICK_TEMP_DECI_C	250
+#define DEFAULT_BOARD_TEMP_DECI_C	300
+
+// Completions and interrupts waiting to be delivered. Each chain has at most one transfer and
+// one interrupt outstanding
+#define SIM_EVENT_QUEUE_SIZE		(4 * NUM_ASCI_CHAINS)
+
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+	SIM_EVENT_TX_COMPLETE = 0,	// Transmit only transfer completed
+	SIM_EVENT_TX_RX_COMPLETE,	// Transmit and receive transfer completed
+	SIM_EVENT_INTERRUPT			// ASCI INT asserted
+} Sim_Event_Type_E;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	uint16_t registers[NUM_BMB_REGISTERS];
+	uint8_t  address;								// Daisy chain address assigned by HELLOALL
+
+	uint16_t brickmV[NUM_BRICKS_PER_BMB];
+	int16_t  brickTempDeciC[NUM_BRICKS_PER_BMB];
+	int16_t  boardTempDeciC[NUM_BOARD_TEMP_PER_BMB];
+
+	bool     scanInProgress;
+	uint32_t scanStartTick;
+	uint32_t scanDurationMs;
+	uint8_t  scanMux;								// Mux channel selected when the scan started
+	uint32_t scanNumOversamples;					// Samples averaged into each measurement of the scan
+
+	uint32_t bitErrorPeriod;						// Corrupt every Nth frame crossing the hop into this BMB
+	uint32_t bitErrorCount;
+} Sim_Bmb_S;
+
+typedef struct
+{
+	SPI_HandleTypeDef* hspi;
+	uint16_t intPin;
+	bool     attached;
+	bool     powered;
+
+	uint8_t  registers[NUM_ASCI_REGISTERS];
+	uint8_t  rxFlags;
+	bool     rxBusy;
+	bool     rxStop;
+	bool     intAsserted;
+
+	uint8_t  loadQueues[ASCI_NUM_LOAD_QUEUES][LOAD_QUEUE_SIZE];
+	uint8_t  loadQueueLengths[ASCI_NUM_LOAD_QUEUES];	// Bytes written to each queue including the data length byte
+
+	uint8_t  rxBuffer[ASCI_RX_BUFFER_SIZE];
+	uint8_t  rxMessageLengths[RX_MAX_MESSAGES];
+	uint32_t rxNumMessages;
+	uint32_t rxNumBytes;
+
+	uint32_t numBmbs;
+	int32_t  brokenHop;								// Hop frames can not cross, -1 if the chain is intact
+	bool     externalLoopback;
+	Sim_Bmb_S bmbs[ASCI_SIM_MAX_BMBS];
+} Sim_Chain_S;
+
+typedef struct
+{
+	Sim_Event_Type_E type;
+	Sim_Chain_S* chain;								// NULL if the event was cancelled
+	uint32_t dueCycles;								// DWT cycle count the event would occur at on the real bus
+} Sim_Event_S;
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern LookupTable_S ntcTable;
+extern LookupTable_S zenerTable;
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+// The BMBs expected by the BMS on each chain
+static const uint32_t defaultChainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+static Sim_Chain_S simChains[NUM_ASCI_CHAINS];
+static uint32_t scanTimeDivisor = 1;
+static SimReturnFrameHook returnFrameHook = NULL;
+
+// Brick voltage noise of a single sample. Oversampling averages it down
+static float measurementNoiseUv = 0.0f;
+static uint32_t noiseState = 1;
+
+static Sim_Event_S simEvents[SIM_EVENT_QUEUE_SIZE];
+static uint32_t simEventHead = 0;
+static uint32_t simNumEvents = 0;
+
+
+/* ==================================================================== */
+/* ======================== GLOBAL VARIABLES ========================== */
+/* ==================================================================== */
+
+Asci_Sim_Stats_S asciSimStats;
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Find the simulated chain an SPI bus is connected to
+  @param   hspi - The SPI handle
+  @return  The simulated chain, NULL if no chain is attached to the SPI bus
+*/
+static Sim_Chain_S* findSimChain(SPI_HandleTypeDef* hspi);
+
+/*!
+  @brief   Queue a completion or interrupt for delivery from the simulation interrupt
+  @param   chain - The simulated chain the event belongs to
+  @param   type - The type of event
+  @param   dueCycles - The DWT cycle count the event would occur at on the real bus
+*/
+static void pushSimEvent(Sim_Chain_S* chain, Sim_Event_Type_E type, uint32_t dueCycles);
+
+/*!
+  @brief   Convert a modelled bus time to DWT cycles
+  @param   timeNs - The time in ns
+  @return  The number of core clock cycles
+*/
+static uint32_t simNsToCycles(uint64_t timeNs);
+
+/*!
+  @brief   Calculate the time an SPI transfer with the simulated ASCI takes on the bus
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   size - The number of bytes in the transfer
+  @return  The transfer time in ns
+*/
+static uint64_t calcSimSpiTimeNs(SPI_HandleTypeDef* hspi, uint16_t size);
+
+/*!
+  @brief   Take the oldest event off the event queue
+  @param   event - Updated with the oldest event
+  @return  True if an event was taken, false if the queue is empty
+*/
+static bool popSimEvent(Sim_Event_S* event);
+
+/*!
+  @brief   Calculate the CRC used by the BMBs over a set of bytes
+  @param   bytes - The bytes to calculate the CRC of
+  @param   numBytes - The number of bytes
+  @return  The calculated CRC
+*/
+static uint8_t calcSimCrc(const uint8_t* bytes, uint32_t numBytes);
+
+/*!
+  @brief   Draw a sample of approximately normal noise. The sum of 12 uniform samples has a
+		   variance of 1
+  @return  A sample with a mean of 0 and a standard deviation of 1
+*/
+static float simNormalNoise(void);
+
+/*!
+  @brief   Return a simulated BMB to its power-on state
+  @param   bmb - The simulated BMB
+*/
+static void resetSimBmb(Sim_Bmb_S* bmb);
+
+/*!
+  @brief   Latch the measurement registers of a simulated BMB once its scan has completed
+  @param   bmb - The simulated BMB
+*/
+static void updateSimScan(Sim_Bmb_S* bmb);
+
+/*!
+  @brief   Start a scan on a simulated BMB. The duration follows the programmed oversampling,
+		   settling time, channels and balance switch recovery time
+  @param   bmb - The simulated BMB
+*/
+static void startSimScan(Sim_Bmb_S* bmb);
+
+/*!
+  @brief   Read a register of a simulated BMB
+  @param   bmb - The simulated BMB
+  @param   address - The register address
+  @return  The register contents
+*/
+static uint16_t readSimBmbRegister(Sim_Bmb_S* bmb, uint8_t address);
+
+/*!
+  @brief   Write a register of a simulated BMB
+  @param   bmb - The simulated BMB
+  @param   address - The register address
+  @param   value - The value to write
+*/
+static void writeSimBmbRegister(Sim_Bmb_S* bmb, uint8_t address, uint16_t value);
+
+/*!
+  @brief   Process a frame passing through a simulated BMB
+  @param   bmb - The simulated BMB
+  @param   frame - The frame. Updated with the data and alive-counter added by the BMB
+  @param   length - The number of bytes in the frame. Updated if the BMB added data
+*/
+static void processSimBmbFrame(Sim_Bmb_S* bmb, uint8_t* frame, uint32_t* length);
+
+/*!
+  @brief   Send a frame down a simulated daisy chain
+  @param   chain - The simulated chain
+  @param   frame - The frame. Updated with the frame returned to the ASCI
+  @param   length - The number of bytes in the frame. Updated with the length of the returned frame
+  @return  True if the frame returned to the ASCI, false if it was lost
+*/
+static bool runSimChainFrame(Sim_Chain_S* chain, uint8_t* frame, uint32_t* length);
+
+/*!
+  @brief   Determine whether frames sent down a simulated chain can return to the ASCI
+  @param   chain - The simulated chain
+  @return  True if the chain is closed by a loopback before any broken hop, false otherwise
+*/
+static bool simChainClosed(Sim_Chain_S* chain);
+
+/*!
+  @brief   Release a load queue of the simulated ASCI onto its daisy chain
+  @param   chain - The simulated chain
+  @param   queueIdx - The load queue to send
+  @return  The time the frame takes to travel the daisy chain in ns, 0 if no frame was sent
+*/
+static uint32_t sendSimLoadQueue(Sim_Chain_S* chain, uint32_t queueIdx);
+
+/*!
+  @brief   Read a register of the simulated ASCI
+  @param   chain - The simulated chain
+  @param   address - The register write address
+  @return  The register contents
+*/
+static uint8_t readSimAsciRegister(Sim_Chain_S* chain, uint8_t address);
+
+/*!
+  @brief   Write a register of the simulated ASCI
+  @param   chain - The simulated chain
+  @param   address - The register write address
+  @param   value - The value to write
+*/
+static void writeSimAsciRegister(Sim_Chain_S* chain, uint8_t address, uint8_t value);
+
+/*!
+  @brief   Run the command of an SPI transfer on the simulated ASCI
+  @param   chain - The simulated chain
+  @param   txData - The bytes sent to the ASCI
+  @param   rxData - Updated with the bytes received from the ASCI. NULL for a transmit only transfer
+  @param   size - The number of bytes in the transfer
+  @return  The time a frame released by the transfer takes to travel the daisy chain in ns, 0 if
+		   no frame was released
+*/
+static uint32_t runSimAsciTransfer(Sim_Chain_S* chain, const uint8_t* txData, uint8_t* rxData, uint16_t size);
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Find the simulated chain an SPI bus is connected to
+  @param   hspi - The SPI handle
+  @return  The simulated chain, NULL if no chain is attached to the SPI bus
+*/
+static Sim_Chain_S* findSimChain(SPI_HandleTypeDef* hspi)
+{
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (simChains[chainIdx].attached && (simChains[chainIdx].hspi == hspi))
+		{
+			return &simChains[chainIdx];
+		}
+	}
+	return NULL;
+}
+
+/*!
+  @brief   Queue a completion or interrupt for delivery from the simulation interrupt
+  @param   chain - The simulated chain the event belongs to
+  @param   type - The type of event
+  @param   dueCycles - The DWT cycle count the event would occur at on the real bus
+*/
+static void pushSimEvent(Sim_Chain_S* chain, Sim_Event_Type_E type, uint32_t dueCycles)
+{
+	// Events are queued from the main task and from the simulation interrupt itself
+	const UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	if (simNumEvents < SIM_EVENT_QUEUE_SIZE)
+	{
+		Sim_Event_S* event = &simEvents[(simEventHead + simNumEvents) % SIM_EVENT_QUEUE_SIZE];
+		event->type = type;
+		event->chain = chain;
+		event->dueCycles = dueCycles;
+		simNumEvents++;
+	}
+	else
+	{
+		asciSimStats.numEventsDropped++;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+
+	HAL_NVIC_SetPendingIRQ(ASCI_SIM_IRQn);
+}
+
+/*!
+  @brief   Take the oldest event off the event queue
+  @param   event - Updated with the oldest event
+  @return  True if an event was taken, false if the queue is empty
+*/
+static bool popSimEvent(Sim_Event_S* event)
+{
+	bool eventTaken = false;
+	const UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	if (simNumEvents > 0)
+	{
+		*event = simEvents[simEventHead];
+		simEventHead = (simEventHead + 1) % SIM_EVENT_QUEUE_SIZE;
+		simNumEvents--;
+		eventTaken = true;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+	return eventTaken;
+}
+
+/*!
+  @brief   Convert a modelled bus time to DWT cycles
+  @param   timeNs - The time in ns
+  @return  The number of core clock cycles
+*/
+static uint32_t simNsToCycles(uint64_t timeNs)
+{
+	return (uint32_t)((timeNs * (SystemCoreClock / 1000000)) / 1000);
+}
+
+/*!
+  @brief   Calculate the time an SPI transfer with the simulated ASCI takes on the bus
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   size - The number of bytes in the transfer
+  @return  The transfer time in ns
+*/
+static uint64_t calcSimSpiTimeNs(SPI_HandleTypeDef* hspi, uint16_t size)
+{
+	// SPI1 and SPI4 are clocked from APB2, the others from APB1. BR divides the bus clock by 2^(BR + 1)
+	const SPI_TypeDef* spi = hspi->Instance;
+	const uint32_t pclkHz = ((spi == SPI1) || (spi == SPI4)) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+	const uint32_t spiClockHz = pclkHz / (2UL << ((hspi->Init.BaudRatePrescaler & SPI_CR1_BR) >> SPI_CR1_BR_Pos));
+	return (spiClockHz > 0) ? (((uint64_t)size * 8 * 1000000000ULL) / spiClockHz) : 0;
+}
+
+/*!
+  @brief   Calculate the CRC used by the BMBs over a set of bytes
+  @param   bytes - The bytes to calculate the CRC of
+  @param   numBytes - The number of bytes
+  @return  The calculated CRC
+*/
+static uint8_t calcSimCrc(const uint8_t* bytes, uint32_t numBytes)
+{
+	// Bitwise form of the reflected CRC-8 (0xB2) used by bmbInterface
+	uint8_t crc = 0x00;
+	for (uint32_t i = 0; i < numBytes; i++)
+	{
+		crc ^= bytes[i];
+		for (int32_t j = 0; j < 8; j++)
+		{
+			crc = (crc & 0x01) ? ((crc >> 1) ^ 0xB2) : (crc >> 1);
+		}
+	}
+	return crc;
+}
+
+/*!
+  @brief   Draw a sample of approximately normal noise. The sum of 12 uniform samples has a
+		   variance of 1
+  @return  A sample with a mean of 0 and a standard deviation of 1
+*/
+static float simNormalNoise(void)
+{
+	float sum = 0.0f;
+	for (int32_t i = 0; i < 12; i++)
+	{
+		// xorshift32
+		noiseState ^= noiseState << 13;
+		noiseState ^= noiseState >> 17;
+		noiseState ^= noiseState << 5;
+		sum += (float)noiseState / 4294967296.0f;
+	}
+	return sum - 6.0f;
+}
+
+/*!
+  @brief   Return a simulated BMB to its power-on state
+  @param   bmb - The simulated BMB
+*/
+static void resetSimBmb(Sim_Bmb_S* bmb)
+{
+	memset(bmb->registers, 0, sizeof(bmb->registers));
+	bmb->registers[VERSION] = VERSION_RESET_VALUE;
+	bmb->registers[ADDRESS] = bmb->address;
+	bmb->registers[STATUS] = ALRTRST;
+	bmb->registers[DEVCFG1] = DEVCFG1_RESET_VALUE;
+	bmb->scanInProgress = false;
+}
+
+/*!
+  @brief   Latch the measurement registers of a simulated BMB once its scan has completed
+  @param   bmb - The simulated BMB
+*/
+static void updateSimScan(Sim_Bmb_S* bmb)
+{
+	if (!bmb->scanInProgress || ((HAL_GetTick() - bmb->scanStartTick) < bmb->scanDurationMs))
+	{
+		return;
+	}
+	bmb->scanInProgress = false;
+
+	// Brick and block voltages in [15:2]. Brick noise averages down with the oversamples
+	const float brickNoiseMv = measurementNoiseUv / 1000.0f / sqrtf((float)bmb->scanNumOversamples);
+	uint32_t blockmV = 0;
+	for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+	{
+		uint32_t code = (bmb->brickmV[i] * (MAX_14_BIT + 1)) / BRICK_FULL_SCALE_MV;
+		if (brickNoiseMv > 0.0f)
+		{
+			const float brickmV = bmb->brickmV[i] + (brickNoiseMv * simNormalNoise());
+			code = (brickmV > 0.0f) ? (uint32_t)((brickmV * (MAX_14_BIT + 1)) / BRICK_FULL_SCALE_MV) : 0;
+		}
+		code = (code > MAX_14_BIT) ? MAX_14_BIT : code;
+		bmb->registers[CELLn + i] = code << 2;
+		blockmV += bmb->brickmV[i];
+	}
+	// MINMAXCELL points at the first brick with the highest and the first with the lowest code
+	uint32_t maxBrick = 0;
+	uint32_t minBrick = 0;
+	for (uint32_t i = 1; i < NUM_BRICKS_PER_BMB; i++)
+	{
+		maxBrick = (bmb->registers[CELLn + i] > bmb->registers[CELLn + maxBrick]) ? i : maxBrick;
+		minBrick = (bmb->registers[CELLn + i] < bmb->registers[CELLn + minBrick]) ? i : minBrick;
+	}
+	bmb->registers[MINMAXCELL] = (maxBrick << MINMAXCELL_MAX_SHIFT) | minBrick;
+	// Brick alerts follow the thresholds in [15:2] with the hysteresis of the set and clear levels
+	for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+	{
+		const uint16_t brick = 1 << i;
+		const uint16_t code = bmb->registers[CELLn + i] >> 2;
+		if (!(bmb->registers[ALRTOVEN] & brick) || (code < (bmb->registers[OVTHCLR] >> 2)))
+		{
+			bmb->registers[ALRTOVCELL] &= ~brick;
+		}
+		else if (code >= (bmb->registers[OVTHSET] >> 2))
+		{
+			bmb->registers[ALRTOVCELL] |= brick;
+		}
+		if (!(bmb->registers[ALRTUVEN] & brick) || (code > (bmb->registers[UVTHCLR] >> 2)))
+		{
+			bmb->registers[ALRTUVCELL] &= ~brick;
+		}
+		else if (code <= (bmb->registers[UVTHSET] >> 2))
+		{
+			bmb->registers[ALRTUVCELL] |= brick;
+		}
+	}
+
+	uint32_t blockCode = (blockmV * (MAX_14_BIT + 1)) / VBLOCK_FULL_SCALE_MV;
+	blockCode = (blockCode > MAX_14_BIT) ? MAX_14_BIT : blockCode;
+	bmb->registers[VBLOCK] = blockCode << 2;
+
+	// The mux selects which temperature sensors are on AIN1 and AIN2. Mux channels 1-6 select bricks
+	// n and n + 6. Channel 7 selects NTC2 and NTC1, channel 8 NTC4 and NTC3. See decodeScanData
+	float ain1V = 0.0f;
+	float ain2V = 0.0f;
+	if (bmb->scanMux < NUM_BRICK_TEMP_MUX_CHANNELS)
+	{
+		ain1V = reverseLookup(bmb->brickTempDeciC[bmb->scanMux] / 10.0f, &zenerTable);
+		ain2V = reverseLookup(bmb->brickTempDeciC[bmb->scanMux + NUM_BRICK_TEMP_MUX_CHANNELS] / 10.0f, &zenerTable);
+	}
+	else
+	{
+		const uint32_t ntcIdx = (bmb->scanMux == MUX7) ? 0 : 2;
+		ain1V = reverseLookup(bmb->boardTempDeciC[ntcIdx + 1] / 10.0f, &ntcTable);
+		ain2V = reverseLookup(bmb->boardTempDeciC[ntcIdx] / 10.0f, &ntcTable);
+	}
+
+	// AIN voltages in [15:4]
+	uint32_t ain1Code = (uint32_t)((ain1V / AIN_FULL_SCALE_V) * (MAX_12_BIT + 1));
+	uint32_t ain2Code = (uint32_t)((ain2V / AIN_FULL_SCALE_V) * (MAX_12_BIT + 1));
+	bmb->registers[AIN1] = ((ain1Code > MAX_12_BIT) ? MAX_12_BIT : ain1Code) << 4;
+	bmb->registers[AIN2] = ((ain2Code > MAX_12_BIT) ? MAX_12_BIT : ain2Code) << 4;
+}
+
+/*!
+  @brief   Start a scan on a simulated BMB. The duration follows the programmed oversampling,
+		   settling time, channels and balance switch recovery time
+  @param   bmb - The simulated BMB
+*/
+static void startSimScan(Sim_Bmb_S* bmb)
+{
+	const uint16_t scanCtrl = bmb->registers[SCANCTRL];
+	const uint16_t measureEn = bmb->registers[MEASUREEN];
+
+	// OVSAMPL of 0 is a single sample, otherwise 2^(OVSAMPL + 1) samples
+	const uint32_t ovsampl = (scanCtrl & SCANCTRL_OVERSAMPLES_MASK) >> SCANCTRL_OVERSAMPLES_SHIFT;
+	const uint32_t numOversamples = (ovsampl == 0) ? 1 : (1UL << (ovsampl + 1));
+	const uint32_t numChannels = __builtin_popcount(measureEn & MEASUREEN_BRICK_CHANNELS) +
+								 ((measureEn & MEASUREEN_VBLOCK_CHANNEL) ? 1 : 0) +
+								 ((measureEn & MEASUREEN_AIN1_CHANNEL) ? 1 : 0) +
+								 ((measureEn & MEASUREEN_AIN2_CHANNEL) ? 1 : 0);
+
+	uint32_t scanTimeUs = ((bmb->registers[ACQCFG] & ACQCFG_SETTLING_TIME_MASK) * ACQCFG_SETTLING_LSB_US) +
+						  (numOversamples * numChannels * SCAN_CONVERSION_TIME_US);
+	if (scanCtrl & SCANCTRL_ENABLE_AUTOBALSWDIS)
+	{
+		scanTimeUs += (bmb->registers[AUTOBALSWDIS] & AUTOBALSWDIS_TIME_MASK) * AUTOBALSWDIS_LSB_US;
+	}
+
+	bmb->scanInProgress = true;
+	bmb->scanStartTick = HAL_GetTick();
+	bmb->scanDurationMs = ((scanTimeUs / scanTimeDivisor) + 999) / 1000;
+	bmb->scanMux = bmb->registers[GPIO] & GPIO_MUX_SELECT_MASK;
+	bmb->scanNumOversamples = numOversamples;
+	bmb->registers[SCANCTRL] &= ~(SCANCTRL_SCANDONE | SCANCTRL_DATARDY);
+	asciSimStats.numScans++;
+}
+
+/*!
+  @brief   Read a register of a simulated BMB
+  @param   bmb - The simulated BMB
+  @param   address - The register address
+  @return  The register contents
+*/
+static uint16_t readSimBmbRegister(Sim_Bmb_S* bmb, uint8_t address)
+{
+	if (address >= NUM_BMB_REGISTERS)
+	{
+		return 0x0000;
+	}
+
+	updateSimScan(bmb);
+	if (address == SCANCTRL)
+	{
+		const uint16_t scanStatus = bmb->scanInProgress ? 0x0000 : (SCANCTRL_SCANDONE | SCANCTRL_DATARDY);
+		return (bmb->registers[SCANCTRL] & ~(SCANCTRL_SCANDONE | SCANCTRL_DATARDY)) | scanStatus;
+	}
+	return bmb->registers[address];
+}
+
+/*!
+  @brief   Write a register of a simulated BMB
+  @param   bmb - The simulated BMB
+  @param   address - The register address
+  @param   value - The value to write
+*/
+static void writeSimBmbRegister(Sim_Bmb_S* bmb, uint8_t address, uint16_t value)
+{
+	switch (address)
+	{
+		case VERSION:
+		case ADDRESS:
+			// Read only
+			break;
+
+		case SCANCTRL:
+			updateSimScan(bmb);
+			bmb->registers[SCANCTRL] = value & ~(SCANCTRL_START_SCAN | SCANCTRL_SCANDONE | SCANCTRL_DATARDY);
+			if (value & SCANCTRL_START_SCAN)
+			{
+				startSimScan(bmb);
+			}
+			break;
+
+		default:
+			if (address < NUM_BMB_REGISTERS)
+			{
+				bmb->registers[address] = value;
+			}
+			break;
+	}
+}
+
+/*!
+  @brief   Process a frame passing through a simulated BMB
+  @param   bmb - The simulated BMB
+  @param   frame - The frame. Updated with the data and alive-counter added by the BMB
+  @param   length - The number of bytes in the frame. Updated if the BMB added data
+*/
+static void processSimBmbFrame(Sim_Bmb_S* bmb, uint8_t* frame, uint32_t* length)
+{
+	const uint8_t command = frame[0];
+	if (command == CMD_HELLO_ALL)
+	{
+		// Take the address in the frame and pass the next address on
+		if (*length >= 3)
+		{
+			bmb->address = frame[2];
+			bmb->registers[ADDRESS] = bmb->address;
+			frame[2]++;
+		}
+		return;
+	}
+
+	// Every other frame ends in DATA_CHECK (reads only), PEC and ALIVE_COUNTER
+	if (*length < 5)
+	{
+		return;
+	}
+	const uint8_t address = frame[1];
+	const bool pecValid = (calcSimCrc(frame, *length - 2) == frame[*length - 2]);
+	// The alive-counter setting in effect before a write to DEVCFG1 applies to this frame
+	const bool aliveCounterEnabled = (bmb->registers[DEVCFG1] & DEVCFG1_ENABLE_ALIVE_COUNTER) != 0;
+
+	const bool deviceCommand = (command & BMB_DEVICE_CMD_MASK) >= BMB_WRITE_DEVICE;
+	const bool addressed = !deviceCommand || ((command >> 3) == bmb->address);
+	if (!addressed)
+	{
+		return;
+	}
+
+	const bool writeCommand = (command == CMD_WRITE_ALL) || (deviceCommand && ((command & BMB_DEVICE_CMD_MASK) == BMB_WRITE_DEVICE));
+	const bool readCommand = (command == CMD_READ_ALL) || (deviceCommand && ((command & BMB_DEVICE_CMD_MASK) == BMB_READ_DEVICE));
+	if (writeCommand)
+	{
+		// Corrupted writes are not executed. The echo is checked by the BMS
+		if (pecValid)
+		{
+			writeSimBmbRegister(bmb, address, frame[2] | (frame[3] << 8));
+		}
+	}
+	else if (readCommand)
+	{
+		if (*length + 2 > SPI_BUFF_SIZE)
+		{
+			return;
+		}
+
+		// The register contents are inserted after the register address, ahead of the data of
+		// the BMBs before this one
+		const uint16_t value = readSimBmbRegister(bmb, address);
+		memmove(&frame[4], &frame[2], *length - 2);
+		frame[2] = (uint8_t)(value & 0x00FF);
+		frame[3] = (uint8_t)(value >> 8);
+		*length += 2;
+
+		// A BMB that received a bad PEC flags it and can not pass on a valid PEC
+		if (!pecValid)
+		{
+			frame[*length - 3] |= DATA_CHECK_PEC_ERROR;
+		}
+		const uint8_t pec = calcSimCrc(frame, *length - 2);
+		frame[*length - 2] = pecValid ? pec : (uint8_t)~pec;
+	}
+	else
+	{
+		return;
+	}
+
+	if (aliveCounterEnabled)
+	{
+		frame[*length - 1]++;
+	}
+}
+
+/*!
+  @brief   Send a frame down a simulated daisy chain
+  @param   chain - The simulated chain
+  @param   frame - The frame. Updated with the frame returned to the ASCI
+  @param   length - The number of bytes in the frame. Updated with the length of the returned frame
+  @return  True if the frame returned to the ASCI, false if it was lost
+*/
+static bool runSimChainFrame(Sim_Chain_S* chain, uint8_t* frame, uint32_t* length)
+{
+	for (int32_t i = 0; i < (int32_t)chain->numBmbs; i++)
+	{
+		if (chain->brokenHop == i)
+		{
+			return false;
+		}
+
+		Sim_Bmb_S* bmb = &chain->bmbs[i];
+		if ((bmb->bitErrorPeriod > 0) && (++bmb->bitErrorCount >= bmb->bitErrorPeriod))
+		{
+			// Walk the corrupted bit through the frame so every field is hit over time
+			bmb->bitErrorCount = 0;
+			const uint32_t bitIdx = asciSimStats.numBitErrors % (*length * 8);
+			frame[bitIdx / 8] ^= (1 << (bitIdx % 8));
+			asciSimStats.numBitErrors++;
+		}
+
+		processSimBmbFrame(bmb, frame, length);
+		if (bmb->registers[DEVCFG2] & DEVCFG2_LASTLOOP)
+		{
+			return true;
+		}
+	}
+	return chain->externalLoopback && (chain->brokenHop != (int32_t)chain->numBmbs);
+}
+
+/*!
+  @brief   Determine whether frames sent down a simulated chain can return to the ASCI
+  @param   chain - The simulated chain
+  @return  True if the chain is closed by a loopback before any broken hop, false otherwise
+*/
+static bool simChainClosed(Sim_Chain_S* chain)
+{
+	for (int32_t i = 0; i < (int32_t)chain->numBmbs; i++)
+	{
+		if (chain->brokenHop == i)
+		{
+			return false;
+		}
+		if (chain->bmbs[i].registers[DEVCFG2] & DEVCFG2_LASTLOOP)
+		{
+			return true;
+		}
+	}
+	return chain->externalLoopback && (chain->brokenHop != (int32_t)chain->numBmbs);
+}
+
+/*!
+  @brief   Release a load queue of the simulated ASCI onto its daisy chain
+  @param   chain - The simulated chain
+  @param   queueIdx - The load queue to send
+  @return  The time the frame takes to travel the daisy chain in ns, 0 if no frame was sent
+*/
+static uint32_t sendSimLoadQueue(Sim_Chain_S* chain, uint32_t queueIdx)
+{
+	if (chain->loadQueueLengths[queueIdx] < 2)
+	{
+		return 0;
+	}
+
+	// The data length byte is not sent on the daisy chain
+	uint8_t frame[SPI_BUFF_SIZE];
+	uint32_t length = chain->loadQueueLengths[queueIdx] - 1;
+	memcpy(frame, &chain->loadQueues[queueIdx][1], length);
+	asciSimStats.numFramesSent++;
+
+	// The frame grows by the data added at each BMB. It has fully returned once its last character
+	// has passed every hop
+	const bool frameReturned = runSimChainFrame(chain, frame, &length);
+	if (frameReturned && (returnFrameHook != NULL))
+	{
+		returnFrameHook(chain - simChains, frame, &length);
+		length = (length < SPI_BUFF_SIZE) ? length : SPI_BUFF_SIZE;
+	}
+	const uint32_t frameTimeNs = ((1 + length) * UART_CHAR_TIME_NS) + ((chain->numBmbs + 1) * UART_HOP_DELAY_NS);
+	if (!frameReturned)
+	{
+		asciSimStats.numFramesLost++;
+		return frameTimeNs;
+	}
+
+	if ((chain->rxNumMessages >= RX_MAX_MESSAGES) || (chain->rxNumBytes + length > ASCI_RX_BUFFER_SIZE))
+	{
+		chain->rxFlags |= RX_FLAG_OVERFLOW;
+		asciSimStats.numRxOverflows++;
+		return frameTimeNs;
+	}
+	memcpy(&chain->rxBuffer[chain->rxNumBytes], frame, length);
+	chain->rxMessageLengths[chain->rxNumMessages] = length;
+	chain->rxNumMessages++;
+	chain->rxNumBytes += length;
+	chain->rxStop = true;
+	chain->rxFlags |= RX_FLAG_STOP;
+	asciSimStats.numFramesReturned++;
+	return frameTimeNs;
+}
+
+/*!
+  @brief   Read a register of the simulated ASCI
+  @param   chain - The simulated chain
+  @param   address - The register write address
+  @return  The register contents
+*/
+static uint8_t readSimAsciRegister(Sim_Chain_S* chain, uint8_t address)
+{
+	switch (address)
+	{
+		case R_RX_STATUS:
+			return ((chain->rxNumMessages == 0) ? RX_STATUS_EMPTY : 0x00) |
+				   (chain->rxStop ? RX_STATUS_STOP : 0x00) |
+				   (chain->rxBusy ? RX_STATUS_BUSY : 0x00);
+
+		case R_RX_INTERRUPT_FLAGS:
+			return chain->rxFlags;
+
+		case R_RX_SPACE:
+			return ASCI_RX_BUFFER_SIZE - chain->rxNumBytes;
+
+		default:
+			return ((address >> 1) < NUM_ASCI_REGISTERS) ? chain->registers[address >> 1] : 0x00;
+	}
+}
+
+/*!
+  @brief   Write a register of the simulated ASCI
+  @param   chain - The simulated chain
+  @param   address - The register write address
+  @param   value - The value to write
+*/
+static void writeSimAsciRegister(Sim_Chain_S* chain, uint8_t address, uint8_t value)
+{
+	switch (address)
+	{
+		case R_RX_INTERRUPT_FLAGS:
+			// Flags are cleared by writing 0
+			chain->rxFlags &= value;
+			break;
+
+		case R_CONFIG_2:
+			chain->registers[address >> 1] = value;
+			// Preambles are only received back once the daisy chain is closed
+			chain->rxBusy = (value & CONFIG_2_TX_PREAMBLES) && simChainClosed(chain);
+			if (chain->rxBusy)
+			{
+				chain->rxFlags |= RX_FLAG_BUSY;
+			}
+			break;
+
+		case R_RX_INTERRUPT_ENABLE:
+		case R_TX_INTERRUPT_ENABLE:
+		case R_TX_INTERRUPT_FLAGS:
+		case R_CONFIG_1:
+		case R_CONFIG_3:
+			chain->registers[address >> 1] = value;
+			break;
+
+		default:
+			// Read only
+			break;
+	}
+}
+
+/*!
+  @brief   Run the command of an SPI transfer on the simulated ASCI
+  @param   chain - The simulated chain
+  @param   txData - The bytes sent to the ASCI
+  @param   rxData - Updated with the bytes received from the ASCI. NULL for a transmit only transfer
+  @param   size - The number of bytes in the transfer
+  @return  The time a frame released by the transfer takes to travel the daisy chain in ns, 0 if
+		   no frame was released
+*/
+static uint32_t runSimAsciTransfer(Sim_Chain_S* chain, const uint8_t* txData, uint8_t* rxData, uint16_t size)
+{
+	uint8_t rxDummy[SPI_BUFF_SIZE];
+	if ((rxData == NULL) || (rxData == txData))
+	{
+		// Transmit only transfers and loads sent in place are answered into a scratch buffer
+		rxData = rxDummy;
+		size = (size > SPI_BUFF_SIZE) ? SPI_BUFF_SIZE : size;
+	}
+	const uint8_t command = txData[0];
+	memset(rxData, 0, size);
+	if (!chain->powered || (size == 0))
+	{
+		return 0;
+	}
+
+	if (command == CMD_CLR_TX_BUF)
+	{
+		memset(chain->loadQueueLengths, 0, sizeof(chain->loadQueueLengths));
+	}
+	else if (command == CMD_CLR_RX_BUF)
+	{
+		chain->rxNumMessages = 0;
+		chain->rxNumBytes = 0;
+		chain->rxStop = false;
+	}
+	else if ((command == CMD_RD_NXT_MSG) || (command == CMD_RD_MSG))
+	{
+		// The first byte is clocked out while the command is received
+		if (chain->rxNumMessages > 0)
+		{
+			const uint32_t messageLength = chain->rxMessageLengths[0];
+			memcpy(&rxData[1], chain->rxBuffer, (messageLength < size - 1u) ? messageLength : (size - 1u));
+			if (command == CMD_RD_NXT_MSG)
+			{
+				memmove(chain->rxBuffer, &chain->rxBuffer[messageLength], chain->rxNumBytes - messageLength);
+				memmove(chain->rxMessageLengths, &chain->rxMessageLengths[1], chain->rxNumMessages - 1);
+				chain->rxNumBytes -= messageLength;
+				chain->rxNumMessages--;
+			}
+		}
+	}
+	else if ((command >= CMD_WR_NXT_LD_Q_L0) && (command <= CMD_WR_NXT_LD_Q_L6) && ((command & 0x01) == 0))
+	{
+		// Release the queue onto the daisy chain
+		return sendSimLoadQueue(chain, (command - CMD_WR_NXT_LD_Q_L0) >> 1);
+	}
+	else if ((command >= CMD_WR_LD_Q_L0) && (command <= CMD_RD_LD_Q_L6))
+	{
+		const uint32_t queueIdx = (command - CMD_WR_LD_Q_L0) >> 1;
+		if (command & 0x01)
+		{
+			// Read back the data length byte and frame
+			const uint32_t numQueueBytes = chain->loadQueueLengths[queueIdx];
+			memcpy(&rxData[1], chain->loadQueues[queueIdx], (numQueueBytes < size - 1u) ? numQueueBytes : (size - 1u));
+		}
+		else
+		{
+			const uint32_t numQueueBytes = ((size - 1) < LOAD_QUEUE_SIZE) ? (size - 1) : LOAD_QUEUE_SIZE;
+			memcpy(chain->loadQueues[queueIdx], &txData[1], numQueueBytes);
+			chain->loadQueueLengths[queueIdx] = numQueueBytes;
+		}
+	}
+	else if (command & 0x01)
+	{
+		// Register read. The read address is one greater than the write address
+		if (size >= 2)
+		{
+			rxData[1] = readSimAsciRegister(chain, command - 1);
+		}
+	}
+	else if (size >= 2)
+	{
+		writeSimAsciRegister(chain, command, txData[1]);
+	}
+	return 0;
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Connect an ASCI daisy chain to the model. The first time a chain is connected its
+		   BMBs are created with the pack expected by the BMS
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   intPin - The ASCI INT external interrupt pin
+*/
+void simAsciAttach(uint32_t chainIdx, SPI_HandleTypeDef* hspi, uint16_t intPin)
+{
+	if (chainIdx >= NUM_ASCI_CHAINS)
+	{
+		return;
+	}
+
+	Sim_Chain_S* chain = &simChains[chainIdx];
+	chain->hspi = hspi;
+	chain->intPin = intPin;
+	if (!chain->attached)
+	{
+		chain->brokenHop = -1;
+		chain->externalLoopback = false;
+		simSetNumBmbs(chainIdx, defaultChainNumBmbs[chainIdx]);
+		for (int32_t i = 0; i < (int32_t)chain->numBmbs; i++)
+		{
+			for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+			{
+				chain->bmbs[i].brickmV[j] = DEFAULT_BRICK_MV + (((i * NUM_BRICKS_PER_BMB) + j) * 7) % DEFAULT_BRICK_SPREAD_MV;
+				chain->bmbs[i].brickTempDeciC[j] = DEFAULT_BRICK_TEMP_DECI_C;
+			}
+			for (int32_t j = 0; j < NUM_BOARD_TEMP_PER_BMB; j++)
+			{
+				chain->bmbs[i].boardTempDeciC[j] = DEFAULT_BOARD_TEMP_DECI_C;
+			}
+		}
+
+		// Completions are delivered at the same priority as the SPI and EXTI interrupts
+		HAL_NVIC_SetPriority(ASCI_SIM_IRQn, 5, 0);
+		HAL_NVIC_EnableIRQ(ASCI_SIM_IRQn);
+		chain->attached = true;
+	}
+}
+
+/*!
+  @brief   Power the simulated ASCI on or off. Powering it on resets the ASCI registers and buffers
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   enabled - True to power on the ASCI, false to shut it down
+*/
+void simAsciSetPower(SPI_HandleTypeDef* hspi, bool enabled)
+{
+	Sim_Chain_S* chain = findSimChain(hspi);
+	if (chain == NULL)
+	{
+		return;
+	}
+
+	if (enabled && !chain->powered)
+	{
+		memset(chain->registers, 0, sizeof(chain->registers));
+		memset(chain->loadQueueLengths, 0, sizeof(chain->loadQueueLengths));
+		chain->rxFlags = 0;
+		chain->rxBusy = false;
+		chain->rxStop = false;
+		chain->rxNumMessages = 0;
+		chain->rxNumBytes = 0;
+		chain->intAsserted = false;
+	}
+	chain->powered = enabled;
+}
+
+/*!
+  @brief   Run an SPI transfer against the simulated ASCI. Received data is available on return.
+		   The transfer complete callback and any ASCI INT edge are delivered later from the
+		   simulation interrupt, the same way the SPI and EXTI interrupts would deliver them
+  @param   hspi - The SPI bus the ASCI is connected to
+  @param   txData - The bytes sent to the ASCI
+  @param   rxData - Updated with the bytes received from the ASCI. NULL for a transmit only transfer
+  @param   size - The number of bytes in the transfer
+  @return  HAL_OK if the transfer was accepted, HAL_ERROR otherwise
+*/
+HAL_StatusTypeDef simAsciTransmit(SPI_HandleTypeDef* hspi, const uint8_t* txData, uint8_t* rxData, uint16_t size)
+{
+	Sim_Chain_S* chain = findSimChain(hspi);
+	if (chain == NULL)
+	{
+		return HAL_ERROR;
+	}
+
+	// The transfer completes once every byte has been clocked out. A frame it releases onto the
+	// daisy chain raises INT once the frame has returned
+	asciSimStats.numTransfers++;
+	const uint32_t chainTimeNs = runSimAsciTransfer(chain, txData, rxData, size);
+	const uint32_t spiDoneCycles = DWT->CYCCNT + simNsToCycles(calcSimSpiTimeNs(hspi, size));
+	pushSimEvent(chain, (rxData == NULL) ? SIM_EVENT_TX_COMPLETE : SIM_EVENT_TX_RX_COMPLETE, spiDoneCycles);
+
+	// INT is active while any enabled RX interrupt flag is set. The EXTI triggers on the asserting edge
+	const bool intAsserted = chain->powered && ((chain->rxFlags & chain->registers[R_RX_INTERRUPT_ENABLE >> 1]) != 0);
+	if (intAsserted && !chain->intAsserted)
+	{
+		pushSimEvent(chain, SIM_EVENT_INTERRUPT, spiDoneCycles + simNsToCycles(chainTimeNs));
+	}
+	chain->intAsserted = intAsserted;
+	return HAL_OK;
+}
+
+/*!
+  @brief   Abort the transfer in progress on the simulated ASCI. Its completion callback is dropped
+  @param   hspi - The SPI bus the ASCI is connected to
+  @return  HAL_OK
+*/
+HAL_StatusTypeDef simAsciAbort(SPI_HandleTypeDef* hspi)
+{
+	const UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	for (uint32_t i = 0; i < simNumEvents; i++)
+	{
+		Sim_Event_S* event = &simEvents[(simEventHead + i) % SIM_EVENT_QUEUE_SIZE];
+		if ((event->chain != NULL) && (event->chain->hspi == hspi) && (event->type != SIM_EVENT_INTERRUPT))
+		{
+			event->chain = NULL;
+		}
+	}
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+	return HAL_OK;
+}
+
+/*!
+  @brief   Set the number of BMBs on a simulated daisy chain. New BMBs start powered on reset
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   numBmbs - The number of BMBs on the chain. Limited to ASCI_SIM_MAX_BMBS
+*/
+void simSetNumBmbs(uint32_t chainIdx, uint32_t numBmbs)
+{
+	if (chainIdx >= NUM_ASCI_CHAINS)
+	{
+		return;
+	}
+
+	Sim_Chain_S* chain = &simChains[chainIdx];
+	numBmbs = (numBmbs > ASCI_SIM_MAX_BMBS) ? ASCI_SIM_MAX_BMBS : numBmbs;
+	for (uint32_t i = chain->numBmbs; i < numBmbs; i++)
+	{
+		Sim_Bmb_S* bmb = &chain->bmbs[i];
+		memset(bmb, 0, sizeof(Sim_Bmb_S));
+		resetSimBmb(bmb);
+		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			bmb->brickmV[j] = DEFAULT_BRICK_MV;
+			bmb->brickTempDeciC[j] = DEFAULT_BRICK_TEMP_DECI_C;
+		}
+		for (int32_t j = 0; j < NUM_BOARD_TEMP_PER_BMB; j++)
+		{
+			bmb->boardTempDeciC[j] = DEFAULT_BOARD_TEMP_DECI_C;
+		}
+	}
+	chain->numBmbs = numBmbs;
+}
+
+/*!
+  @brief   Set the voltage of a simulated brick. Takes effect on the next scan
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   brickIdx - The brick on the BMB
+  @param   voltage - The brick voltage in V
+*/
+void simSetBrickVoltage(uint32_t chainIdx, uint32_t bmbIdx, uint32_t brickIdx, float voltage)
+{
+	if ((chainIdx < NUM_ASCI_CHAINS) && (bmbIdx < ASCI_SIM_MAX_BMBS) && (brickIdx < NUM_BRICKS_PER_BMB))
+	{
+		simChains[chainIdx].bmbs[bmbIdx].brickmV[brickIdx] = (voltage > 0.0f) ? (uint16_t)(voltage * 1000.0f) : 0;
+	}
+}
+
+/*!
+  @brief   Set the temperature of a simulated brick. Takes effect on the next scan of its mux channel
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   brickIdx - The brick on the BMB
+  @param   temp - The brick temperature in C
+*/
+void simSetBrickTemp(uint32_t chainIdx, uint32_t bmbIdx, uint32_t brickIdx, float temp)
+{
+	if ((chainIdx < NUM_ASCI_CHAINS) && (bmbIdx < ASCI_SIM_MAX_BMBS) && (brickIdx < NUM_BRICKS_PER_BMB))
+	{
+		simChains[chainIdx].bmbs[bmbIdx].brickTempDeciC[brickIdx] = (int16_t)(temp * 10.0f);
+	}
+}
+
+/*!
+  @brief   Set the temperature of a simulated BMB board temperature sensor. Takes effect on the next
+		   scan of its mux channel
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   sensorIdx - The board temperature sensor
+  @param   temp - The board temperature in C
+*/
+void simSetBoardTemp(uint32_t chainIdx, uint32_t bmbIdx, uint32_t sensorIdx, float temp)
+{
+	if ((chainIdx < NUM_ASCI_CHAINS) && (bmbIdx < ASCI_SIM_MAX_BMBS) && (sensorIdx < NUM_BOARD_TEMP_PER_BMB))
+	{
+		simChains[chainIdx].bmbs[bmbIdx].boardTempDeciC[sensorIdx] = (int16_t)(temp * 10.0f);
+	}
+}
+
+/*!
+  @brief   Shorten simulated scans to run the firmware faster than real time. The firmware scan
+		   prediction follows the shorter scans
+  @param   divisor - The scan duration is divided by this. 1 for real time
+*/
+void simSetScanTimeDivisor(uint32_t divisor)
+{
+	scanTimeDivisor = (divisor > 0) ? divisor : 1;
+}
+
+/*!
+  @brief   Corrupt a bit of every Nth frame crossing a hop of a simulated daisy chain
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   hopIdx - The hop into BMB hopIdx. Hop 0 is between the ASCI and the first BMB
+  @param   period - Corrupt one frame out of every period frames. 0 to stop injecting bit errors
+*/
+void simInjectBitErrors(uint32_t chainIdx, uint32_t hopIdx, uint32_t period)
+{
+	if ((chainIdx < NUM_ASCI_CHAINS) && (hopIdx < ASCI_SIM_MAX_BMBS))
+	{
+		simChains[chainIdx].bmbs[hopIdx].bitErrorPeriod = period;
+		simChains[chainIdx].bmbs[hopIdx].bitErrorCount = 0;
+	}
+}
+
+/*!
+  @brief   Break a hop of a simulated daisy chain. Frames can not cross a broken hop
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   hopIdx - The hop into BMB hopIdx. Hop numBmbs is the external loopback. -1 to repair the chain
+*/
+void simBreakHop(uint32_t chainIdx, int32_t hopIdx)
+{
+	if (chainIdx < NUM_ASCI_CHAINS)
+	{
+		simChains[chainIdx].brokenHop = hopIdx;
+	}
+}
+
+/*!
+  @brief   Connect or disconnect the external loopback at the end of a simulated daisy chain
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   connected - True if frames passing the last BMB return to the ASCI
+*/
+void simSetExternalLoopback(uint32_t chainIdx, bool connected)
+{
+	if (chainIdx < NUM_ASCI_CHAINS)
+	{
+		simChains[chainIdx].externalLoopback = connected;
+	}
+}
+
+/*!
+  @brief   Power-on reset a simulated BMB. Its registers return to their reset values and ALRTRST
+		   is set. The BMB keeps its daisy chain address
+  @param   chainIdx - The index of the ASCI daisy chain
+  @param   bmbIdx - The daisy chain position of the BMB
+*/
+void simPowerOnReset(uint32_t chainIdx, uint32_t bmbIdx)
+{
+	if ((chainIdx < NUM_ASCI_CHAINS) && (bmbIdx < simChains[chainIdx].numBmbs))
+	{
+		resetSimBmb(&simChains[chainIdx].bmbs[bmbIdx]);
+		asciSimStats.numPowerOnResets++;
+	}
+}
+
+/*!
+  @brief   Get the time until the oldest pending SPI completion or ASCI INT edge would occur on the
+		   real bus. Events are delivered as soon as the simulation interrupt runs, so only a host
+		   harness that keeps its own clock needs this to follow the bus timing
+  @return  The number of DWT cycles until the oldest event is due, 0 if it is due or none is pending
+*/
+uint32_t simPendingEventDelayCycles(void)
+{
+	uint32_t delayCycles = 0;
+	const UBaseType_t savedMask = taskENTER_CRITICAL_FROM_ISR();
+	if (simNumEvents > 0)
+	{
+		const int32_t remaining = (int32_t)(simEvents[simEventHead].dueCycles - DWT->CYCCNT);
+		delayCycles = (remaining > 0) ? (uint32_t)remaining : 0;
+	}
+	taskEXIT_CRITICAL_FROM_ISR(savedMask);
+	return delayCycles;
+}
+
+/*!
+  @brief   Add random noise to every sample of a simulated brick voltage. Oversampling averages
+		   it down by the square root of the number of samples
+  @param   noiseUv - The noise of a single sample in uV rms. 0 for noise free measurements
+*/
+void simSetMeasurementNoise(float noiseUv)
+{
+	measurementNoiseUv = (noiseUv > 0.0f) ? noiseUv : 0.0f;
+}
+
+/*!
+  @brief   Set a hook that can rewrite every frame returning to a simulated ASCI. Frames are
+		   rewritten after the BMBs have processed them, so the model still follows every command
+  @param   hook - The hook, NULL to return the frames built by the model
+*/
+void simSetReturnFrameHook(SimReturnFrameHook hook)
+{
+	returnFrameHook = hook;
+}
+
+/*!
+  @brief   Deliver the oldest simulated SPI completion or ASCI INT edge. One event is delivered
+		   per interrupt so the ASCI interrupt statistics count the same interrupts as hardware
+*/
+void ASCI_SIM_IRQHandler(void)
+{
+	const uint32_t startCycles = DWT->CYCCNT;
+	Sim_Event_S event;
+	if (popSimEvent(&event) && (event.chain != NULL))
+	{
+		switch (event.type)
+		{
+			case SIM_EVENT_TX_COMPLETE:
+				HAL_SPI_TxCpltCallback(event.chain->hspi);
+				break;
+
+			case SIM_EVENT_TX_RX_COMPLETE:
+				HAL_SPI_TxRxCpltCallback(event.chain->hspi);
+				break;
+
+			case SIM_EVENT_INTERRUPT:
+				HAL_GPIO_EXTI_Callback(event.chain->intPin);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	if (simNumEvents > 0)
+	{
+		HAL_NVIC_SetPendingIRQ(ASCI_SIM_IRQn);
+	}
+	updateAsciIsrStats(startCycles);
+}
+
+#endif /* ASCI_SIMULATION */
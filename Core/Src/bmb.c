@@ -8,6 +8,7 @@
 #include "bmbInterface.h"
 #include "bmbUtils.h"
 #include "packData.h"
+#include "cellData.h"
 #include "lookupTable.h"
 #include "debug.h"
 
@@ -28,20 +29,151 @@
 #define MEASUREEN_ENABLE_AIN2_CHANNEL	0x2000
 #define ACQCFG_THRM_ON					0x0300
 #define ACQCFG_MAX_SETTLING_TIME		0x003F
+#define ACQCFG_FAST_SETTLING_TIME		0x0010
 #define AUTOBALSWDIS_5MS_RECOVERY_TIME	0x0034
 #define DEVCFG2_LASTLOOP				0x8000
 #define SCANCTRL_START_SCAN				0x0001
 #define SCANCTRL_32_OVERSAMPLES			0x0040
+#define SCANCTRL_4_OVERSAMPLES			0x0010
 #define SCANCTRL_ENABLE_AUTOBALSWDIS	0x0800
 #define VERSION_DEFAULT_CONTENT			0x843
+#define GPIO_MUX_OUTPUTS_ENABLED		0xF000
+#define GPIO_MUX_SELECT_MASK			0x0007
+#define SCANCTRL_OVERSAMPLES_MASK		0x0070
+#define SCANCTRL_OVERSAMPLES_SHIFT		4
+#define SCANCTRL_SCANDONE				0x8000
+#define SCANCTRL_DATARDY				0x2000
+#define ACQCFG_SETTLING_TIME_MASK		0x003F
+
+// Scan duration model. A scan waits the AUTOBALSWDIS recovery time and the ACQCFG settling time,
+// then converts every enabled channel once per oversample. The figures are approximate - the
+// predicted duration is corrected at runtime from SCANDONE
+#define SCAN_RECOVERY_TIME_US			5000
+#define ACQCFG_SETTLING_LSB_US			6
+#define SCAN_CONVERSION_TIME_US			10
+// Number of scans in a row that must be done when predicted before the prediction is shortened by 1ms
+#define SCAN_PREDICTION_PROBE_COUNT		32
+
+// Configuration written to every BMB
+#define DEVCFG1_CONFIG					(DEVCFG1_DEFAULT_CONFIG | DEVCFG1_ENABLE_ALIVE_COUNTER)
+#define MEASUREEN_CONFIG				(MEASUREEN_ENABLE_BRICK_CHANNELS | MEASUREEN_ENABLE_VBLOCK_CHANNEL | MEASUREEN_ENABLE_AIN1_CHANNEL | MEASUREEN_ENABLE_AIN2_CHANNEL)
+#define ACQCFG_CONFIG					(ACQCFG_THRM_ON | ACQCFG_MAX_SETTLING_TIME)
+// Brick alert thresholds in [15:2]. Alerts set at the fault limits and clear at the warning limits
+#define OVTHSET_CONFIG					(BRICK_V_TO_CODE(MAX_BRICK_FAULT_VOLTAGE) << 2)
+#define OVTHCLR_CONFIG					(BRICK_V_TO_CODE(MAX_BRICK_WARNING_VOLTAGE) << 2)
+#define UVTHSET_CONFIG					(BRICK_V_TO_CODE(MIN_BRICK_FAULT_VOLTAGE) << 2)
+#define UVTHCLR_CONFIG					(BRICK_V_TO_CODE(MIN_BRICK_WARNING_VOLTAGE) << 2)
+#define ALRTEN_BRICK_CHANNELS			0x0FFF
+
+// Registers read back by the configuration audit
+#define NUM_AUDIT_REGISTERS				6
+
+// The measurement data registers CELLn through AIN2 are contiguous and read as a single block
+#define DATA_BLOCK_START				CELLn
+#define CELL_READ_IDX					(CELLn - DATA_BLOCK_START)
+#define VBLOCK_READ_IDX					(VBLOCK - DATA_BLOCK_START)
+#define AIN_READ_IDX					(AIN1 - DATA_BLOCK_START)
+#define NUM_DATA_READS					(AIN2 - DATA_BLOCK_START + 1)
+
+// The alert registers STATUS through ALRTUVCELL are read as a single block by the alert poll
+#define ALERT_BLOCK_START				STATUS
+#define STATUS_READ_IDX					(STATUS - ALERT_BLOCK_START)
+#define ALRTOVCELL_READ_IDX				(ALRTOVCELL - ALERT_BLOCK_START)
+#define ALRTUVCELL_READ_IDX				(ALRTUVCELL - ALERT_BLOCK_START)
+#define NUM_ALERT_READS					(ALRTUVCELL - ALERT_BLOCK_START + 1)
+
+// Longest repeating scan schedule
+#define MAX_SCAN_SCHEDULE_SLOTS			64
+// Times the scan plan is rebuilt with a longer slot period when a slot does not fit
+#define SCAN_PLAN_ATTEMPTS				4
+#define SCAN_PRODUCT_BIT(product)		(1UL << (product))
+#define SCAN_TEMP_PRODUCTS				(SCAN_PRODUCT_BIT(SCAN_BRICK_TEMP) | SCAN_PRODUCT_BIT(SCAN_BOARD_TEMP))
+#define SCAN_VOLTAGE_PRODUCTS			(SCAN_PRODUCT_BIT(SCAN_CELL_V) | SCAN_PRODUCT_BIT(SCAN_CELL_EXTREMES) | SCAN_PRODUCT_BIT(SCAN_SEGMENT_V))
+#define SCAN_MEASUREMENT_PRODUCTS		(SCAN_VOLTAGE_PRODUCTS | SCAN_TEMP_PRODUCTS)
+// Widest span of bricks read after MINMAXCELL by a cell extremes readout. Together with MINMAXCELL it reads
+// fewer registers than a full brick readout. The bricks are not read if the extremes span more
+#define CELL_EXTREMES_MAX_SPAN			(NUM_BRICKS_PER_BMB - 2)
+// Mux channels 1-6 select brick temperatures, 7 and 8 the board temperatures
+#define NUM_BRICK_TEMP_MUX_CHANNELS		(NUM_BRICKS_PER_BMB / 2)
+#define NUM_BOARD_TEMP_MUX_CHANNELS		(NUM_MUX_CHANNELS - NUM_BRICK_TEMP_MUX_CHANNELS)
+// VBLOCK and the cells are both 14 bit but VBLOCK has 12 times the range
+#define BRICK_CODES_PER_SEGMENT_CODE	12
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+// A slot of the repeating scan schedule
+typedef struct
+{
+	uint32_t products;			// Data products refreshed by the slot. See SCAN_PRODUCT_BIT
+	Mux_State_E muxState;		// Mux channel sampled by AIN1 and AIN2 if temperatures are refreshed
+	uint16_t measureEn;			// Channels measured by the scan
+	uint32_t firstRead;			// First data register read out, relative to DATA_BLOCK_START
+	uint32_t numReads;			// Number of consecutive data registers read out
+	uint32_t scanMs[NUM_ACQ_PROFILES];	// Estimated scan duration with each acquisition profile
+} Scan_Slot_S;
+
+// Register settings of an acquisition profile
+typedef struct
+{
+	uint16_t scanCtrl;			// Oversampling
+	uint16_t acqCfg;			// Settling time
+	uint16_t measureEn;			// Channels the profile measures. Slots only measure those they need
+} Acq_Profile_S;
 
 
 /* ==================================================================== */
 /* ========================= LOCAL VARIABLES ========================== */
 /* ==================================================================== */
 static Mux_State_E muxState = MUX1;
-static uint32_t lastUpdate = 0;
+static uint16_t measureEnState = MEASUREEN_CONFIG;
+static uint16_t scanCtrlState = SCANCTRL_32_OVERSAMPLES;
+static uint16_t acqCfgState = ACQCFG_CONFIG;
+// Neither profile opens the balance switches ahead of a scan. startNextScans adds AUTOBALSWDIS while balancing
+static const Acq_Profile_S acqProfiles[NUM_ACQ_PROFILES] =
+{
+	[ACQ_PROFILE_PRECISE] = { SCANCTRL_32_OVERSAMPLES, ACQCFG_CONFIG, MEASUREEN_CONFIG },
+	[ACQ_PROFILE_FAST]    = { SCANCTRL_4_OVERSAMPLES, ACQCFG_THRM_ON | ACQCFG_FAST_SETTLING_TIME, MEASUREEN_CONFIG & ~MEASUREEN_ENABLE_VBLOCK_CHANNEL }
+};
+// Profile selected for the next scan and profile of the scan in progress
+static Acq_Profile_E acqProfile = ACQ_PROFILE_PRECISE;
+static Acq_Profile_E activeProfile = ACQ_PROFILE_PRECISE;
+// Repeating scan schedule built by planBmbScans. Scans start every slot period of the selected profile
+static Scan_Slot_S scanSchedule[MAX_SCAN_SCHEDULE_SLOTS];
+static uint32_t scanScheduleLength = 0;
+static uint32_t scanScheduleIdx = 0;
+static uint32_t scanSlotMs[NUM_ACQ_PROFILES] = { BMB_DATA_REFRESH_DELAY_MS, BMB_DATA_REFRESH_DELAY_MS };
+// The slot of the scan in progress and its estimated duration
+static Scan_Slot_S activeSlot;
+static uint32_t activeScanMs = 0;
+static uint32_t lastScanLatencyMs = 0;
+// Scan timing. Data is read out as soon as the scan is predicted to be done. The prediction is
+// the estimated duration of the slot plus a learned offset
+static bool scanInProgress = false;
+static uint32_t scanStartTick = 0;
+static uint32_t scanDurationMs = BMB_SCAN_TIMEOUT_MS;
+static int32_t scanPredictionOffsetMs = 0;
+static uint32_t numScansOnTime = 0;
 static uint8_t recvBuffer[SPI_BUFF_SIZE];
+// Receive buffers for the data register block read, one per register of each chain
+// These are the DMA destination and are decoded in place
+static uint8_t dataBuffer[NUM_ASCI_CHAINS][NUM_DATA_READS][SPI_BUFF_SIZE] __ALIGNED(4);
+static bool dataReadSuccess[NUM_ASCI_CHAINS][NUM_DATA_READS];
+// Position (1 indexed) of the first unreachable BMB found by the last break search on each chain, 0 if none
+static uint32_t lastChainBreakPos[NUM_ASCI_CHAINS];
+// Receive buffers for the configuration audit, one per audited register
+static uint8_t auditBuffer[NUM_AUDIT_REGISTERS][SPI_BUFF_SIZE] __ALIGNED(4);
+// Receive buffers for the alert poll, one per register of each chain
+static uint8_t alertBuffer[NUM_ASCI_CHAINS][NUM_ALERT_READS][SPI_BUFF_SIZE] __ALIGNED(4);
+static bool alertReadSuccess[NUM_ASCI_CHAINS][NUM_ALERT_READS];
+// Receive buffers for the MINMAXCELL read of the cell extremes readout
+static uint8_t minMaxBuffer[NUM_ASCI_CHAINS][1][SPI_BUFF_SIZE] __ALIGNED(4);
+static bool minMaxReadSuccess[NUM_ASCI_CHAINS][1];
+// Bricks read into dataBuffer by the last cell extremes readout. Shared by all chains
+static uint32_t extremesFirstBrick = 0;
+static uint32_t extremesNumBricks = 0;
 
 
 /* ==================================================================== */
@@ -51,20 +183,56 @@ static uint8_t recvBuffer[SPI_BUFF_SIZE];
 extern LookupTable_S ntcTable;
 extern LookupTable_S zenerTable;
 
+extern Asci_Stats_S asciStats;
+
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DECLARATIONS ==================== */
 /* ==================================================================== */
 
 static uint16_t getValueFromBuffer(uint8_t* buffer, uint32_t index);
 
-static void updateBmbBalanceSwitches(Bmb_S* bmb);
+static void updateBmbBalanceSwitches(Bmb_S* bmb, uint32_t bmbIdx);
 
 static bool startScan(uint32_t numBmbs);
 
+static bool startScans(const uint32_t* chainNumBmbs);
+
+static bool startNextScan(uint32_t numBmbs, bool writeMeasureEn, bool writeAcqCfg, bool writeGpio);
+
+static bool startNextScans(const uint32_t* chainNumBmbs, bool balancing);
+
+static uint32_t estimateScanDurationMs(uint16_t measureEn, uint16_t scanCtrl, uint16_t acqCfg);
+
+static void configureScanSlot(Scan_Slot_S* slot);
+
+static uint32_t estimateScanSlotMs(const Scan_Slot_S* slot, uint32_t numBmbs, Acq_Profile_E profile);
+
+static void placeTempScans(Scan_Product_E product, Mux_State_E firstMux, uint32_t numChannels, uint32_t numScans, uint32_t length);
+
+static void buildScanSchedule(const uint32_t* periodMs, uint32_t slotMs);
+
+static uint32_t measureScanPeriodMs(Scan_Product_E product, uint32_t slotMs);
+
+static bool balancingActive(Bmb_S* bmb, uint32_t numBmbs);
+
+static void auditBmbConfig(Bmb_S* bmb, uint32_t numBmbs);
+
+static void decodeBrickV(Bmb_S* bmb, uint32_t numBmbs, uint8_t (*data)[SPI_BUFF_SIZE], const bool* success, uint32_t firstBrick, uint32_t numBricks);
+
+static void decodeScanData(Bmb_S* bmb, uint32_t numBmbs, uint8_t (*data)[SPI_BUFF_SIZE], const bool* success, uint32_t products);
+
+static void readCellExtremes(const uint32_t* chainNumBmbs, bool readBricks);
+
+static void checkCellExtremes(Bmb_S* bmb, uint32_t numBmbs, uint32_t chainIdx);
+
 static bool is12BitSensorRailed(uint32_t rawAdcVal);
 
 static bool is14BitSensorRailed(uint32_t rawAdcVal);
 
+static bool probeDaisyChain(uint32_t bmbIdx, int32_t* loopbackIdx);
+
+static bool reinitBmb(uint32_t bmbIdx, uint32_t numBmbs);
+
 
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DEFINITIONS ===================== */
@@ -84,13 +252,14 @@ static uint16_t getValueFromBuffer(uint8_t* buffer, uint32_t index)
 /*!
   @brief   Enable the hardware bleed switches if balSwEnabled set in BMB struct
   @param   bmb - pointer to bmb that needs to be updated
+  @param   bmbIdx - The position of the BMB on the selected daisy chain
 */
-static void updateBmbBalanceSwitches(Bmb_S* bmb)
+static void updateBmbBalanceSwitches(Bmb_S* bmb, uint32_t bmbIdx)
 {
 	// TODO - should the watchdog be set in this function? For example if we want to ensure that all
 	// bleeding is ended we would call this update function but there would be no need to update the watchdog
 	// Set cell balancing watchdog timeout to 5s
-	writeDevice(WATCHDOG, (WATCHDOG_1S_STEP_SIZE | WATCHDOG_TIMER_LOAD_5), bmb->bmbIdx);
+	writeDevice(WATCHDOG, (WATCHDOG_1S_STEP_SIZE | WATCHDOG_TIMER_LOAD_5), bmbIdx);
 	uint16_t balanceSwEnabled = 0x0000;
 	uint16_t mask = 0x0001;
 	for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
@@ -102,7 +271,7 @@ static void updateBmbBalanceSwitches(Bmb_S* bmb)
 		mask = mask << 1;
 	}
 	// Update the balance switches on the relevant BMB
-	writeDevice(BALSWEN, balanceSwEnabled, bmb->bmbIdx);
+	writeDevice(BALSWEN, balanceSwEnabled, bmbIdx);
 }
 
 /*!
@@ -122,7 +291,7 @@ bool setBmbInternalLoopback(uint32_t bmbIdx, bool enabled)
 		// Verify that the internal loopback mode was enabled successfully
 		readDevice(DEVCFG2, recvBuffer, bmbIdx);
 		uint16_t registerValue = getValueFromBuffer(recvBuffer, 0);
-		if (registerValue & DEVCFG2_LASTLOOP)
+		if (((registerValue & DEVCFG2_LASTLOOP) != 0) == enabled)
 		{
 			// Successfully wrote to LASTLOOP bit
 			return true;
@@ -132,13 +301,16 @@ bool setBmbInternalLoopback(uint32_t bmbIdx, bool enabled)
 }
 
 /*!
-  @brief   Start a scan for all BMBs in the daisy chain
+  @brief   Start a scan for all BMBs in the selected daisy chain
   @param   numBmbs - The number of BMBs in the daisy chain.
   @return  True if the scan started successfully, false otherwise.
 */
 static bool startScan(uint32_t numBmbs)
 {
-	const uint16_t scanCtrlData = SCANCTRL_ENABLE_AUTOBALSWDIS | SCANCTRL_32_OVERSAMPLES | SCANCTRL_START_SCAN;
+	const uint16_t scanCtrlData = scanCtrlState | SCANCTRL_START_SCAN;
+	scanInProgress = true;
+	scanStartTick = HAL_GetTick();
+	scanDurationMs = ((int32_t)activeScanMs + scanPredictionOffsetMs > 1) ? (activeScanMs + scanPredictionOffsetMs) : 1;
 	if(!writeAll(SCANCTRL, scanCtrlData, numBmbs))
 	{
 		DebugComm("Failed to start scan!\n");
@@ -147,6 +319,730 @@ static bool startScan(uint32_t numBmbs)
 	return true;
 }
 
+/*!
+  @brief   Start a scan on every daisy chain
+  @param   chainNumBmbs - The number of BMBs on each daisy chain
+  @return  True if the scan started successfully on every chain, false otherwise.
+*/
+static bool startScans(const uint32_t* chainNumBmbs)
+{
+	bool success = true;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (chainNumBmbs[chainIdx] > 0)
+		{
+			selectAsciChain(chainIdx);
+			success &= startScan(chainNumBmbs[chainIdx]);
+		}
+	}
+	return success;
+}
+
+/*!
+  @brief   Apply the channel, settling time and mux configuration of the next slot and start a
+		   scan on all BMBs of the selected daisy chain. All writes are sent back to back without
+		   verification. Drift is caught by the configuration audit
+  @param   numBmbs - The number of BMBs in the daisy chain.
+  @param   writeMeasureEn - True if the measured channels changed
+  @param   writeAcqCfg - True if the settling time changed
+  @param   writeGpio - True if the mux channel changed
+  @return  True if every write was echoed correctly, false otherwise.
+*/
+static bool startNextScan(uint32_t numBmbs, bool writeMeasureEn, bool writeAcqCfg, bool writeGpio)
+{
+	// Configuration is written first so the scan samples with it
+	uint8_t addresses[4];
+	uint16_t values[4];
+	uint32_t numWrites = 0;
+	if (writeMeasureEn)
+	{
+		addresses[numWrites] = MEASUREEN;
+		values[numWrites++] = measureEnState;
+	}
+	if (writeAcqCfg)
+	{
+		addresses[numWrites] = ACQCFG;
+		values[numWrites++] = acqCfgState;
+	}
+	if (writeGpio)
+	{
+		addresses[numWrites] = GPIO;
+		values[numWrites++] = GPIO_MUX_OUTPUTS_ENABLED | (muxState & GPIO_MUX_SELECT_MASK);
+	}
+	addresses[numWrites] = SCANCTRL;
+	values[numWrites++] = scanCtrlState | SCANCTRL_START_SCAN;
+
+	if (!writeAllUnverified(addresses, values, numWrites, numBmbs))
+	{
+		DebugComm("Failed to start scan!\n");
+		return false;
+	}
+	return true;
+}
+
+/*!
+  @brief   Move to the next slot of the scan schedule and start its scan on every daisy chain.
+		   All chains share the slot configuration so their data is decoded the same way. Without
+		   a scan plan every scan measures all channels and the mux cycles through every channel.
+		   The scan uses the selected acquisition profile
+  @param   chainNumBmbs - The number of BMBs on each daisy chain
+  @param   balancing - True if any cell is being balanced
+  @return  True if the scan started successfully on every chain, false otherwise.
+*/
+static bool startNextScans(const uint32_t* chainNumBmbs, bool balancing)
+{
+	Scan_Slot_S slot = { .products = SCAN_MEASUREMENT_PRODUCTS, .muxState = (muxState + 1) % NUM_MUX_CHANNELS };
+	if (scanScheduleLength > 0)
+	{
+		scanScheduleIdx = (scanScheduleIdx + 1) % scanScheduleLength;
+		slot = scanSchedule[scanScheduleIdx];
+	}
+	else
+	{
+		configureScanSlot(&slot);
+	}
+
+	// Slots without measurements are left idle
+	scanStartTick = HAL_GetTick();
+	if (!(slot.products & SCAN_MEASUREMENT_PRODUCTS))
+	{
+		return true;
+	}
+
+	// Balance switches are always opened ahead of a scan while balancing
+	const Acq_Profile_S* profile = &acqProfiles[acqProfile];
+	const uint16_t measureEn = slot.measureEn & profile->measureEn;
+	const uint16_t acqCfg = profile->acqCfg;
+	scanCtrlState = profile->scanCtrl | (balancing ? SCANCTRL_ENABLE_AUTOBALSWDIS : 0);
+
+	const bool writeMeasureEn = (measureEn != measureEnState);
+	const bool writeAcqCfg = (acqCfg != acqCfgState);
+	const bool writeGpio = (slot.products & SCAN_TEMP_PRODUCTS) && (slot.muxState != muxState);
+	activeSlot = slot;
+	activeProfile = acqProfile;
+	measureEnState = measureEn;
+	acqCfgState = acqCfg;
+	if (writeGpio)
+	{
+		muxState = slot.muxState;
+	}
+	scanInProgress = true;
+	activeScanMs = estimateScanDurationMs(measureEnState, scanCtrlState, acqCfgState);
+	scanDurationMs = ((int32_t)activeScanMs + scanPredictionOffsetMs > 1) ? (activeScanMs + scanPredictionOffsetMs) : 1;
+
+	bool success = true;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (chainNumBmbs[chainIdx] > 0)
+		{
+			selectAsciChain(chainIdx);
+			success &= startNextScan(chainNumBmbs[chainIdx], writeMeasureEn, writeAcqCfg, writeGpio);
+		}
+	}
+	return success;
+}
+
+/*!
+  @brief   Estimate how long a scan takes from the programmed oversampling, settling time and
+		   enabled channels
+  @param   measureEn - The channels measured by the scan
+  @param   scanCtrl - The SCANCTRL configuration of the scan
+  @param   acqCfg - The ACQCFG configuration of the scan
+  @return  The estimated scan duration in ms, rounded up
+*/
+static uint32_t estimateScanDurationMs(uint16_t measureEn, uint16_t scanCtrl, uint16_t acqCfg)
+{
+	// OVSAMPL of 0 is a single sample, otherwise 2^(OVSAMPL + 1) samples
+	const uint32_t ovsampl = (scanCtrl & SCANCTRL_OVERSAMPLES_MASK) >> SCANCTRL_OVERSAMPLES_SHIFT;
+	const uint32_t numOversamples = (ovsampl == 0) ? 1 : (1UL << (ovsampl + 1));
+
+	const uint32_t numChannels = __builtin_popcount(measureEn & MEASUREEN_ENABLE_BRICK_CHANNELS) +
+								 ((measureEn & MEASUREEN_ENABLE_VBLOCK_CHANNEL) ? 1 : 0) +
+								 ((measureEn & MEASUREEN_ENABLE_AIN1_CHANNEL) ? 1 : 0) +
+								 ((measureEn & MEASUREEN_ENABLE_AIN2_CHANNEL) ? 1 : 0);
+
+	const uint32_t recoveryTimeUs = (scanCtrl & SCANCTRL_ENABLE_AUTOBALSWDIS) ? SCAN_RECOVERY_TIME_US : 0;
+	const uint32_t settlingTimeUs = (acqCfg & ACQCFG_SETTLING_TIME_MASK) * ACQCFG_SETTLING_LSB_US;
+	const uint32_t scanTimeUs = recoveryTimeUs + settlingTimeUs + (numOversamples * numChannels * SCAN_CONVERSION_TIME_US);
+	return (scanTimeUs + 999) / 1000;
+}
+
+/*!
+  @brief   Set the channels measured and the data registers read out by a scan slot from the
+		   data products it refreshes
+  @param   slot - The scan slot. The products and mux channel must already be set
+*/
+static void configureScanSlot(Scan_Slot_S* slot)
+{
+	uint32_t lastRead = 0;
+	slot->measureEn = 0;
+	slot->firstRead = NUM_DATA_READS;
+	if (slot->products & SCAN_PRODUCT_BIT(SCAN_CELL_V))
+	{
+		slot->measureEn |= MEASUREEN_ENABLE_BRICK_CHANNELS;
+		slot->firstRead = CELL_READ_IDX;
+		lastRead = CELL_READ_IDX + NUM_BRICKS_PER_BMB - 1;
+	}
+	if (slot->products & SCAN_PRODUCT_BIT(SCAN_CELL_EXTREMES))
+	{
+		// The extreme bricks are only known once the scan is done. They are read after the data block
+		slot->measureEn |= MEASUREEN_ENABLE_BRICK_CHANNELS;
+	}
+	if (slot->products & SCAN_PRODUCT_BIT(SCAN_SEGMENT_V))
+	{
+		slot->measureEn |= MEASUREEN_ENABLE_VBLOCK_CHANNEL;
+		slot->firstRead = (slot->firstRead < VBLOCK_READ_IDX) ? slot->firstRead : VBLOCK_READ_IDX;
+		lastRead = VBLOCK_READ_IDX;
+	}
+	if (slot->products & SCAN_TEMP_PRODUCTS)
+	{
+		slot->measureEn |= MEASUREEN_ENABLE_AIN1_CHANNEL | MEASUREEN_ENABLE_AIN2_CHANNEL;
+		slot->firstRead = (slot->firstRead < AIN_READ_IDX) ? slot->firstRead : AIN_READ_IDX;
+		lastRead = AIN_READ_IDX + 1;
+	}
+
+	// Registers between the products a slot refreshes are read too so the readout is a single block
+	slot->numReads = (slot->firstRead < NUM_DATA_READS) ? (lastRead - slot->firstRead + 1) : 0;
+	for (int32_t i = 0; i < NUM_ACQ_PROFILES; i++)
+	{
+		const Acq_Profile_S* profile = &acqProfiles[i];
+		slot->scanMs[i] = estimateScanDurationMs(slot->measureEn & profile->measureEn, profile->scanCtrl, profile->acqCfg);
+	}
+}
+
+/*!
+  @brief   Estimate the time a scan slot takes including the SCANCTRL check, the data readout,
+		   the cell extremes readout and the configuration audit
+  @param   slot - The scan slot
+  @param   numBmbs - The number of BMBs on the longest daisy chain
+  @param   profile - The acquisition profile of the scan
+  @return  The estimated slot duration in ms, rounded up
+*/
+static uint32_t estimateScanSlotMs(const Scan_Slot_S* slot, uint32_t numBmbs, Acq_Profile_E profile)
+{
+	if (!(slot->products & SCAN_MEASUREMENT_PRODUCTS))
+	{
+		return 0;
+	}
+
+	uint32_t commsUs = estimateReadAllBlockUs(slot->numReads + 1, numBmbs);
+	if (slot->products & SCAN_PRODUCT_BIT(SCAN_DIAGNOSTICS))
+	{
+		commsUs += estimateReadAllBlockUs(NUM_AUDIT_REGISTERS, numBmbs);
+	}
+	if (slot->products & SCAN_PRODUCT_BIT(SCAN_CELL_EXTREMES))
+	{
+		// MINMAXCELL, then the widest span of extreme bricks unless the data block already holds every brick
+		commsUs += estimateReadAllBlockUs(1, numBmbs);
+		if (!(slot->products & SCAN_PRODUCT_BIT(SCAN_CELL_V)))
+		{
+			commsUs += estimateReadAllBlockUs(CELL_EXTREMES_MAX_SPAN, numBmbs);
+		}
+	}
+	return slot->scanMs[profile] + ((commsUs + 999) / 1000);
+}
+
+/*!
+  @brief   Spread the scans of a temperature product evenly over the schedule. The mux is shared
+		   so a scan that lands on a slot already sampling a temperature moves to the next free slot
+  @param   product - The temperature product
+  @param   firstMux - The first mux channel of the product
+  @param   numChannels - The number of mux channels a refresh of the product takes
+  @param   numScans - The number of scans of the product in the schedule
+  @param   length - The number of slots in the schedule. Must be more than the temperature scans
+*/
+static void placeTempScans(Scan_Product_E product, Mux_State_E firstMux, uint32_t numChannels, uint32_t numScans, uint32_t length)
+{
+	for (uint32_t i = 0; i < numScans; i++)
+	{
+		uint32_t slotIdx = (i * length) / numScans;
+		while (scanSchedule[slotIdx].products & SCAN_TEMP_PRODUCTS)
+		{
+			slotIdx = (slotIdx + 1) % length;
+		}
+		scanSchedule[slotIdx].products |= SCAN_PRODUCT_BIT(product);
+		scanSchedule[slotIdx].muxState = firstMux + (i % numChannels);
+	}
+}
+
+/*!
+  @brief   Build the scan schedule for a slot period. The schedule is as long as the slowest
+		   product takes to refresh so every product repeats within it
+  @param   periodMs - The target refresh period of each data product in ms
+  @param   slotMs - The slot period in ms
+*/
+static void buildScanSchedule(const uint32_t* periodMs, uint32_t slotMs)
+{
+	// Slots allowed between refreshes of each product. At least one pass over the mux fits
+	uint32_t cycleSlots[NUM_SCAN_PRODUCTS];
+	uint32_t length = NUM_MUX_CHANNELS;
+	for (int32_t i = 0; i < NUM_SCAN_PRODUCTS; i++)
+	{
+		cycleSlots[i] = (periodMs[i] >= slotMs) ? (periodMs[i] / slotMs) : 1;
+		length = (cycleSlots[i] > length) ? cycleSlots[i] : length;
+	}
+	length = (length < MAX_SCAN_SCHEDULE_SLOTS) ? length : MAX_SCAN_SCHEDULE_SLOTS;
+	memset(scanSchedule, 0, sizeof(scanSchedule));
+
+	// Temperatures share the mux, one channel per slot. If the mux can not keep up both are slowed in proportion
+	uint32_t numBrickScans = ((length + cycleSlots[SCAN_BRICK_TEMP] - 1) / cycleSlots[SCAN_BRICK_TEMP]) * NUM_BRICK_TEMP_MUX_CHANNELS;
+	uint32_t numBoardScans = ((length + cycleSlots[SCAN_BOARD_TEMP] - 1) / cycleSlots[SCAN_BOARD_TEMP]) * NUM_BOARD_TEMP_MUX_CHANNELS;
+	if (numBrickScans + numBoardScans > length)
+	{
+		numBrickScans = (length * numBrickScans) / (numBrickScans + numBoardScans);
+		numBrickScans = (numBrickScans < length - NUM_BOARD_TEMP_MUX_CHANNELS) ? numBrickScans : (length - NUM_BOARD_TEMP_MUX_CHANNELS);
+		numBrickScans = (numBrickScans / NUM_BRICK_TEMP_MUX_CHANNELS) * NUM_BRICK_TEMP_MUX_CHANNELS;
+		numBrickScans = (numBrickScans > NUM_BRICK_TEMP_MUX_CHANNELS) ? numBrickScans : NUM_BRICK_TEMP_MUX_CHANNELS;
+		numBoardScans = ((length - numBrickScans) / NUM_BOARD_TEMP_MUX_CHANNELS) * NUM_BOARD_TEMP_MUX_CHANNELS;
+	}
+	placeTempScans(SCAN_BRICK_TEMP, MUX1, NUM_BRICK_TEMP_MUX_CHANNELS, numBrickScans, length);
+	placeTempScans(SCAN_BOARD_TEMP, MUX7, NUM_BOARD_TEMP_MUX_CHANNELS, numBoardScans, length);
+
+	// Voltages do not use the mux and are spread evenly
+	const Scan_Product_E voltageProducts[] = { SCAN_CELL_V, SCAN_CELL_EXTREMES, SCAN_SEGMENT_V };
+	for (uint32_t i = 0; i < sizeof(voltageProducts) / sizeof(voltageProducts[0]); i++)
+	{
+		const uint32_t numScans = (length + cycleSlots[voltageProducts[i]] - 1) / cycleSlots[voltageProducts[i]];
+		for (uint32_t j = 0; j < numScans; j++)
+		{
+			scanSchedule[(j * length) / numScans].products |= SCAN_PRODUCT_BIT(voltageProducts[i]);
+		}
+	}
+	// Every full brick readout refreshes the extremes too and cross-checks MINMAXCELL against the bricks
+	for (uint32_t i = 0; i < length; i++)
+	{
+		if (scanSchedule[i].products & SCAN_PRODUCT_BIT(SCAN_CELL_V))
+		{
+			scanSchedule[i].products |= SCAN_PRODUCT_BIT(SCAN_CELL_EXTREMES);
+		}
+	}
+
+	// Diagnostics run after a readout so they go on the next slot that measures something
+	const uint32_t numAudits = (length + cycleSlots[SCAN_DIAGNOSTICS] - 1) / cycleSlots[SCAN_DIAGNOSTICS];
+	for (uint32_t i = 0; i < numAudits; i++)
+	{
+		uint32_t slotIdx = (i * length) / numAudits;
+		for (uint32_t j = 0; (j < length) && !(scanSchedule[slotIdx].products & SCAN_MEASUREMENT_PRODUCTS); j++)
+		{
+			slotIdx = (slotIdx + 1) % length;
+		}
+		if (scanSchedule[slotIdx].products & SCAN_MEASUREMENT_PRODUCTS)
+		{
+			scanSchedule[slotIdx].products |= SCAN_PRODUCT_BIT(SCAN_DIAGNOSTICS);
+		}
+	}
+
+	for (uint32_t i = 0; i < length; i++)
+	{
+		configureScanSlot(&scanSchedule[i]);
+	}
+	scanScheduleLength = length;
+}
+
+/*!
+  @brief   Find the longest time between refreshes of a data product in the scan schedule. A
+		   temperature refresh is complete once each of its mux channels has been sampled
+  @param   product - The data product
+  @param   slotMs - The slot period in ms
+  @return  The longest refresh period in ms, UINT32_MAX if the product is never refreshed
+*/
+static uint32_t measureScanPeriodMs(Scan_Product_E product, uint32_t slotMs)
+{
+	const bool muxProduct = SCAN_PRODUCT_BIT(product) & SCAN_TEMP_PRODUCTS;
+	const Mux_State_E firstMux = (product == SCAN_BOARD_TEMP) ? MUX7 : MUX1;
+	const uint32_t numChannels = !muxProduct ? 1 : ((product == SCAN_BOARD_TEMP) ? NUM_BOARD_TEMP_MUX_CHANNELS : NUM_BRICK_TEMP_MUX_CHANNELS);
+
+	uint32_t maxGapSlots = 0;
+	for (uint32_t channel = 0; channel < numChannels; channel++)
+	{
+		bool found = false;
+		uint32_t firstSlot = 0;
+		uint32_t prevSlot = 0;
+		for (uint32_t i = 0; i < scanScheduleLength; i++)
+		{
+			const Scan_Slot_S* slot = &scanSchedule[i];
+			if ((slot->products & SCAN_PRODUCT_BIT(product)) && (!muxProduct || (slot->muxState == firstMux + channel)))
+			{
+				if (found)
+				{
+					maxGapSlots = ((i - prevSlot) > maxGapSlots) ? (i - prevSlot) : maxGapSlots;
+				}
+				else
+				{
+					firstSlot = i;
+					found = true;
+				}
+				prevSlot = i;
+			}
+		}
+		if (!found)
+		{
+			return UINT32_MAX;
+		}
+		// The schedule repeats
+		const uint32_t wrapGapSlots = firstSlot + scanScheduleLength - prevSlot;
+		maxGapSlots = (wrapGapSlots > maxGapSlots) ? wrapGapSlots : maxGapSlots;
+	}
+	return maxGapSlots * slotMs;
+}
+
+/*!
+  @brief   Determine whether any balance switch is enabled
+  @param   bmb - The array containing BMB data
+  @param   numBmbs - The number of BMBs in the daisy chain.
+  @return  True if any cell is being balanced, false otherwise.
+*/
+static bool balancingActive(Bmb_S* bmb, uint32_t numBmbs)
+{
+	for (uint32_t i = 0; i < numBmbs; i++)
+	{
+		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			if (bmb[i].balSwEnabled[j])
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*!
+  @brief   Read back the configuration registers of all BMBs on the selected daisy chain and
+		   rewrite any register that has drifted. Must be called before the next scan is configured
+  @param   bmb - The array containing BMB data of the selected daisy chain
+  @param   numBmbs - The number of BMBs in the daisy chain.
+*/
+static void auditBmbConfig(Bmb_S* bmb, uint32_t numBmbs)
+{
+	// Only the configuration bits are compared. GPIO holds the pin input states and SCANCTRL the scan status
+	const uint8_t  addresses[NUM_AUDIT_REGISTERS] = { GPIO, SCANCTRL, MEASUREEN, ACQCFG, DEVCFG1, AUTOBALSWDIS };
+	const uint16_t expected[NUM_AUDIT_REGISTERS]  = { GPIO_MUX_OUTPUTS_ENABLED | (muxState & GPIO_MUX_SELECT_MASK), scanCtrlState, measureEnState, acqCfgState, DEVCFG1_CONFIG, AUTOBALSWDIS_5MS_RECOVERY_TIME };
+	const uint16_t masks[NUM_AUDIT_REGISTERS]     = { GPIO_MUX_SELECT_MASK, SCANCTRL_ENABLE_AUTOBALSWDIS | SCANCTRL_OVERSAMPLES_MASK, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF };
+
+	ReadAllRequest_S requests[NUM_AUDIT_REGISTERS];
+	for (int32_t i = 0; i < NUM_AUDIT_REGISTERS; i++)
+	{
+		requests[i].address = addresses[i];
+		requests[i].data_p = auditBuffer[i];
+	}
+	readAllQueued(requests, NUM_AUDIT_REGISTERS, numBmbs);
+
+	for (int32_t i = 0; i < NUM_AUDIT_REGISTERS; i++)
+	{
+		if (!requests[i].success)
+		{
+			continue;
+		}
+
+		bool drifted = false;
+		for (uint32_t j = 0; j < numBmbs; j++)
+		{
+			const uint16_t value = getValueFromBuffer(auditBuffer[i], j);
+			if ((value & masks[i]) != (expected[i] & masks[i]))
+			{
+				// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB)
+				bmb[numBmbs - j - 1].numConfigDrifts++;
+				drifted = true;
+			}
+		}
+
+		if (drifted)
+		{
+			DebugComm("BMB register 0x%02X drifted - rewriting\n", addresses[i]);
+			writeAll(addresses[i], expected[i], numBmbs);
+		}
+	}
+}
+
+/*!
+  @brief   Convert a range of CELLn registers read out after a scan into brick voltages
+  @param   bmb - The array containing BMB data of the daisy chain the data was read from
+  @param   numBmbs - The number of BMBs in the daisy chain.
+  @param   data - The data registers read by readAllBlockChains, one buffer per register
+  @param   success - The result of each register read
+  @param   firstBrick - The first brick to convert
+  @param   numBricks - The number of bricks to convert
+*/
+static void decodeBrickV(Bmb_S* bmb, uint32_t numBmbs, uint8_t (*data)[SPI_BUFF_SIZE], const bool* success, uint32_t firstBrick, uint32_t numBricks)
+{
+	for (uint32_t i = firstBrick; i < firstBrick + numBricks; i++)
+	{
+		if (success[CELL_READ_IDX + i])
+		{
+			for (uint8_t j = 0; j < numBmbs; j++)
+			{
+				// Read brick voltage in [15:2]
+				uint32_t brickVRaw = getValueFromBuffer(data[CELL_READ_IDX + i], j) >> 2;
+				// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+				const uint32_t bmbIdx = numBmbs - j - 1;
+				bmb[bmbIdx].brickVCode[i] = SENSOR_READING(brickVRaw, is14BitSensorRailed(brickVRaw) ? BAD : GOOD);
+				bmb[bmbIdx].brickVProfile = activeProfile;
+			}
+		}
+		else
+		{
+			DebugComm("Error during cellReg readAll!\n");
+
+			// Failed to acquire data. Set status to BAD
+			for (uint32_t j = 0; j < numBmbs; j++)
+			{
+				// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+				const uint32_t bmbIdx = numBmbs - j - 1;
+				bmb[bmbIdx].brickVCode[i] = SENSOR_READING(bmb[bmbIdx].brickVCode[i], BAD);
+			}
+		}
+	}
+}
+
+/*!
+  @brief   Convert the data registers read out after a scan into BMB voltages and temperatures
+  @param   bmb - The array containing BMB data of the daisy chain the data was read from
+  @param   numBmbs - The number of BMBs in the daisy chain.
+  @param   data - The data registers read by readAllBlockChains, one buffer per register
+  @param   success - The result of each register read. Registers not read are marked BAD
+  @param   products - The data products refreshed by the scan. See SCAN_PRODUCT_BIT
+*/
+static void decodeScanData(Bmb_S* bmb, uint32_t numBmbs, uint8_t (*data)[SPI_BUFF_SIZE], const bool* success, uint32_t products)
+{
+	// Update brick voltage data
+	if (products & SCAN_PRODUCT_BIT(SCAN_CELL_V))
+	{
+		decodeBrickV(bmb, numBmbs, data, success, 0, NUM_BRICKS_PER_BMB);
+	}
+
+	// Read VBLOCK register which is the total voltage of the segment
+	if (!(products & SCAN_PRODUCT_BIT(SCAN_SEGMENT_V)))
+	{
+		// Not measured by this scan
+	}
+	else if (!(measureEnState & MEASUREEN_ENABLE_VBLOCK_CHANNEL))
+	{
+		// VBLOCK is not measured by the acquisition profile. The segment voltage is the sum of the bricks
+		for (uint32_t j = 0; j < numBmbs; j++)
+		{
+			uint32_t brickVCodeSum = 0;
+			Sensor_Status_E segmentVStatus = GOOD;
+			for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+			{
+				brickVCodeSum += SENSOR_CODE(bmb[j].brickVCode[i]);
+				segmentVStatus = (SENSOR_STATUS(bmb[j].brickVCode[i]) == GOOD) ? segmentVStatus : BAD;
+			}
+			const uint32_t segmentVRaw = (brickVCodeSum + (BRICK_CODES_PER_SEGMENT_CODE / 2)) / BRICK_CODES_PER_SEGMENT_CODE;
+			bmb[j].segmentVCode = SENSOR_READING(segmentVRaw, segmentVStatus);
+			bmb[j].segmentVProfile = activeProfile;
+		}
+	}
+	else if (success[VBLOCK_READ_IDX])
+	{
+		for (uint8_t j = 0; j < numBmbs; j++)
+		{
+			// Read block voltage in [15:2]
+			uint32_t segmentVRaw = getValueFromBuffer(data[VBLOCK_READ_IDX], j) >> 2;
+			// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+			const uint32_t bmbIdx = numBmbs - j - 1;
+			bmb[bmbIdx].segmentVCode = SENSOR_READING(segmentVRaw, is14BitSensorRailed(segmentVRaw) ? BAD : GOOD);
+			bmb[bmbIdx].segmentVProfile = activeProfile;
+		}
+	}
+	else
+	{
+		DebugComm("Error during VBLOCK readAll!\n");
+
+		// Failed to acquire data. Set status to BAD
+		for (uint32_t j = 0; j < numBmbs; j++)
+		{
+			// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+			const uint32_t bmbIdx = numBmbs - j - 1;
+			bmb[bmbIdx].segmentVCode = SENSOR_READING(bmb[bmbIdx].segmentVCode, BAD);
+		}
+	}
+
+	// Read AUX/TEMP registers
+	for (int32_t auxChannel = AIN1; (products & SCAN_TEMP_PRODUCTS) && (auxChannel <= AIN2); auxChannel++)
+	{
+		const uint32_t auxReadIdx = AIN_READ_IDX + (auxChannel - AIN1);
+		if (success[auxReadIdx])
+		{
+			// Parse received data
+			for (uint32_t j = 0; j < numBmbs; j++)
+			{
+				// Read AUX voltage in [15:4]
+				uint32_t auxRaw = getValueFromBuffer(data[auxReadIdx], j) >> 4;
+				const Sensor_Status_E auxStatus = is12BitSensorRailed(auxRaw) ? BAD : GOOD;
+
+				// Store temp voltage registers as temperature readings
+				if(muxState == MUX7 || muxState == MUX8) // NTC/ON-Board Temp Channel
+				{
+					// Ternary statements used to resolve index of NTC channel from mux position and ain port
+					// NTC1: MUX7 (1) + AIN2 (-1)	= Index 0
+					// NTC2: MUX7 (1) + AIN1 (0)	= Index 1
+					// NTC3: MUX8 (3) + AIN2 (-1)	= Index 2
+					// NTC4: MUX8 (3) + AIN1 (0)	= Index 3
+					const uint32_t ntcIdx = ((muxState == MUX7) ? 1 : 3) + ((auxChannel == AIN1) ? 0 : -1);
+					// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+					const uint32_t bmbIdx = numBmbs - j - 1;
+					bmb[bmbIdx].boardTempCode[ntcIdx] = SENSOR_READING(auxRaw, auxStatus);
+					bmb[bmbIdx].boardTempProfile[ntcIdx] = activeProfile;
+					// TODO Add board temp status
+				}
+				else // Zener/Brick Temp Channel
+				{
+					const uint32_t brickIdx = muxState + ((auxChannel == AIN2) ? (NUM_BRICKS_PER_BMB/2) : 0);
+					// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+					const uint32_t bmbIdx = numBmbs - j - 1;
+					bmb[bmbIdx].brickTempCode[brickIdx] = SENSOR_READING(auxRaw, auxStatus);
+					bmb[bmbIdx].brickTempProfile[brickIdx] = activeProfile;
+				}
+			}
+		}
+		else
+		{
+			DebugComm("Error during TEMP readAll!\n");
+			// Failed to acquire data. Set status to BAD
+			for (uint32_t j = 0; j < numBmbs; j++)
+			{
+				if(muxState == MUX7 || muxState == MUX8) // NTC/ON-Board Temp Channel
+				{
+					// Ternary statements used to resolve index of NTC channel from mux position and ain port
+					// NTC1: MUX7 (1) + AIN2 (-1)	= Index 0
+					// NTC2: MUX7 (1) + AIN1 (0)	= Index 1
+					// NTC3: MUX8 (3) + AIN2 (-1)	= Index 2
+					// NTC4: MUX8 (3) + AIN1 (0)	= Index 3
+					const uint32_t ntcIdx = ((muxState == MUX7) ? 1 : 3) + ((auxChannel == AIN1) ? 0 : -1);
+					// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+					const uint32_t bmbIdx = numBmbs - j - 1;
+					bmb[bmbIdx].boardTempCode[ntcIdx] = SENSOR_READING(bmb[bmbIdx].boardTempCode[ntcIdx], BAD);
+				}
+				else
+				{
+					const uint32_t brickIdx = muxState + ((auxChannel == AIN2) ? (NUM_BRICKS_PER_BMB/2) : 0);
+					// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+					const uint32_t bmbIdx = numBmbs - j - 1;
+					bmb[bmbIdx].brickTempCode[brickIdx] = SENSOR_READING(bmb[bmbIdx].brickTempCode[brickIdx], BAD);
+				}
+			}
+		}
+	}
+}
+
+/*!
+  @brief   Read MINMAXCELL from every BMB on every daisy chain, then read only the CELLn registers
+		   between the lowest and highest extreme brick of all chains. The bricks land in
+		   dataBuffer at their usual place so they decode like a full readout. If the extremes
+		   span more than CELL_EXTREMES_MAX_SPAN bricks, or one is unknown, the bricks are not
+		   read and keep their last reading until the next full brick readout
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   readBricks - True to read the extreme bricks, false if the data block already holds every brick
+*/
+static void readCellExtremes(const uint32_t* chainNumBmbs, bool readBricks)
+{
+	Chain_Block_Read_S reads[NUM_ASCI_CHAINS];
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		reads[chainIdx] = (Chain_Block_Read_S) { .data_p = minMaxBuffer[chainIdx], .success_p = minMaxReadSuccess[chainIdx], .numBmbs = chainNumBmbs[chainIdx] };
+	}
+	readAllBlockChains(MINMAXCELL, 1, reads);
+
+	extremesNumBricks = 0;
+	if (!readBricks)
+	{
+		return;
+	}
+
+	// Every chain reads the same block so it spans the extremes of all BMBs
+	uint32_t firstBrick = NUM_BRICKS_PER_BMB;
+	uint32_t lastBrick = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		for (uint32_t j = 0; j < chainNumBmbs[chainIdx]; j++)
+		{
+			const uint16_t minMaxCell = minMaxReadSuccess[chainIdx][0] ? getValueFromBuffer(minMaxBuffer[chainIdx][0], j) : UINT16_MAX;
+			const uint32_t maxBrick = (minMaxCell >> MINMAXCELL_MAX_SHIFT) & MINMAXCELL_INDEX_MASK;
+			const uint32_t minBrick = minMaxCell & MINMAXCELL_INDEX_MASK;
+			if ((maxBrick >= NUM_BRICKS_PER_BMB) || (minBrick >= NUM_BRICKS_PER_BMB))
+			{
+				firstBrick = 0;
+				lastBrick = NUM_BRICKS_PER_BMB - 1;
+				continue;
+			}
+			firstBrick = (maxBrick < firstBrick) ? maxBrick : firstBrick;
+			firstBrick = (minBrick < firstBrick) ? minBrick : firstBrick;
+			lastBrick = (maxBrick > lastBrick) ? maxBrick : lastBrick;
+			lastBrick = (minBrick > lastBrick) ? minBrick : lastBrick;
+		}
+	}
+	if (firstBrick > lastBrick)
+	{
+		// No BMBs
+		return;
+	}
+	if (lastBrick - firstBrick + 1 > CELL_EXTREMES_MAX_SPAN)
+	{
+		// Reading the span would cost more than the slot was planned for
+		DebugComm("Cell extremes span %lu bricks - not read\n", lastBrick - firstBrick + 1);
+		return;
+	}
+
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		reads[chainIdx] = (Chain_Block_Read_S) { .data_p = &dataBuffer[chainIdx][CELL_READ_IDX + firstBrick], .success_p = &dataReadSuccess[chainIdx][CELL_READ_IDX + firstBrick], .numBmbs = chainNumBmbs[chainIdx] };
+	}
+	readAllBlockChains(CELLn + firstBrick, lastBrick - firstBrick + 1, reads);
+	extremesFirstBrick = firstBrick;
+	extremesNumBricks = lastBrick - firstBrick + 1;
+}
+
+/*!
+  @brief   Cross-check MINMAXCELL against a full brick readout of the same scan. It has to point at
+		   a brick with the highest and a brick with the lowest voltage. Mismatches are counted
+		   in numMinMaxMismatches
+  @param   bmb - The array containing BMB data of the daisy chain
+  @param   numBmbs - The number of BMBs in the daisy chain.
+  @param   chainIdx - The index of the ASCI daisy chain
+*/
+static void checkCellExtremes(Bmb_S* bmb, uint32_t numBmbs, uint32_t chainIdx)
+{
+	if (!minMaxReadSuccess[chainIdx][0])
+	{
+		DebugComm("Error during MINMAXCELL readAll!\n");
+		return;
+	}
+
+	for (uint32_t j = 0; j < numBmbs; j++)
+	{
+		// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
+		const uint32_t bmbIdx = numBmbs - j - 1;
+		Bmb_S* pBmb = &bmb[bmbIdx];
+
+		uint16_t maxCode = 0;
+		uint16_t minCode = SENSOR_CODE_MASK;
+		bool allGood = true;
+		for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+		{
+			const uint16_t code = SENSOR_CODE(pBmb->brickVCode[i]);
+			allGood &= (SENSOR_STATUS(pBmb->brickVCode[i]) == GOOD);
+			maxCode = (code > maxCode) ? code : maxCode;
+			minCode = (code < minCode) ? code : minCode;
+		}
+		if (!allGood)
+		{
+			// Nothing to check against
+			continue;
+		}
+
+		const uint16_t minMaxCell = getValueFromBuffer(minMaxBuffer[chainIdx][0], j);
+		const uint32_t maxBrick = (minMaxCell >> MINMAXCELL_MAX_SHIFT) & MINMAXCELL_INDEX_MASK;
+		const uint32_t minBrick = minMaxCell & MINMAXCELL_INDEX_MASK;
+		if ((maxBrick >= NUM_BRICKS_PER_BMB) || (minBrick >= NUM_BRICKS_PER_BMB) ||
+			(SENSOR_CODE(pBmb->brickVCode[maxBrick]) != maxCode) || (SENSOR_CODE(pBmb->brickVCode[minBrick]) != minCode))
+		{
+			pBmb->numMinMaxMismatches++;
+			DebugComm("Chain %lu BMB %lu MINMAXCELL does not match the bricks\n", chainIdx, bmbIdx);
+		}
+	}
+}
+
 /*!
   @brief   Check if a 12-bit ADC sensor value is railed (near minimum or maximum).
   @param   rawAdcVal - The raw 12-bit ADC sensor value to check.
@@ -167,22 +1063,95 @@ static bool is12BitSensorRailed(uint32_t rawAdcVal)
 }
 
 /*!
-  @brief   Check if a 14-bit ADC sensor value is railed (near minimum or maximum).
-  @param   rawAdcVal - The raw 14-bit ADC sensor value to check.
-  @return  True if the sensor value is within the margin of railed values, false otherwise.
+  @brief   Check if a 14-bit ADC sensor value is railed (near minimum or maximum).
+  @param   rawAdcVal - The raw 14-bit ADC sensor value to check.
+  @return  True if the sensor value is within the margin of railed values, false otherwise.
+*/
+static bool is14BitSensorRailed(uint32_t rawAdcVal)
+{
+	// Ensure only 14 bit value
+	rawAdcVal &= MAX_14_BIT;
+
+	// Determine if the adc reading is within a margin of the railed values
+	if ((rawAdcVal < RAILED_MARGIN_COUNT) || (rawAdcVal > (MAX_14_BIT - RAILED_MARGIN_COUNT)))
+	{
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+  @brief   Determine whether the daisy chain is intact from the BMS up to and including a BMB by
+		   closing the chain with internal loopback on that BMB
+  @param   bmbIdx - The index of the BMB to close the chain at
+  @param   loopbackIdx - The index of the BMB that internal loopback was last enabled on, -1 if none.
+		   Updated to bmbIdx
+  @return  True if every BMB up to and including bmbIdx responded, false otherwise
+*/
+static bool probeDaisyChain(uint32_t bmbIdx, int32_t* loopbackIdx)
+{
+	if ((*loopbackIdx >= 0) && (*loopbackIdx != (int32_t)bmbIdx))
+	{
+		// Open the previous loopback so it does not shorten the chain. This can not be verified while
+		// the chain past that BMB is broken. A successful probe further along the chain verifies it
+		writeDevice(DEVCFG2, 0, *loopbackIdx);
+	}
+	*loopbackIdx = bmbIdx;
+
+	if (!setBmbInternalLoopback(bmbIdx, true)) { return false; }
+
+	// Determine if loopback communication is restored
+	memset(recvBuffer, 0, sizeof(recvBuffer));
+	if (!readAll(VERSION, recvBuffer, bmbIdx + 1)) { return false; }
+
+	for (uint32_t i = 0; i < bmbIdx + 1; i++)
+	{
+		// Read model number in [15:4] to verify succesful communication
+		uint32_t versionRegister = getValueFromBuffer(recvBuffer, i) >> 4;
+		if (versionRegister != VERSION_DEFAULT_CONTENT)
+		{
+			// Responses are ordered from the far end of the probed section of the chain
+			recordBmbVersionMismatch(bmbIdx - i);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*!
+  @brief   Rewrite the configuration of a single BMB after it was reset and clear its
+		   power-on reset alert. Balancing is restored by the next balancing update
+  @param   bmbIdx - The index of the BMB to reinitialize
+  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @return  True if all configuration writes succeeded, false otherwise
 */
-static bool is14BitSensorRailed(uint32_t rawAdcVal)
+static bool reinitBmb(uint32_t bmbIdx, uint32_t numBmbs)
 {
-	// Ensure only 14 bit value
-	rawAdcVal &= MAX_14_BIT;
-
-	// Determine if the adc reading is within a margin of the railed values
-	if ((rawAdcVal < RAILED_MARGIN_COUNT) || (rawAdcVal > (MAX_14_BIT - RAILED_MARGIN_COUNT)))
+	bool success = true;
+
+	// Same configuration as initBmbs
+	success &= writeDevice(DEVCFG1, DEVCFG1_CONFIG, bmbIdx);
+	success &= writeDevice(MEASUREEN, measureEnState, bmbIdx);
+	success &= writeDevice(ACQCFG, acqCfgState, bmbIdx);
+	success &= writeDevice(AUTOBALSWDIS, AUTOBALSWDIS_5MS_RECOVERY_TIME, bmbIdx);
+	success &= writeDevice(GPIO, GPIO_MUX_OUTPUTS_ENABLED | (muxState & GPIO_MUX_SELECT_MASK), bmbIdx);
+	success &= writeDevice(OVTHSET, OVTHSET_CONFIG, bmbIdx);
+	success &= writeDevice(OVTHCLR, OVTHCLR_CONFIG, bmbIdx);
+	success &= writeDevice(UVTHSET, UVTHSET_CONFIG, bmbIdx);
+	success &= writeDevice(UVTHCLR, UVTHCLR_CONFIG, bmbIdx);
+	success &= writeDevice(ALRTOVEN, ALRTEN_BRICK_CHANNELS, bmbIdx);
+	success &= writeDevice(ALRTUVEN, ALRTEN_BRICK_CHANNELS, bmbIdx);
+
+	if (bmbIdx == numBmbs - 1)
 	{
-		return true;
+		// The final BMB closes the chain with internal loopback
+		success &= setBmbInternalLoopback(bmbIdx, true);
 	}
 
-	return false;
+	// Clear ALRTRST so that the next reset can be detected
+	success &= writeDevice(STATUS, 0x0000, bmbIdx);
+	return success;
 }
 
 
@@ -199,199 +1168,469 @@ void initBmbs(uint32_t numBmbs)
 	// TODO - do we want to read the register contents back and verify values?
 	// Enable alive counter byte
 	// numBmbs set to 0 since alive counter not yet enabled
-	writeAll(DEVCFG1, (DEVCFG1_DEFAULT_CONFIG | DEVCFG1_ENABLE_ALIVE_COUNTER), 0);
+	writeAll(DEVCFG1, DEVCFG1_CONFIG, 0);
 
 	// Enable measurement channels
-	writeAll(MEASUREEN, (MEASUREEN_ENABLE_BRICK_CHANNELS | MEASUREEN_ENABLE_VBLOCK_CHANNEL | MEASUREEN_ENABLE_AIN1_CHANNEL | MEASUREEN_ENABLE_AIN2_CHANNEL), numBmbs);
+	writeAll(MEASUREEN, MEASUREEN_CONFIG, numBmbs);
 
 	// Manual set THRM HIGH and config settling time
-	writeAll(ACQCFG, (ACQCFG_THRM_ON | ACQCFG_MAX_SETTLING_TIME), numBmbs);
+	writeAll(ACQCFG, ACQCFG_CONFIG, numBmbs);
 
 	// Enable 5ms delay between balancing and aquisition
 	writeAll(AUTOBALSWDIS, AUTOBALSWDIS_5MS_RECOVERY_TIME, numBmbs);
 
 	// Reset MUX configuration to Channel 1 - 000
-	setMux(numBmbs, MUX1);
-
-	// Start initial acquisition with 32 oversamples
+	muxState = MUX1;
+	setMux(numBmbs, muxState);
+
+	// Set brick OV and UV alert thresholds. Every brick is compared at the end of each scan
+	writeAll(OVTHSET, OVTHSET_CONFIG, numBmbs);
+	writeAll(OVTHCLR, OVTHCLR_CONFIG, numBmbs);
+	writeAll(UVTHSET, UVTHSET_CONFIG, numBmbs);
+	writeAll(UVTHCLR, UVTHCLR_CONFIG, numBmbs);
+	writeAll(ALRTOVEN, ALRTEN_BRICK_CHANNELS, numBmbs);
+	writeAll(ALRTUVEN, ALRTEN_BRICK_CHANNELS, numBmbs);
+
+	// Clear ALRTRST so that a later BMB reset can be detected
+	writeAll(STATUS, 0x0000, numBmbs);
+
+	// Start initial acquisition of every channel with 32 oversamples. Data is read out once the scan is
+	// predicted to be done. The scan schedule takes over from the next scan
+	measureEnState = MEASUREEN_CONFIG;
+	acqCfgState = ACQCFG_CONFIG;
+	scanCtrlState = SCANCTRL_32_OVERSAMPLES;
+	activeProfile = ACQ_PROFILE_PRECISE;
+	activeSlot = (Scan_Slot_S) { .products = SCAN_MEASUREMENT_PRODUCTS, .muxState = muxState };
+	configureScanSlot(&activeSlot);
+	activeScanMs = activeSlot.scanMs[ACQ_PROFILE_PRECISE];
+	scanPredictionOffsetMs = 0;
+	numScansOnTime = 0;
 	startScan(numBmbs);
-
-	// Set brickOV voltage alert threshold
-	// Set brickUV voltage alert threshold
 }
 
 /*!
-  @brief   Update BMB voltages and temperature data. Once new data gathered start new
-		   data acquisition scan
-  @param   bmb - BMB array data
-  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @brief   Update BMB voltages and temperature data on every daisy chain. All chains scan in
+		   lockstep and are read out concurrently. Scans start every slot of the schedule built
+		   by planBmbScans and are read out as soon as they are predicted to be done
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
 */
-void updateBmbData(Bmb_S* bmb, uint32_t numBmbs)
+void updateBmbData(Bmb_S* bmb, const uint32_t* chainNumBmbs)
 {
-	if((HAL_GetTick() - lastUpdate) >= BMB_DATA_REFRESH_DELAY_MS)
+	uint32_t numBmbs = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
 	{
-		// Update lastUpdate
-		lastUpdate = HAL_GetTick();
+		numBmbs += chainNumBmbs[chainIdx];
+	}
 
-		// Verify that Scan completed successfully
-		if (readAll(SCANCTRL, recvBuffer, numBmbs))
+	if (!scanInProgress)
+	{
+		// Balancing is paused while scanning so scans are spaced out while balancing
+		const bool balancing = balancingActive(bmb, numBmbs);
+		uint32_t slotPeriodMs = scanSlotMs[acqProfile];
+		if (balancing && (slotPeriodMs < BMB_DATA_REFRESH_DELAY_MS))
 		{
-			bool allBmbScanDone = true;
-			for (uint8_t j = 0; j < numBmbs; j++)
+			slotPeriodMs = BMB_DATA_REFRESH_DELAY_MS;
+		}
+		if ((HAL_GetTick() - scanStartTick) >= slotPeriodMs)
+		{
+			startNextScans(chainNumBmbs, balancing);
+		}
+		return;
+	}
+
+	if((HAL_GetTick() - scanStartTick) >= scanDurationMs)
+	{
+		const uint32_t startTransfers = asciStats.numTransfers;
+		const uint32_t startCycles = DWT->CYCCNT;
+
+		// All reads and retries of the scan readout share a single time budget
+		startCommsBudget(BMB_SCAN_COMMS_BUDGET_MS);
+
+		// Verify that Scan completed successfully on every chain
+		bool scanCtrlRead = true;
+		bool allBmbScanDone = true;
+		for (uint32_t chainIdx = 0; scanCtrlRead && (chainIdx < NUM_ASCI_CHAINS); chainIdx++)
+		{
+			if (chainNumBmbs[chainIdx] == 0)
+			{
+				continue;
+			}
+			selectAsciChain(chainIdx);
+			scanCtrlRead = readAll(SCANCTRL, recvBuffer, chainNumBmbs[chainIdx]);
+			for (uint8_t j = 0; scanCtrlRead && (j < chainNumBmbs[chainIdx]); j++)
 			{
 				// Extract register contents from receive buffer
 				uint16_t scanCtrlData = getValueFromBuffer(recvBuffer, j);
-				allBmbScanDone &= ((scanCtrlData & 0xA000) == 0xA000);	// Verify SCANDONE and DATARDY bits
+				allBmbScanDone &= ((scanCtrlData & (SCANCTRL_SCANDONE | SCANCTRL_DATARDY)) == (SCANCTRL_SCANDONE | SCANCTRL_DATARDY));
 			}
+		}
+		if (scanCtrlRead)
+		{
 			if (!allBmbScanDone)
 			{
+				endCommsBudget();
+				const uint32_t scanTimeMs = HAL_GetTick() - scanStartTick;
+				if (scanTimeMs < BMB_SCAN_TIMEOUT_MS)
+				{
+					// Predicted too early - poll again next time and predict later from now on
+					scanDurationMs = scanTimeMs + 1;
+					scanPredictionOffsetMs = (int32_t)scanDurationMs - (int32_t)activeScanMs;
+					numScansOnTime = 0;
+					return;
+				}
 				// Restart scans since scan may have not started properly
-				startScan(numBmbs);
+				startScans(chainNumBmbs);
 				// TODO: Set sensor status to bad
 				DebugComm("All BMB Scans failed to complete in time\n");
 				return;	
 			}
+
+			// Occasionally predict earlier so the prediction follows the hardware if scans get faster
+			if (++numScansOnTime >= SCAN_PREDICTION_PROBE_COUNT)
+			{
+				numScansOnTime = 0;
+				if ((int32_t)activeScanMs + scanPredictionOffsetMs > 1)
+				{
+					scanPredictionOffsetMs--;
+				}
+			}
 		}
 		else
 		{
+			endCommsBudget();
 			// TODO - improve this. Handle failure correctly
 			DebugComm("Failed to read SCANCTRL register\n");
 			return;
 		}
 
-		// Update brick voltage data
-		for (uint8_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+		// Scan complete - read out the data registers of the slot on every chain at once. Buffers stay
+		// indexed from DATA_BLOCK_START
+		const uint32_t firstRead = activeSlot.firstRead;
+		Chain_Block_Read_S reads[NUM_ASCI_CHAINS];
+		for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+		{
+			reads[chainIdx] = (Chain_Block_Read_S) { .data_p = &dataBuffer[chainIdx][firstRead], .success_p = &dataReadSuccess[chainIdx][firstRead], .numBmbs = chainNumBmbs[chainIdx] };
+		}
+		if (activeSlot.numReads > 0)
+		{
+			readAllBlockChains(DATA_BLOCK_START + firstRead, activeSlot.numReads, reads);
+		}
+		const bool fullBrickRead = (activeSlot.products & SCAN_PRODUCT_BIT(SCAN_CELL_V));
+		if (activeSlot.products & SCAN_PRODUCT_BIT(SCAN_CELL_EXTREMES))
+		{
+			readCellExtremes(chainNumBmbs, !fullBrickRead);
+		}
+		asciStats.lastUpdateTransfers = asciStats.numTransfers - startTransfers;
+		asciStats.lastUpdateCycles = DWT->CYCCNT - startCycles;
+
+		// Registers that could not be read within the budget are marked BAD below. The next scan is
+		// always configured and started so the BMB state stays consistent with the schedule
+		if (endCommsBudget())
+		{
+			DebugComm("Scan readout ran out of time!\n");
+		}
+
+		// The BMBs of each chain follow those of the previous chain in the BMB array
+		uint32_t firstBmbIdx = 0;
+		for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
 		{
-			uint8_t cellReg = i + CELLn;
-			if (readAll(cellReg, recvBuffer, numBmbs))
+			if (chainNumBmbs[chainIdx] > 0)
 			{
-				for (uint8_t j = 0; j < numBmbs; j++)
+				decodeScanData(&bmb[firstBmbIdx], chainNumBmbs[chainIdx], dataBuffer[chainIdx], dataReadSuccess[chainIdx], activeSlot.products);
+				if (!(activeSlot.products & SCAN_PRODUCT_BIT(SCAN_CELL_EXTREMES)))
 				{
-					// Read brick voltage in [15:2]
-					uint32_t brickVRaw = getValueFromBuffer(recvBuffer, j) >> 2;
-					float brickV = brickVRaw * CONVERT_14BIT_TO_5V;
-					// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-					const uint32_t bmbIdx = numBmbs - j - 1;
-					bmb[bmbIdx].brickV[i] = brickV;
-					bmb[bmbIdx].brickVStatus[i] = is14BitSensorRailed(brickVRaw) ? BAD : GOOD;
+					// Extremes not refreshed by this slot
+				}
+				else if (fullBrickRead)
+				{
+					checkCellExtremes(&bmb[firstBmbIdx], chainNumBmbs[chainIdx], chainIdx);
+				}
+				else
+				{
+					// Only the bricks between the extremes were read. The others keep their last reading
+					decodeBrickV(&bmb[firstBmbIdx], chainNumBmbs[chainIdx], dataBuffer[chainIdx], dataReadSuccess[chainIdx], extremesFirstBrick, extremesNumBricks);
 				}
 			}
-			else
-			{
-				DebugComm("Error during cellReg readAll!\n");
+			firstBmbIdx += chainNumBmbs[chainIdx];
+		}
+		lastScanLatencyMs = HAL_GetTick() - scanStartTick;
 
-				// Failed to acquire data. Set status to BAD
-				for (int32_t j = 0; j < numBmbs; j++)
+		// Low rate read back of the configuration on the slots planned for it. Runs before the next
+		// scan is configured so MEASUREEN and GPIO can be checked
+		if (activeSlot.products & SCAN_PRODUCT_BIT(SCAN_DIAGNOSTICS))
+		{
+			firstBmbIdx = 0;
+			for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+			{
+				if (chainNumBmbs[chainIdx] > 0)
 				{
-					// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-					const uint32_t bmbIdx = numBmbs - j - 1;
-					bmb[bmbIdx].brickVStatus[i] = BAD;
+					selectAsciChain(chainIdx);
+					auditBmbConfig(&bmb[firstBmbIdx], chainNumBmbs[chainIdx]);
 				}
+				firstBmbIdx += chainNumBmbs[chainIdx];
 			}
 		}
 
-		// Read VBLOCK register which is the total voltage of the segment
-		if (readAll(VBLOCK, recvBuffer, numBmbs))
+		// Start the next slot without AUTOBALSWDIS once it is due. If the readout ran
+		// past the slot period the next scan starts immediately
+		scanInProgress = false;
+		if (!balancingActive(bmb, numBmbs) && ((HAL_GetTick() - scanStartTick) >= scanSlotMs[acqProfile]))
 		{
-			for (uint8_t j = 0; j < numBmbs; j++)
+			startNextScans(chainNumBmbs, false);
+		}
+	}
+}
+
+/*!
+  @brief   Run the scan loop until the next scan is read out. Gives up once a scan and its slot
+		   should have completed
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @return  True if a scan was read out, false if it timed out
+*/
+bool runBmbScanToReadout(Bmb_S* bmb, const uint32_t* chainNumBmbs)
+{
+	asciStats.lastUpdateCycles = 0;
+	const uint32_t startTick = HAL_GetTick();
+	while ((asciStats.lastUpdateCycles == 0) && ((HAL_GetTick() - startTick) < (BMB_SCAN_TIMEOUT_MS + BMB_DATA_REFRESH_DELAY_MS)))
+	{
+		updateBmbData(bmb, chainNumBmbs);
+		osDelay(1);
+	}
+	return (asciStats.lastUpdateCycles != 0);
+}
+
+/*!
+  @brief   Measure the scan latency and the brick voltage noise of the first BMB with an
+		   acquisition profile. Noise is estimated from the difference of successive samples so
+		   the pack must be at rest. The profile is left selected
+  @param   profile - The acquisition profile
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   numScans - The number of scan readouts to run
+  @param   result - Updated with the latency, noise and number of samples measured
+*/
+void measureAcqProfile(Acq_Profile_E profile, Bmb_S* bmb, const uint32_t* chainNumBmbs, uint32_t numScans, Acq_Profile_Result_S* result)
+{
+	setAcqProfile(profile);
+	Bmb_S* pBmb = &bmb[0];
+	float lastBrickV[NUM_BRICKS_PER_BMB];
+	bool lastValid = false;
+	float sumSquaredDiffs = 0.0f;
+	uint32_t numDiffs = 0;
+	uint32_t totalLatencyMs = 0;
+	uint32_t numSamples = 0;
+	for (uint32_t i = 0; i < numScans; i++)
+	{
+		// Readouts without cell voltages leave the brick status untouched
+		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			pBmb->brickVCode[j] = SENSOR_READING(pBmb->brickVCode[j], UNINITIALIZED);
+		}
+
+		bool newSample = runBmbScanToReadout(bmb, chainNumBmbs) && (pBmb->brickVProfile == profile);
+		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			newSample &= (SENSOR_STATUS(pBmb->brickVCode[j]) == GOOD);
+		}
+		if (!newSample)
+		{
+			continue;
+		}
+
+		totalLatencyMs += lastScanLatencyMs;
+		numSamples++;
+		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			const float brickV = convertBrickV(pBmb->brickVCode[j]);
+			if (lastValid)
 			{
-				// Read block voltage in [15:2]
-				uint32_t segmentVRaw = getValueFromBuffer(recvBuffer, j) >> 2;
-				float segmentV = segmentVRaw * CONVERT_14BIT_TO_60V;
-				// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-				const uint32_t bmbIdx = numBmbs - j - 1;
-				bmb[bmbIdx].segmentV = segmentV;
-				bmb[bmbIdx].segmentVStatus = is14BitSensorRailed(segmentVRaw) ? BAD : GOOD;
+				const float diff = brickV - lastBrickV[j];
+				sumSquaredDiffs += diff * diff;
+				numDiffs++;
 			}
+			lastBrickV[j] = brickV;
 		}
-		else
-		{
-			DebugComm("Error during VBLOCK readAll!\n");
+		lastValid = true;
+	}
 
-			// Failed to acquire data. Set status to BAD
-			for (int32_t j = 0; j < numBmbs; j++)
+	// The difference of two independent samples has twice the variance of the noise
+	result->noiseUv = (numDiffs > 0) ? (sqrtf(sumSquaredDiffs / (2.0f * numDiffs)) * 1000000.0f) : 0.0f;
+	result->latencyMs = (numSamples > 0) ? ((float)totalLatencyMs / numSamples) : 0.0f;
+	result->numSamples = numSamples;
+}
+
+/*!
+  @brief   Plan the repeating scan schedule used by updateBmbData. Every scan slot is long enough
+		   for the scan and readout of the data it refreshes at the current ASCI SPI clock. The
+		   slot period follows the fastest target rate. Only the channels and registers a slot
+		   needs are scanned and read, and the temperatures share the mux one channel per slot
+  @param   periodMs - The target refresh period of each data product in ms, indexed by Scan_Product_E
+  @param   numBmbs - The number of BMBs on the longest daisy chain
+  @return  True if every target rate is met, false if some data is refreshed slower
+*/
+bool planBmbScans(const uint32_t* periodMs, uint32_t numBmbs)
+{
+	uint32_t slotMs = UINT32_MAX;
+	for (int32_t i = 0; i < NUM_SCAN_PRODUCTS; i++)
+	{
+		slotMs = (periodMs[i] < slotMs) ? periodMs[i] : slotMs;
+	}
+
+	const uint32_t targetSlotMs = (slotMs > 0) ? slotMs : 1;
+	slotMs = targetSlotMs;
+
+	// Stretch the slot period until the longest slot of the slowest profile fits. The schedule changes
+	// with the slot period so it is rebuilt each time
+	uint32_t requiredSlotMs[NUM_ACQ_PROFILES];
+	uint32_t slowestSlotMs = 0;
+	for (int32_t attempt = 0; attempt < SCAN_PLAN_ATTEMPTS; attempt++)
+	{
+		buildScanSchedule(periodMs, slotMs);
+		slowestSlotMs = 0;
+		for (int32_t profile = 0; profile < NUM_ACQ_PROFILES; profile++)
+		{
+			requiredSlotMs[profile] = 0;
+			for (uint32_t i = 0; i < scanScheduleLength; i++)
 			{
-				// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-				const uint32_t bmbIdx = numBmbs - j - 1;
-				bmb[bmbIdx].segmentVStatus = BAD;
+				const uint32_t estimatedMs = estimateScanSlotMs(&scanSchedule[i], numBmbs, profile);
+				requiredSlotMs[profile] = (estimatedMs > requiredSlotMs[profile]) ? estimatedMs : requiredSlotMs[profile];
 			}
+			slowestSlotMs = (requiredSlotMs[profile] > slowestSlotMs) ? requiredSlotMs[profile] : slowestSlotMs;
+		}
+		if (slowestSlotMs <= slotMs)
+		{
+			break;
+		}
+		slotMs = slowestSlotMs;
+	}
+
+	// Faster profiles run the same schedule with a shorter slot, down to the fastest target
+	slowestSlotMs = 0;
+	for (int32_t profile = 0; profile < NUM_ACQ_PROFILES; profile++)
+	{
+		scanSlotMs[profile] = (requiredSlotMs[profile] > targetSlotMs) ? requiredSlotMs[profile] : targetSlotMs;
+		slowestSlotMs = (scanSlotMs[profile] > slowestSlotMs) ? scanSlotMs[profile] : slowestSlotMs;
+		DebugComm("Scan plan profile %ld: %lu slots of %lu ms\n", profile, scanScheduleLength, scanSlotMs[profile]);
+	}
+	// The next scan starts at the beginning of the schedule
+	scanScheduleIdx = scanScheduleLength - 1;
+
+	bool ratesMet = true;
+	for (int32_t i = 0; i < NUM_SCAN_PRODUCTS; i++)
+	{
+		const uint32_t achievedMs = measureScanPeriodMs(i, slowestSlotMs);
+		if (achievedMs > periodMs[i])
+		{
+			DebugComm("Scan product %ld refreshed every %lu ms - target %lu ms\n", i, achievedMs, periodMs[i]);
+			ratesMet = false;
 		}
+	}
+	return ratesMet;
+}
+
+/*!
+  @brief   Read the hardware alert registers of all BMBs on every daisy chain. The BMBs compare
+		   every brick against the OV/UV thresholds after each scan, so this catches a brick
+		   limit without waiting for a scan readout. It is far cheaper than a readout and can run
+		   between them. BMBs found reset are flagged for reinitialization
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @return  True if the alert registers were read from all BMBs, false otherwise
+*/
+bool pollBmbAlerts(Bmb_S* bmb, const uint32_t* chainNumBmbs)
+{
+	Chain_Block_Read_S reads[NUM_ASCI_CHAINS];
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		reads[chainIdx] = (Chain_Block_Read_S) { alertBuffer[chainIdx], alertReadSuccess[chainIdx], chainNumBmbs[chainIdx] };
+	}
+	const bool success = readAllBlockChains(ALERT_BLOCK_START, NUM_ALERT_READS, reads);
 
-		// Read AUX/TEMP registers
-		for (int32_t auxChannel = AIN1; auxChannel <= AIN2; auxChannel++)
+	// Registers that could not be read keep the last alerts
+	uint32_t firstBmbIdx = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		const uint32_t numBmbs = chainNumBmbs[chainIdx];
+		for (uint32_t j = 0; j < numBmbs; j++)
 		{
-			if (readAll(auxChannel, recvBuffer, numBmbs))
+			// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB)
+			Bmb_S* pBmb = &bmb[firstBmbIdx + numBmbs - j - 1];
+			if (alertReadSuccess[chainIdx][STATUS_READ_IDX] && (getValueFromBuffer(alertBuffer[chainIdx][STATUS_READ_IDX], j) & ALRTRST))
 			{
-				// Parse received data
-				for (uint32_t j = 0; j < numBmbs; j++)
-				{
-					// Read AUX voltage in [15:4]
-					uint32_t auxRaw = getValueFromBuffer(recvBuffer, j) >> 4;
-					float auxV = auxRaw * CONVERT_12BIT_TO_3V3;
-
-					// Convert temp voltage registers to temperature readings
-					if(muxState == MUX7 || muxState == MUX8) // NTC/ON-Board Temp Channel
-					{
-						// Ternary statements used to resolve index of NTC channel from mux position and ain port
-						// NTC1: MUX7 (1) + AIN2 (-1)	= Index 0
-						// NTC2: MUX7 (1) + AIN1 (0)	= Index 1
-						// NTC3: MUX8 (3) + AIN2 (-1)	= Index 2
-						// NTC4: MUX8 (3) + AIN1 (0)	= Index 3
-						const uint32_t ntcIdx = ((muxState == MUX7) ? 1 : 3) + ((auxChannel == AIN1) ? 0 : -1);
-						// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-						const uint32_t bmbIdx = numBmbs - j - 1;
-						bmb[bmbIdx].boardTemp[ntcIdx] = lookup(auxV, &ntcTable);
-						bmb[bmbIdx].boardTempStatus[ntcIdx] = is12BitSensorRailed(auxRaw) ? BAD : GOOD;
-						// TODO Add board temp status
-					}
-					else // Zener/Brick Temp Channel
-					{
-						const uint32_t brickIdx = muxState + ((auxChannel == AIN2) ? (NUM_BRICKS_PER_BMB/2) : 0);
-						// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-						const uint32_t bmbIdx = numBmbs - j - 1;
-						bmb[bmbIdx].brickTemp[brickIdx] = lookup(auxV, &zenerTable);
-						bmb[bmbIdx].brickTempStatus[brickIdx] = is12BitSensorRailed(auxRaw) ? BAD : GOOD;
-					}
-				}
+				// A reset BMB has lost its thresholds
+				pBmb->reinitRequired = true;
 			}
-			else
+			if (alertReadSuccess[chainIdx][ALRTOVCELL_READ_IDX])
 			{
-				DebugComm("Error during TEMP readAll!\n");
-				// Failed to acquire data. Set status to BAD
-				for (int32_t j = 0; j < numBmbs; j++)
-				{
-					if(muxState == MUX7 || muxState == MUX8) // NTC/ON-Board Temp Channel
-					{
-						// Ternary statements used to resolve index of NTC channel from mux position and ain port
-						// NTC1: MUX7 (1) + AIN2 (-1)	= Index 0
-						// NTC2: MUX7 (1) + AIN1 (0)	= Index 1
-						// NTC3: MUX8 (3) + AIN2 (-1)	= Index 2
-						// NTC4: MUX8 (3) + AIN1 (0)	= Index 3
-						const uint32_t ntcIdx = ((muxState == MUX7) ? 1 : 3) + ((auxChannel == AIN1) ? 0 : -1);
-						// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-						const uint32_t bmbIdx = numBmbs - j - 1;
-						bmb[bmbIdx].boardTempStatus[ntcIdx] = BAD;
-					}
-					else
-					{
-						const uint32_t brickIdx = muxState + ((auxChannel == AIN2) ? (NUM_BRICKS_PER_BMB/2) : 0);
-						// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB) 
-						const uint32_t bmbIdx = numBmbs - j - 1;
-						bmb[bmbIdx].brickTempStatus[brickIdx] = BAD;
-					}
-				}
+				pBmb->ovBrickAlerts = getValueFromBuffer(alertBuffer[chainIdx][ALRTOVCELL_READ_IDX], j) & ALRTEN_BRICK_CHANNELS;
+			}
+			if (alertReadSuccess[chainIdx][ALRTUVCELL_READ_IDX])
+			{
+				pBmb->uvBrickAlerts = getValueFromBuffer(alertBuffer[chainIdx][ALRTUVCELL_READ_IDX], j) & ALRTEN_BRICK_CHANNELS;
 			}
 		}
+		firstBmbIdx += numBmbs;
+	}
 
-		// Cycle to next MUX configuration
-		muxState = (muxState + 1) % NUM_MUX_CHANNELS;
-		setMux(numBmbs, muxState);
+	if (!success)
+	{
+		DebugComm("Error during alert readAll!\n");
+	}
+	return success;
+}
 
-		// Start acquisition for next function call with 32 oversamples and AUTOBALSWDIS
-		startScan(numBmbs);
+/*!
+  @brief   Select the acquisition profile used from the next scan on
+  @param   profile - The acquisition profile
+*/
+void setAcqProfile(Acq_Profile_E profile)
+{
+	if (profile < NUM_ACQ_PROFILES)
+	{
+		acqProfile = profile;
 	}
 }
 
+/*!
+  @brief   Get the acquisition profile selected for the next scan
+  @return  The acquisition profile
+*/
+Acq_Profile_E getAcqProfile()
+{
+	return acqProfile;
+}
+
+/*!
+  @brief   Get the time from the start of the last scan read out to its data being decoded
+  @return  The scan latency in ms
+*/
+uint32_t getLastScanLatencyMs()
+{
+	return lastScanLatencyMs;
+}
+
+/*!
+  @brief   Get the scan slot period planned for an acquisition profile
+  @param   profile - The acquisition profile
+  @return  The slot period in ms
+*/
+uint32_t getScanSlotMs(Acq_Profile_E profile)
+{
+	return (profile < NUM_ACQ_PROFILES) ? scanSlotMs[profile] : 0;
+}
+
+/*!
+  @brief   Estimate the SPI transfer time of a scan readout on the selected daisy chain
+  @param   numBmbs - The number of BMBs on the daisy chain
+  @return  The estimated transfer time in us
+*/
+uint32_t estimateScanReadoutUs(uint32_t numBmbs)
+{
+	return estimateReadAllBlockUs(NUM_DATA_READS, numBmbs);
+}
+
 /*!
   @brief   Set a given mux configuration on all BMBs
   @param   numBmbs - The expected number of BMBs in the daisy chain
@@ -400,7 +1639,7 @@ void updateBmbData(Bmb_S* bmb, uint32_t numBmbs)
 void setMux(uint32_t numBmbs, uint8_t muxSetting)
 {
 	// Last 3 bits set GPIO logic state for channels 2, 1, 0 respectively
-	uint16_t gpioData = 0xF000 | (muxSetting & 0x07);
+	uint16_t gpioData = GPIO_MUX_OUTPUTS_ENABLED | (muxSetting & GPIO_MUX_SELECT_MASK);
 	writeAll(GPIO, gpioData, numBmbs);
 }
 
@@ -411,22 +1650,24 @@ void setMux(uint32_t numBmbs, uint8_t muxSetting)
 */
 void aggregateBmbData(Bmb_S* bmb, uint32_t numBmbs)
 {
-	// Iterate through brick voltages
-	for (int32_t i = 0; i < numBmbs; i++)
+	// Min/max statistics are gathered on the raw codes and only the results are converted. Temperature
+	// falls as the sensor code rises so the hottest sensor has the lowest code. The temperature curve
+	// is not linear so average temperatures are taken over the converted readings
+	for (uint32_t i = 0; i < numBmbs; i++)
 	{
 		Bmb_S* pBmb = &bmb[i];
-		float maxBrickV = MIN_VOLTAGE_SENSOR_VALUE_V;
-		float minBrickV = MAX_VOLTAGE_SENSOR_VALUE_V;
-		float sumV	= 0.0f;
+		uint16_t maxBrickVCode = 0;
+		uint16_t minBrickVCode = SENSOR_CODE_MASK;
+		uint32_t brickVCodeSum = 0;
 		uint32_t numGoodBrickV = 0;
 
-		float maxBrickTemp = MIN_TEMP_SENSOR_VALUE_C;
-		float minBrickTemp = MAX_TEMP_SENSOR_VALUE_C;
+		uint16_t maxBrickTempCode = SENSOR_CODE_MASK;
+		uint16_t minBrickTempCode = 0;
 		float brickTempSum = 0.0f;
 		uint32_t numGoodBrickTemp = 0;
 
-		float maxBoardTemp = MIN_TEMP_SENSOR_VALUE_C;
-		float minBoardTemp = MAX_TEMP_SENSOR_VALUE_C;
+		uint16_t maxBoardTempCode = SENSOR_CODE_MASK;
+		uint16_t minBoardTempCode = 0;
 		float boardTempSum = 0.0f;
 		uint32_t numGoodBoardTemp = 0;
 
@@ -434,82 +1675,137 @@ void aggregateBmbData(Bmb_S* bmb, uint32_t numBmbs)
 		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
 		{
 			// Only update stats if sense status is good
-			if (pBmb->brickVStatus[j] == GOOD)
+			if (SENSOR_STATUS(pBmb->brickVCode[j]) == GOOD)
 			{
-				float brickV = pBmb->brickV[j];
+				const uint16_t brickVCode = SENSOR_CODE(pBmb->brickVCode[j]);
 
-				if (brickV > maxBrickV)
+				if (brickVCode > maxBrickVCode)
 				{
-					maxBrickV = brickV;
+					maxBrickVCode = brickVCode;
 				}
-				if (brickV < minBrickV)
+				if (brickVCode < minBrickVCode)
 				{
-					minBrickV = brickV;
+					minBrickVCode = brickVCode;
 				}
 				numGoodBrickV++;
-				sumV += brickV;
+				brickVCodeSum += brickVCode;
 			}
 
 			// Only update stats if sense status is good
-			if (pBmb->brickTempStatus[j] == GOOD)
+			if (SENSOR_STATUS(pBmb->brickTempCode[j]) == GOOD)
 			{
-				float brickTemp = pBmb->brickTemp[j];
+				const uint16_t brickTempCode = SENSOR_CODE(pBmb->brickTempCode[j]);
 
-				if (brickTemp > maxBrickTemp)
+				if (brickTempCode < maxBrickTempCode)
 				{
-					maxBrickTemp = brickTemp;
+					maxBrickTempCode = brickTempCode;
 				}
-				if (brickTemp < minBrickTemp)
+				if (brickTempCode > minBrickTempCode)
 				{
-					minBrickTemp = brickTemp;
+					minBrickTempCode = brickTempCode;
 				}
 				numGoodBrickTemp++;
-				brickTempSum += brickTemp;
+				brickTempSum += convertBrickTemp(brickTempCode);
 			}
 		}
 
 		// Aggregate board temp data
 		for (int32_t j = 0; j < NUM_BOARD_TEMP_PER_BMB; j++)
 		{
-			if (pBmb->boardTempStatus[j] == GOOD)
+			if (SENSOR_STATUS(pBmb->boardTempCode[j]) == GOOD)
 			{
-				float boardTemp = pBmb->boardTemp[j];
+				const uint16_t boardTempCode = SENSOR_CODE(pBmb->boardTempCode[j]);
 
-				if (boardTemp > maxBoardTemp)
+				if (boardTempCode < maxBoardTempCode)
 				{
-					maxBoardTemp = boardTemp;
+					maxBoardTempCode = boardTempCode;
 				}
-				if (boardTemp < minBoardTemp)
+				if (boardTempCode > minBoardTempCode)
 				{
-					minBoardTemp = boardTemp;
+					minBoardTempCode = boardTempCode;
 				}
 				numGoodBoardTemp++;
-				boardTempSum += boardTemp;
+				boardTempSum += convertBoardTemp(boardTempCode);
 			}
 		}
 
 		// Update BMB statistics
-		pBmb->maxBrickV = maxBrickV;
-		pBmb->minBrickV = minBrickV;
-		pBmb->sumBrickV	= sumV;
-		pBmb->avgBrickV = (numGoodBrickV == 0) ? pBmb->avgBrickV : sumV / numGoodBrickV;
+		pBmb->maxBrickVCode = maxBrickVCode;
+		pBmb->minBrickVCode = minBrickVCode;
+		pBmb->maxBrickV = convertBrickV(maxBrickVCode);
+		pBmb->minBrickV = convertBrickV(minBrickVCode);
+		pBmb->sumBrickV	= brickVCodeSum * CONVERT_14BIT_TO_5V;
+		pBmb->avgBrickV = (numGoodBrickV == 0) ? pBmb->avgBrickV : pBmb->sumBrickV / numGoodBrickV;
 		pBmb->numBadBrickV = NUM_BRICKS_PER_BMB - numGoodBrickV;
 
-		pBmb->maxBrickTemp = maxBrickTemp;
-		pBmb->minBrickTemp = minBrickTemp;
-		pBmb->avgBrickTemp = (numGoodBrickTemp == 0) ? pBmb->avgBrickTemp :  brickTempSum / numGoodBrickTemp;
+		pBmb->maxBrickTemp = convertBrickTemp(maxBrickTempCode);
+		pBmb->minBrickTemp = convertBrickTemp(minBrickTempCode);
+		pBmb->avgBrickTemp = (numGoodBrickTemp == 0) ? pBmb->avgBrickTemp : brickTempSum / numGoodBrickTemp;
 		pBmb->numBadBrickTemp = NUM_BRICKS_PER_BMB - numGoodBrickTemp;
 
-		pBmb->maxBoardTemp = maxBoardTemp;
-		pBmb->minBoardTemp = minBoardTemp;
+		pBmb->maxBoardTemp = convertBoardTemp(maxBoardTempCode);
+		pBmb->minBoardTemp = convertBoardTemp(minBoardTempCode);
 		pBmb->avgBoardTemp = (numGoodBoardTemp == 0) ? pBmb->avgBoardTemp : boardTempSum / numGoodBoardTemp;
 		pBmb->numBadBoardTemp = NUM_BOARD_TEMP_PER_BMB - numGoodBoardTemp;
 	}
 }
 
+/*!
+  @brief   Convert a brick voltage reading to volts
+  @param   reading - The brick voltage reading
+  @return  The brick voltage in V
+*/
+float convertBrickV(uint16_t reading)
+{
+	return SENSOR_CODE(reading) * CONVERT_14BIT_TO_5V;
+}
+
+/*!
+  @brief   Convert a segment voltage reading to volts
+  @param   reading - The segment voltage reading
+  @return  The segment voltage in V
+*/
+float convertSegmentV(uint16_t reading)
+{
+	return SENSOR_CODE(reading) * CONVERT_14BIT_TO_60V;
+}
+
+/*!
+  @brief   Convert a brick temp sensor reading to degrees
+  @param   reading - The brick temp sensor reading
+  @return  The brick temperature in C
+*/
+float convertBrickTemp(uint16_t reading)
+{
+	return lookup(SENSOR_CODE(reading) * CONVERT_12BIT_TO_3V3, &zenerTable);
+}
+
+/*!
+  @brief   Convert a board temp sensor reading to degrees
+  @param   reading - The board temp sensor reading
+  @return  The board temperature in C
+*/
+float convertBoardTemp(uint16_t reading)
+{
+	return lookup(SENSOR_CODE(reading) * CONVERT_12BIT_TO_3V3, &ntcTable);
+}
+
+/*!
+  @brief   Convert a brick temperature threshold to a brick temp sensor code. The code falls as
+		   the temperature rises
+  @param   temp - The brick temperature in C
+  @return  The 12 bit AUX code
+*/
+uint16_t convertBrickTempToCode(float temp)
+{
+	return (uint16_t)((reverseLookup(temp, &zenerTable) / CONVERT_12BIT_TO_3V3) + 0.5f);
+}
+
 
 /*!
-  @brief   Determine where a BMB daisy chain break has occured
+  @brief   Determine where a break has occured on the selected BMB daisy chain. The break is located
+		   by bisection so only O(log n) BMBs have internal loopback enabled. The last known break
+		   location on the chain is checked first
   @param   bmb - The array containing BMB data
   @param   numBmbs - The expected number of BMBs in the daisy chain
   @returns bmb index of BMB where communication failed (1 indexed)
@@ -517,31 +1813,72 @@ void aggregateBmbData(Bmb_S* bmb, uint32_t numBmbs)
 */
 int32_t detectBmbDaisyChainBreak(Bmb_S* bmb, uint32_t numBmbs)
 {
-	// Iterate through BMB indexes and determine if a daisy chain break exists
-	for (uint32_t bmbIdx = 0; bmbIdx < numBmbs; bmbIdx++)
+	(void)bmb;	// Only probes the chain, the BMB data is left as it is
+#if DEBUG_COMM
+	const uint32_t startTick = HAL_GetTick();
+#endif
+	uint32_t numProbes = 0;
+	int32_t loopbackIdx = -1;
+
+	// Bisect for the first BMB that can not be reached. Every BMB below lowIdx is known to be
+	// reachable and the BMB at highIdx is known to be unreachable (numBmbs if none found yet)
+	uint32_t lowIdx = 0;
+	uint32_t highIdx = numBmbs;
+
+	// A break usually stays in the same place between searches - confirm the last known location first
+	uint32_t* lastBreakPos = &lastChainBreakPos[getAsciChain()];
+	if ((*lastBreakPos > 0) && (*lastBreakPos <= numBmbs))
 	{
-		if (!setBmbInternalLoopback(bmbIdx, true)) { return bmbIdx + 1; }
-
-		// Determine if loopback communication is restored
-		memset(recvBuffer, 0, sizeof(recvBuffer));
-		readAll(VERSION, recvBuffer, bmbIdx + 1);
-
-		for (uint32_t i = 0; i < bmbIdx + 1; i++)
+		const uint32_t lastBreakIdx = *lastBreakPos - 1;
+		numProbes++;
+		if (probeDaisyChain(lastBreakIdx, &loopbackIdx))
+		{
+			lowIdx = lastBreakIdx + 1;
+		}
+		else
 		{
-			// Read model number in [15:4] to verify succesful communication
-			uint32_t versionRegister = getValueFromBuffer(recvBuffer, i) >> 4;
-			if (versionRegister != VERSION_DEFAULT_CONTENT)
+			highIdx = lastBreakIdx;
+			if (highIdx > 0)
 			{
-				// Broken link detected. Convert bmbIdx from 0-indexed to 1-indexed value 
-				return bmbIdx + 1;
+				numProbes++;
+				if (probeDaisyChain(highIdx - 1, &loopbackIdx))
+				{
+					lowIdx = highIdx;
+				}
+				else
+				{
+					highIdx = highIdx - 1;
+				}
 			}
 		}
+	}
+
+	while (lowIdx < highIdx)
+	{
+		const uint32_t midIdx = lowIdx + (highIdx - lowIdx) / 2;
+		numProbes++;
+		if (probeDaisyChain(midIdx, &loopbackIdx))
+		{
+			lowIdx = midIdx + 1;
+		}
+		else
+		{
+			highIdx = midIdx;
+		}
+	}
 
-		// No issue detected yet. Disable internal loopback and continue looking
-		if (!setBmbInternalLoopback(bmbIdx, false)) { return bmbIdx + 1; }
+	DebugComm("Daisy chain break search took %lu ms and %lu loopback probes\n", HAL_GetTick() - startTick, numProbes);
+
+	if (highIdx < numBmbs)
+	{
+		// Broken link detected. Convert bmbIdx from 0-indexed to 1-indexed value
+		*lastBreakPos = highIdx + 1;
+		return highIdx + 1;
 	}
+
 	// No errors detected - enable internal loopback on final BMB
-	if (!setBmbInternalLoopback(numBmbs-1, true)) { return -1; }
+	*lastBreakPos = 0;
+	if ((loopbackIdx != (int32_t)numBmbs - 1) && !probeDaisyChain(numBmbs - 1, &loopbackIdx)) { return -1; }
 	return 0;
 }
 
@@ -551,29 +1888,113 @@ int32_t detectBmbDaisyChainBreak(Bmb_S* bmb, uint32_t numBmbs)
   @param   bmb - The array containing BMB data
   @param   numBmbs - The expected number of BMBs in the daisy chain
 */
-void detectPowerOnReset(Bmb_S* bmb, uint32_t numBmbs)
+bool detectPowerOnReset(Bmb_S* bmb, uint32_t numBmbs)
 {
 	if (readAll(STATUS, recvBuffer, numBmbs))
 	{
 		for (uint8_t j = 0; j < numBmbs; j++)
 		{
 			// Read ALRTRST in STATUS [15]
-			const bool por = (recvBuffer[3 + j] & ALRTRST) != 0;
+			const bool por = (getValueFromBuffer(recvBuffer, j) & ALRTRST) != 0;
 			if (por)
 			{
-				bmb[j].reinitRequired = true;
+				// Convert from frame index (starts with last BMB) to bmb index (starts with first BMB)
+				bmb[numBmbs - j - 1].reinitRequired = true;
 			}
 		}
+		return true;
 	}
 	else
 	{
 		DebugComm("Error during STATUS readAll!\n");
+		return false;
+	}
+}
+
+/*!
+  @brief   Detect BMBs that were reset since they were configured and rewrite only their
+		   configuration
+  @param   bmb - The array containing BMB data
+  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @returns The number of BMBs reinitialized, -1 if the BMBs could not be checked or reinitialized
+*/
+int32_t reinitResetBmbs(Bmb_S* bmb, uint32_t numBmbs)
+{
+	if (!detectPowerOnReset(bmb, numBmbs))
+	{
+		// A reset BMB no longer increments the alive counter. Re-enable it on all BMBs and check again
+		writeAll(DEVCFG1, DEVCFG1_CONFIG, numBmbs);
+		if (!detectPowerOnReset(bmb, numBmbs))
+		{
+			return -1;
+		}
+	}
+
+	int32_t numReinitialized = 0;
+	for (uint32_t bmbIdx = 0; bmbIdx < numBmbs; bmbIdx++)
+	{
+		if (bmb[bmbIdx].reinitRequired)
+		{
+			DebugComm("BMB %lu was reset - rewriting configuration\n", bmbIdx + 1);
+			if (!reinitBmb(bmbIdx, numBmbs))
+			{
+				return -1;
+			}
+			bmb[bmbIdx].reinitRequired = false;
+			numReinitialized++;
+		}
 	}
+	return numReinitialized;
 }
 
 /*!
-  @brief   Determine which bricks need to be balanced
+  @brief   Determine whether any BMB was found reset and still needs its configuration rewritten
   @param   bmb - The array containing BMB data
+  @param   numBmbs - The number of BMBs in the array
+  @returns True if any BMB requires reinitialization, false otherwise
+*/
+bool bmbReinitRequired(Bmb_S* bmb, uint32_t numBmbs)
+{
+	for (uint32_t bmbIdx = 0; bmbIdx < numBmbs; bmbIdx++)
+	{
+		if (bmb[bmbIdx].reinitRequired)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+/*!
+  @brief   Run a targeted diagnostic read on the BMB with the worst link error rate, if any link
+		   is suspect. The result is recorded in the BMB link statistics
+  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @returns The daisy chain position of the BMB checked, -1 if no link is suspect
+*/
+int32_t diagnoseSuspectBmbLink(uint32_t numBmbs)
+{
+	const int32_t suspectIdx = getSuspectBmbLink(numBmbs);
+	if (suspectIdx < 0)
+	{
+		return -1;
+	}
+
+	// Only the suspect BMB responds to a readDevice so the result is charged to it alone.
+	// CRC and alive-counter failures are recorded by readDevice
+	if (readDevice(VERSION, recvBuffer, suspectIdx))
+	{
+		const uint32_t versionRegister = getValueFromBuffer(recvBuffer, 0) >> 4;
+		if (versionRegister != VERSION_DEFAULT_CONTENT)
+		{
+			recordBmbVersionMismatch(suspectIdx);
+		}
+	}
+	return suspectIdx;
+}
+
+/*!
+  @brief   Determine which bricks need to be balanced on the selected daisy chain
+  @param   bmb - The array containing BMB data of the selected daisy chain
   @param   numBmbs - The expected number of BMBs in the daisy chain
 */
 void balanceCells(Bmb_S* bmb, uint32_t numBmbs)
@@ -583,7 +2004,9 @@ void balanceCells(Bmb_S* bmb, uint32_t numBmbs)
 	// Iterate through the array starting with the highest voltage and enable balancing switch
 	// if neighboring cells aren't being balanced. This is due to the circuit not allowing 
 	// neighboring cells to be balanced. 
-	for (int32_t bmbIdx = 0; bmbIdx < numBmbs; bmbIdx++)
+	// Brick temperature falls as its sensor code rises
+	const uint16_t maxBleedTempCode = convertBrickTempToCode(MAX_CELL_TEMP_BLEEDING_ALLOWED_C);
+	for (uint32_t bmbIdx = 0; bmbIdx < numBmbs; bmbIdx++)
 	{
 		uint32_t numBricksNeedBalancing = 0;
 		Brick_S bricksToBalance[NUM_BRICKS_PER_BMB];
@@ -595,11 +2018,11 @@ void balanceCells(Bmb_S* bmb, uint32_t numBmbs)
 				// Add brick to list of bricks that need balancing if balancing requested, brick
 				// isn't too hot, and the brick voltage is above the bleed threshold
 				if (bmb[bmbIdx].balSwRequested[brickIdx] &&
-					bmb[bmbIdx].brickTemp[brickIdx] < MAX_CELL_TEMP_BLEEDING_ALLOWED_C &&
-					bmb[bmbIdx].brickV[brickIdx] > MIN_BLEED_TARGET_VOLTAGE_V)
+					SENSOR_CODE(bmb[bmbIdx].brickTempCode[brickIdx]) > maxBleedTempCode &&
+					SENSOR_CODE(bmb[bmbIdx].brickVCode[brickIdx]) > BRICK_V_TO_CODE(MIN_BLEED_TARGET_VOLTAGE_V))
 				{
 					// Brick needs to be balanced, add to array
-					bricksToBalance[numBricksNeedBalancing++] = (Brick_S) { .brickIdx = brickIdx, .brickV = bmb[bmbIdx].brickV[brickIdx] };
+					bricksToBalance[numBricksNeedBalancing++] = (Brick_S) { .brickIdx = brickIdx, .brickVCode = SENSOR_CODE(bmb[bmbIdx].brickVCode[brickIdx]) };
 				}
 			}
 		}
@@ -640,6 +2063,6 @@ void balanceCells(Bmb_S* bmb, uint32_t numBmbs)
 			}
 		}
 		// Update the BMB balance switches in hardware
-		updateBmbBalanceSwitches(&bmb[bmbIdx]);
+		updateBmbBalanceSwitches(&bmb[bmbIdx], bmbIdx);
 	}
 }
@@ -9,6 +9,9 @@
 #include "bmbUtils.h"
 #include "leakyBucket.h"
 #include "utils.h"
+#if ASCI_SIMULATION
+#include "asciSim.h"
+#endif
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
@@ -16,12 +19,137 @@
 
 #define BYTES_PER_BMB_REGISTER 2
 #define READ_CMD_LENGTH 	   1
+// The longest ASCI + BMB command frame that can be loaded into the TX queue (writeAll/writeDevice)
+#define MAX_ASCI_CMD_LENGTH    8
+// Command frames are cached for BMB registers 0x00 (VERSION) through 0x2E (AIN2)
+#define NUM_CACHED_REGISTERS   0x2F
+// CRC-8 polynomial used by the BMBs (reflected)
+#define CRC_POLY               0xB2
+// ASCI configuration registers R_RX_INTERRUPT_ENABLE through R_CONFIG_3 are shadowed. Indexed by address / 2
+#define NUM_SHADOW_REGISTERS   ((R_CONFIG_3 >> 1) + 1)
+
+// ASCI SPI transfers go to the daisy chain model when simulating
+#if ASCI_SIMULATION
+#define ASCI_SPI_TRANSMIT_IT(hspi, txData, size)					simAsciTransmit(hspi, txData, NULL, size)
+#define ASCI_SPI_TRANSMIT_RECEIVE_IT(hspi, txData, rxData, size)	simAsciTransmit(hspi, txData, rxData, size)
+#define ASCI_SPI_TRANSMIT_RECEIVE_DMA(hspi, txData, rxData, size)	simAsciTransmit(hspi, txData, rxData, size)
+#define ASCI_SPI_ABORT(hspi)										simAsciAbort(hspi)
+#define ASCI_SPI_ABORT_IT(hspi)										simAsciAbort(hspi)
+#else
+#define ASCI_SPI_TRANSMIT_IT(hspi, txData, size)					HAL_SPI_Transmit_IT(hspi, txData, size)
+#define ASCI_SPI_TRANSMIT_RECEIVE_IT(hspi, txData, rxData, size)	HAL_SPI_TransmitReceive_IT(hspi, txData, rxData, size)
+#define ASCI_SPI_TRANSMIT_RECEIVE_DMA(hspi, txData, rxData, size)	HAL_SPI_TransmitReceive_DMA(hspi, txData, rxData, size)
+#define ASCI_SPI_ABORT(hspi)										HAL_SPI_Abort(hspi)
+#define ASCI_SPI_ABORT_IT(hspi)										HAL_SPI_Abort_IT(hspi)
+#endif
+
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+	ASCI_IDLE = 0,				// No background transaction in progress
+	ASCI_CLR_RX_BUF,			// Clear the ASCI receive buffer
+	ASCI_CLR_TX_BUF,			// Clear the ASCI transmit buffer
+	ASCI_LOAD_QUEUE,			// Write the command frame into the load queue
+	ASCI_VERIFY_QUEUE,			// Read back the load queue and verify its contents
+	ASCI_WRITE_RX_INT_ENABLE,	// Enable RX_Error, RX_Overflow and RX_Stop interrupts
+	ASCI_VERIFY_RX_INT_ENABLE,	// Verify the RX interrupt enable register contents
+	ASCI_CLR_RX_INT_FLAGS,		// Clear the RX interrupt flags
+	ASCI_VERIFY_RX_INT_FLAGS,	// Verify that the RX interrupt flags were cleared
+	ASCI_SEND_MESSAGE,			// Release the loaded command onto the daisy chain
+	ASCI_WAIT_RX_STOP,			// Wait for the ASCI RX_Stop external interrupt
+	ASCI_READ_RX_STATUS,		// Verify that the interrupt was caused by RX_Stop
+	ASCI_READ_MESSAGE,			// Read the received message out of the ASCI receive buffer
+	ASCI_READ_NEXT_STATUS,		// Check whether the next message of a batch is in the receive buffer
+	ASCI_CHECK_RX_ERRORS,		// Check for errors before re-arming the RX_Stop interrupt
+	ASCI_REARM_RX_STOP,			// Clear the RX interrupt flags to wait for the next message of a batch
+	ASCI_READ_RX_INT_FLAGS		// Check for errors during the transaction
+} Asci_State_E;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	const uint8_t* sendFrame;					// ASCI + BMB command frame to be loaded into the TX queue
+	uint8_t  frameBuffer[MAX_ASCI_CMD_LENGTH] __ALIGNED(4);	// Storage for frames that are not cached
+	uint8_t* recvBuffer;						// Buffer the received message is read into
+	uint32_t numBytesToSend;
+	uint32_t numBytesToReceive;
+	uint8_t  recvCrc;							// CRC of the received message excluding the PEC and alive-counter bytes
+	bool     complete;							// Set once the message was sent and received without error
+} Asci_Message_S;
+
+typedef struct
+{
+	volatile Asci_State_E state;					// Current state of the transaction engine
+	Asci_Message_S messages[ASCI_MESSAGE_QUEUE_SIZE];
+	uint32_t numMessages;							// Number of messages queued for the current run
+	uint32_t messagesPerBatch;						// Max number of messages loaded into the load queues at once
+	uint32_t batchStart;							// Index of the first message in the current batch
+	uint32_t batchEnd;								// Index one past the last message in the current batch
+	uint32_t messageIdx;							// Index of the message currently being loaded, sent or read
+	uint32_t attemptNum;							// Attempts made at the current write and verify step
+	bool     rxStopRearmed;							// RX_Stop interrupt was re-armed while waiting for the next message
+	volatile bool rxStopPending;					// RX_Stop interrupt arrived before the engine started waiting for it
+	bool     queueVerifyFailed;						// The last load queue verify failed. Cleared by the next verify that passes
+	uint8_t  txBuffer[SPI_BUFF_SIZE] __ALIGNED(4);	// DMA transmit buffer for register accesses and ASCI commands
+	uint8_t  rxBuffer[SPI_BUFF_SIZE] __ALIGNED(4);	// DMA receive buffer for register accesses and queue verification
+} Asci_Engine_S;
+
+typedef struct
+{
+	SPI_HandleTypeDef* hspi;						// SPI bus the ASCI is connected to
+	GPIO_TypeDef* csPort;
+	uint16_t csPin;
+	GPIO_TypeDef* shdnPort;
+	uint16_t shdnPin;
+	uint16_t intPin;								// ASCI INT external interrupt pin
+	Asci_Engine_S engine;							// Transaction engine driving this chain
+	Asci_Link_Config_S linkConfig;					// SPI clock and keep-alive used on this chain
+
+	// Ready to send readAll frames for every cached register. The ASCI data length depends on the
+	// number of BMBs so the cache is rebuilt from readAllCrcTable whenever the chain length changes
+	uint8_t  readAllFrameCache[NUM_CACHED_REGISTERS][MAX_ASCI_CMD_LENGTH] __ALIGNED(4);
+	uint32_t readAllFrameCacheNumBmbs;
+	bool     readAllFrameCacheValid;
+
+	// Last value written and verified to each ASCI configuration register. Writes of an unchanged
+	// value are skipped. Invalidated on an ASCI reset or any detected link error
+	uint8_t  shadowRegisters[NUM_SHADOW_REGISTERS];
+	uint32_t shadowRegistersValid;
+} Asci_Chain_S;
+
+typedef struct
+{
+	Asci_Cmd_Stats_S* stats;		// Statistics of the command being timed
+	Asci_Cmd_Stats_S* prevStats;	// Statistics of the enclosing command, if any
+	uint32_t startCycles;
+} Cmd_Timer_S;
+
+typedef struct
+{
+	bool     active;
+	bool     exhausted;		// Set once a command was refused because the budget was spent
+	uint32_t startTick;
+	uint32_t budgetMs;
+} Comms_Budget_S;
+
 
 /* ==================================================================== */
 /* ======================= EXTERNAL VARIABLES ========================= */
 /* ==================================================================== */
 
 extern SPI_HandleTypeDef hspi1;
+#if NUM_ASCI_CHAINS > 1
+extern SPI_HandleTypeDef hspi3;
+#endif
+extern osThreadId mainTaskHandle;
 
 extern LeakyBucket_S asciCommsLeakyBucket;
 
@@ -30,6 +158,104 @@ extern LeakyBucket_S asciCommsLeakyBucket;
 /* ========================= LOCAL VARIABLES ========================== */
 /* ==================================================================== */
 
+// ASCI daisy chains, each with its own interrupt driven transaction engine. Messages are processed
+// back to back from the SPI and EXTI callbacks and the main task is only notified once a whole queue
+// has completed, so the engines of different chains run concurrently
+static Asci_Chain_S asciChains[NUM_ASCI_CHAINS] =
+{
+	{
+		.hspi = &hspi1, .csPort = CS_ASCI_GPIO_Port, .csPin = CS_ASCI_Pin,
+		.shdnPort = SHDN_GPIO_Port, .shdnPin = SHDN_Pin, .intPin = INT_Pin,
+		.engine = { .state = ASCI_IDLE },
+		.linkConfig = { .spiPrescaler = ASCI_DEFAULT_SPI_PRESCALER, .keepAlive = ASCI_DEFAULT_KEEP_ALIVE }
+	},
+#if NUM_ASCI_CHAINS > 1
+	{
+		.hspi = &hspi3, .csPort = CS_ASCI2_GPIO_Port, .csPin = CS_ASCI2_Pin,
+		.shdnPort = SHDN2_GPIO_Port, .shdnPin = SHDN2_Pin, .intPin = INT2_Pin,
+		.engine = { .state = ASCI_IDLE },
+		.linkConfig = { .spiPrescaler = ASCI_DEFAULT_SPI_PRESCALER, .keepAlive = ASCI_DEFAULT_KEEP_ALIVE }
+	},
+#endif
+};
+
+// Chain that commands are sent on. See selectAsciChain
+static Asci_Chain_S* activeChain = &asciChains[0];
+
+// CRC-8 (poly 0xB2, reflected) of every byte value. Processing a byte is crc = crcTable[crc ^ byte]
+static const uint8_t crcTable[256] =
+{
+	0x00, 0x3E, 0x7C, 0x42, 0xF8, 0xC6, 0x84, 0xBA, 0x95, 0xAB, 0xE9, 0xD7, 0x6D, 0x53, 0x11, 0x2F,
+	0x4F, 0x71, 0x33, 0x0D, 0xB7, 0x89, 0xCB, 0xF5, 0xDA, 0xE4, 0xA6, 0x98, 0x22, 0x1C, 0x5E, 0x60,
+	0x9E, 0xA0, 0xE2, 0xDC, 0x66, 0x58, 0x1A, 0x24, 0x0B, 0x35, 0x77, 0x49, 0xF3, 0xCD, 0x8F, 0xB1,
+	0xD1, 0xEF, 0xAD, 0x93, 0x29, 0x17, 0x55, 0x6B, 0x44, 0x7A, 0x38, 0x06, 0xBC, 0x82, 0xC0, 0xFE,
+	0x59, 0x67, 0x25, 0x1B, 0xA1, 0x9F, 0xDD, 0xE3, 0xCC, 0xF2, 0xB0, 0x8E, 0x34, 0x0A, 0x48, 0x76,
+	0x16, 0x28, 0x6A, 0x54, 0xEE, 0xD0, 0x92, 0xAC, 0x83, 0xBD, 0xFF, 0xC1, 0x7B, 0x45, 0x07, 0x39,
+	0xC7, 0xF9, 0xBB, 0x85, 0x3F, 0x01, 0x43, 0x7D, 0x52, 0x6C, 0x2E, 0x10, 0xAA, 0x94, 0xD6, 0xE8,
+	0x88, 0xB6, 0xF4, 0xCA, 0x70, 0x4E, 0x0C, 0x32, 0x1D, 0x23, 0x61, 0x5F, 0xE5, 0xDB, 0x99, 0xA7,
+	0xB2, 0x8C, 0xCE, 0xF0, 0x4A, 0x74, 0x36, 0x08, 0x27, 0x19, 0x5B, 0x65, 0xDF, 0xE1, 0xA3, 0x9D,
+	0xFD, 0xC3, 0x81, 0xBF, 0x05, 0x3B, 0x79, 0x47, 0x68, 0x56, 0x14, 0x2A, 0x90, 0xAE, 0xEC, 0xD2,
+	0x2C, 0x12, 0x50, 0x6E, 0xD4, 0xEA, 0xA8, 0x96, 0xB9, 0x87, 0xC5, 0xFB, 0x41, 0x7F, 0x3D, 0x03,
+	0x63, 0x5D, 0x1F, 0x21, 0x9B, 0xA5, 0xE7, 0xD9, 0xF6, 0xC8, 0x8A, 0xB4, 0x0E, 0x30, 0x72, 0x4C,
+	0xEB, 0xD5, 0x97, 0xA9, 0x13, 0x2D, 0x6F, 0x51, 0x7E, 0x40, 0x02, 0x3C, 0x86, 0xB8, 0xFA, 0xC4,
+	0xA4, 0x9A, 0xD8, 0xE6, 0x5C, 0x62, 0x20, 0x1E, 0x31, 0x0F, 0x4D, 0x73, 0xC9, 0xF7, 0xB5, 0x8B,
+	0x75, 0x4B, 0x09, 0x37, 0x8D, 0xB3, 0xF1, 0xCF, 0xE0, 0xDE, 0x9C, 0xA2, 0x18, 0x26, 0x64, 0x5A,
+	0x3A, 0x04, 0x46, 0x78, 0xC2, 0xFC, 0xBE, 0x80, 0xAF, 0x91, 0xD3, 0xED, 0x57, 0x69, 0x2B, 0x15
+};
+
+// CRC of the readAll BMB command {CMD_READ_ALL, address, DATA_CHECK} indexed by register address
+static const uint8_t readAllCrcTable[NUM_CACHED_REGISTERS] =
+{
+	0x58, 0x98, 0xBD, 0x7D, 0xF7, 0x37, 0x12, 0xD2,
+	0x63, 0xA3, 0x86, 0x46, 0xCC, 0x0C, 0x29, 0xE9,
+	0x2E, 0xEE, 0xCB, 0x0B, 0x81, 0x41, 0x64, 0xA4,
+	0x15, 0xD5, 0xF0, 0x30, 0xBA, 0x7A, 0x5F, 0x9F,
+	0xB4, 0x74, 0x51, 0x91, 0x1B, 0xDB, 0xFE, 0x3E,
+	0x8F, 0x4F, 0x6A, 0xAA, 0x20, 0xE0, 0xC5
+};
+
+// Partial CRC of the writeAll BMB command over {CMD_WRITE_ALL, address} indexed by register address.
+// The CRC of a full writeAll command is completed over the LSB and MSB of the value written
+static const uint8_t writeAllCrcSeedTable[NUM_CACHED_REGISTERS] =
+{
+	0xE5, 0xDB, 0x99, 0xA7, 0x1D, 0x23, 0x61, 0x5F,
+	0x70, 0x4E, 0x0C, 0x32, 0x88, 0xB6, 0xF4, 0xCA,
+	0xAA, 0x94, 0xD6, 0xE8, 0x52, 0x6C, 0x2E, 0x10,
+	0x3F, 0x01, 0x43, 0x7D, 0xC7, 0xF9, 0xBB, 0x85,
+	0x7B, 0x45, 0x07, 0x39, 0x83, 0xBD, 0xFF, 0xC1,
+	0xEE, 0xD0, 0x92, 0xAC, 0x16, 0x28, 0x6A
+};
+
+// Load queue verification policy
+static Queue_Verify_Policy_E queueVerifyPolicy = DEFAULT_QUEUE_VERIFY_POLICY;
+static uint32_t queueVerifyInterval = DEFAULT_QUEUE_VERIFY_INTERVAL;
+static uint32_t queueVerifyCount = 0;
+
+// Set once the CRC tables have been checked against calcCrc
+static bool frameTablesValid = false;
+
+// Statistics of the command currently in progress. Timeouts and frame errors are counted against it
+static Asci_Cmd_Stats_S* activeCmdStats = NULL;
+
+// Time budget shared by all commands and retries between startCommsBudget and endCommsBudget
+static Comms_Budget_S commsBudget = { .active = false };
+
+
+/* ==================================================================== */
+/* ========================= GLOBAL VARIABLES ========================= */
+/* ==================================================================== */
+
+// ASCI link instrumentation. Cycle counts are taken from the DWT cycle counter
+Asci_Stats_S asciStats;
+// Per command latency histograms and error counters
+Asci_Cmd_Stats_S asciCmdStats[NUM_ASCI_CMD_TYPES];
+// Per BMB link quality, indexed by chain and daisy chain position
+Bmb_Link_Stats_S bmbLinkStats[NUM_ASCI_CHAINS][LINK_STATS_MAX_BMBS];
+
+#if ASCI_FRAME_CAPTURE
+// Ring buffer of the most recent BMB command and response frames
+Asci_Frame_Capture_S asciCapture;
+#endif
 
 /* ==================================================================== */
 /* ======================== GLOBAL VARIABLES ========================== */
@@ -43,13 +269,15 @@ extern LeakyBucket_S asciCommsLeakyBucket;
 
 /*!
   @brief   Enable ASCI SPI
+  @param   chain - The ASCI daisy chain
 */
-static void csOn();
+static void csOn(Asci_Chain_S* chain);
 
 /*!
   @brief   Disable ASCI SPI
+  @param   chain - The ASCI daisy chain
 */
-static void csOff();
+static void csOff(Asci_Chain_S* chain);
 
 /*!
   @brief   Send a byte on SPI
@@ -89,10 +317,13 @@ static bool writeAndVerifyRegister(uint8_t registerAddress, uint8_t value);
 static uint8_t calcCrc(uint8_t* byteArr, uint32_t numBytes);
 
 /*!
-  @brief   Clears RX interrupt flags
-  @return  True if success, false otherwise
+  @brief   Continue a CRC calculation over a given set of bytes
+  @param   crc		The CRC of the bytes preceding byteArr
+  @param   byteArr	Pointer to array for which to continue the CRC
+  @param   numBytes	The number of bytes on which to continue the CRC
+  @return  uint8_t 	calculated CRC
 */
-static bool clearRxIntFlags();
+static uint8_t updateCrc(uint8_t crc, uint8_t* byteArr, uint32_t numBytes);
 
 /*!
   @brief   Determine whether or not the RX busy flag has been set
@@ -107,28 +338,272 @@ static bool readRxBusyFlag();
 static bool clearRxBusyFlag();
 
 /*!
-  @brief   Check whether or not RX error interupt flags were set
-  @return  True if errors exist, false otherwise
+  @brief   Start the SPI transfer for a given ASCI transaction engine state
+  @param   chain - The ASCI daisy chain
+  @param   state - The state to transition the engine into
 */
-static bool rxErrorsExist();
+static void startAsciState(Asci_Chain_S* chain, Asci_State_E state);
 
 /*!
-  @brief   Load the TX queue on the ASCI and verify that the content was
-  	  	   successfully written
-  @param   data_p - Array containing data to be written to the queue
-  @param   numBytes - Number of bytes to read from array to be written
-  	  	   	   	      to the queue
-  @return  True if success, false otherwise
+  @brief   Retry a write and verify step of the ASCI transaction engine or fail the
+		   current message if out of attempts
+  @param   chain - The ASCI daisy chain
+  @param   state - The write state to return to
 */
-static bool loadAndVerifyTxQueue(uint8_t *data_p, uint32_t numBytes);
+static void retryAsciState(Asci_Chain_S* chain, Asci_State_E state);
 
 /*!
-  @brief   Read the next SPI message in ASCI receive queue
-  @param   data_p - Location where data should be written to
-  @param   numBytesToRead - Number of bytes to read from queue to array
-  @return  True if success, false otherwise
+  @brief   Load the next message of the current batch into its load queue or continue to
+		   the RX interrupt setup once all messages of the batch are loaded
+  @param   chain - The ASCI daisy chain
+*/
+static void loadNextAsciQueue(Asci_Chain_S* chain);
+
+/*!
+  @brief   Start the next batch of queued messages in the ASCI transaction engine
+  @param   chain - The ASCI daisy chain
+*/
+static void startAsciBatch(Asci_Chain_S* chain);
+
+/*!
+  @brief   Complete the current batch of messages and start the next batch. Notify the
+		   main task once all queued messages have been processed
+  @param   chain - The ASCI daisy chain
+  @param   success - True if the batch transaction succeeded, false otherwise
+*/
+static void finishAsciBatch(Asci_Chain_S* chain, bool success);
+
+/*!
+  @brief   Prepare the transaction engine of a chain to run the messages loaded into it
+  @param   chain - The ASCI daisy chain
+  @param   numMessages - The number of messages loaded into the engine
+  @param   messagesPerBatch - The max number of messages to load into the ASCI load queues
+		   and send back to back. Limited to ASCI_NUM_LOAD_QUEUES
+*/
+static void loadAsciEngine(Asci_Chain_S* chain, uint32_t numMessages, uint32_t messagesPerBatch);
+
+/*!
+  @brief   Run the loaded transaction engines of a set of chains concurrently in the background
+		   and block until every engine has processed its whole queue
+  @param   chainMask - Bit n set to run the engine of chain n
+*/
+static void runAsciEngines(uint32_t chainMask);
+
+/*!
+  @brief   Run all messages loaded into the transaction engine of the selected chain in the
+		   background and block until the whole queue has been processed
+  @param   numMessages - The number of messages loaded into the engine
+  @param   messagesPerBatch - The max number of messages to load into the ASCI load queues
+		   and send back to back. Limited to ASCI_NUM_LOAD_QUEUES
+*/
+static void runAsciEngine(uint32_t numMessages, uint32_t messagesPerBatch);
+
+/*!
+  @brief   Load readAll messages for a set of requests into the transaction engine of a chain
+  @param   chain - The ASCI daisy chain to read from
+  @param   requests - Array of registers to read and buffers to read the data in to
+  @param   numRequests - The number of requests. Limited to ASCI_MESSAGE_QUEUE_SIZE
+  @param   numBmbs - The number of BMBs on the chain
+*/
+static void loadReadAllMessages(Asci_Chain_S* chain, ReadAllRequest_S* requests, uint32_t numRequests, uint32_t numBmbs);
+
+/*!
+  @brief   Verify the readAll messages run by the transaction engine of the selected chain and
+		   retry any failed read with readAll
+  @param   requests - The requests loaded by loadReadAllMessages. Updated with the result of each read
+  @param   numRequests - The number of requests
+  @param   numBmbs - The number of BMBs on the chain
+  @param   success - Cleared if any read failed
+  @return  The number of reads that fell back to readAll
+*/
+static uint32_t verifyReadAllMessages(ReadAllRequest_S* requests, uint32_t numRequests, uint32_t numBmbs, bool* success);
+
+/*!
+  @brief   Read a set of registers on the BMBs of one or more ASCI daisy chains. The reads are
+		   queued in the transaction engine of every chain ASCI_MESSAGE_QUEUE_SIZE at a time and
+		   the chains run concurrently. Any read that fails is retried with readAll on its chain.
+		   All queued read APIs go through here. Leaves the last chain read selected
+  @param   requests - Array of requests to run on each chain, NULL for a chain that is not read.
+		   Updated with the result of each read
+  @param   chainNumBmbs - The number of BMBs on each chain
+  @param   numRequests - The number of requests run on each chain
+  @return  True if all reads on all chains succeeded, false otherwise
+*/
+static bool readAllChains(ReadAllRequest_S* const* requests, const uint32_t* chainNumBmbs, uint32_t numRequests);
+
+/*!
+  @brief   Find the ASCI daisy chain on an SPI bus
+  @param   hspi - The SPI handle
+  @return  The chain on the SPI bus, NULL if there is none
+*/
+static Asci_Chain_S* findAsciChainBySpi(SPI_HandleTypeDef* hspi);
+
+/*!
+  @brief   Determine whether the load queue should be read back and verified according to
+		   the queue verification policy. Not consulted for a load following a failed verify
+  @return  True if the load queue should be verified, false otherwise
+*/
+static bool queueVerifyRequired();
+
+/*!
+  @brief   Determine whether an ASCI register is a configuration register held in the shadow cache
+  @param   registerAddress - The register address to check
+  @return  True if the register is shadowed, false otherwise
+*/
+static bool isShadowRegister(uint8_t registerAddress);
+
+/*!
+  @brief   Determine whether an ASCI configuration register is known to already hold a value
+  @param   chain - The ASCI daisy chain
+  @param   registerAddress - The register address to check
+  @param   value - The value to compare against
+  @return  True if the shadow cache holds the value for the register, false otherwise
+*/
+static bool shadowRegisterMatches(Asci_Chain_S* chain, uint8_t registerAddress, uint8_t value);
+
+/*!
+  @brief   Record a value written and verified to an ASCI configuration register
+  @param   chain - The ASCI daisy chain
+  @param   registerAddress - The register address that was written
+  @param   value - The value that was written
+*/
+static void updateShadowRegister(Asci_Chain_S* chain, uint8_t registerAddress, uint8_t value);
+
+/*!
+  @brief   Invalidate all shadowed ASCI configuration registers so that the next writes are
+		   sent and verified
+  @param   chain - The ASCI daisy chain
+*/
+static void invalidateShadowRegisters(Asci_Chain_S* chain);
+
+/*!
+  @brief   Start timing an ASCI command and make it the active command for error accounting
+  @param   timer - The timer to start
+  @param   type - The type of command being timed
+*/
+static void startCmdTimer(Cmd_Timer_S* timer, Asci_Cmd_Type_E type);
+
+/*!
+  @brief   Stop timing an ASCI command and record its latency, retries and result
+  @param   timer - The timer started for the command
+  @param   numAttempts - The number of attempts made by the command
+  @param   success - True if the command succeeded, false otherwise
+*/
+static void finishCmdTimer(Cmd_Timer_S* timer, uint32_t numAttempts, bool success);
+
+/*!
+  @brief   Stop timing an ASCI command that was abandoned because the communication time budget
+		   ran out. Only the abort is counted so that budget expiry is not reported as a link failure
+  @param   timer - The timer started for the command
+*/
+static void abortCmdTimer(Cmd_Timer_S* timer);
+
+/*!
+  @brief   Count CRC and alive-counter errors of a received frame against the active command
+  @param   crcValid - True if the frame CRC or command echo matched
+  @param   aliveCounterValid - True if the frame alive-counter matched
+*/
+static void recordFrameErrors(bool crcValid, bool aliveCounterValid);
+
+/*!
+  @brief   Update the link error rate of a BMB on the selected chain with a frame known to have reached it
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   error - True if the frame was corrupted at this BMB, false otherwise
+*/
+static void updateLinkErrorRate(uint32_t bmbIdx, bool error);
+
+/*!
+  @brief   Record the result of a chain wide frame (readAll, writeAll) in the BMB link statistics.
+		   An alive-counter of k < numBmbs means BMB k did not process the frame
+  @param   aliveCount - The received alive-counter
+  @param   crcValid - True if the frame CRC or command echo matched
+  @param   numBmbs - The number of BMBs we expect to process the frame
+*/
+static void recordChainLinkStats(uint8_t aliveCount, bool crcValid, uint32_t numBmbs);
+
+/*!
+  @brief   Record the result of a frame addressed to a single BMB (readDevice, writeDevice) in
+		   its link statistics
+  @param   bmbIdx - The daisy chain position of the addressed BMB
+  @param   crcValid - True if the frame CRC or command echo matched
+  @param   aliveCounterValid - True if the frame alive-counter matched
+*/
+static void recordDeviceLinkStats(uint32_t bmbIdx, bool crcValid, bool aliveCounterValid);
+
+/*!
+  @brief   Determine whether the current communication time budget has been spent
+  @return  True if a budget is active and spent, false otherwise
+*/
+static bool commsBudgetExpired();
+
+/*!
+  @brief   Get the time left in the current communication time budget
+  @return  The remaining time in ms, UINT32_MAX if no budget is active
+*/
+static uint32_t commsBudgetRemainingMs();
+
+#if ASCI_FRAME_CAPTURE
+/*!
+  @brief   Record a frame in the frame capture ring buffer, overwriting the oldest frame if full
+  @param   direction - Whether the frame was sent to or received from the daisy chain
+  @param   data - The frame data
+  @param   length - The number of bytes in the frame
+*/
+static void captureAsciFrame(Asci_Frame_Dir_E direction, const uint8_t* data, uint32_t length);
+#endif
+
+/*!
+  @brief   Build the ASCI + BMB command frame for a readAll command
+  @param   sendBuffer - Buffer to build the command frame in
+  @param   address - BMB register address to read from
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  The number of bytes in the command frame
+*/
+static uint32_t buildReadAllFrame(uint8_t* sendBuffer, uint8_t address, uint32_t numBmbs);
+
+/*!
+  @brief   Build the ASCI + BMB command frame for a writeAll command
+  @param   sendBuffer - Buffer to build the command frame in. Must hold MAX_ASCI_CMD_LENGTH bytes
+  @param   address - BMB register address to write to
+  @param   value - Value to write to the BMB register
+  @return  The number of bytes in the command frame
+*/
+static uint32_t buildWriteAllFrame(uint8_t* sendBuffer, uint8_t address, uint16_t value);
+
+/*!
+  @brief   Verify the CRC and alive-counter of a received readAll message
+  @param   recvBuffer - The received message, not including the read command byte
+  @param   calculatedCrc - The CRC calculated over the received message
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if the message is valid, false otherwise
+*/
+static bool readAllFrameValid(uint8_t* recvBuffer, uint8_t calculatedCrc, uint32_t numBmbs);
+
+/*!
+  @brief   Verify the CRC lookup table against the bitwise CRC definition and the precomputed
+		   frame tables against the frames built by calcCrc
+  @return  True if all table entries match, false otherwise
+*/
+static bool checkFrameTables();
+
+/*!
+  @brief   Get a ready to send readAll command frame
+  @param   chain - The ASCI daisy chain the frame is sent on
+  @param   address - BMB register address to read from
+  @param   numBmbs - The number of BMBs we expect to read from
+  @param   frameBuffer - Buffer to build the command frame in if the register is not cached
+  @param   numBytesToSend - Updated with the number of bytes in the command frame
+  @return  Pointer to the command frame
 */
-static bool readNextSpiMessage(uint8_t **data_p, uint32_t numBytesToRead);
+static const uint8_t* getReadAllFrame(Asci_Chain_S* chain, uint8_t address, uint32_t numBmbs, uint8_t* frameBuffer, uint32_t* numBytesToSend);
+
+/*!
+  @brief   Calculate the SPI clock of a chain for a baud rate prescaler
+  @param   chain - The ASCI daisy chain
+  @param   spiPrescaler - The SPI baud rate prescaler (SPI_BAUDRATEPRESCALER_x)
+  @return  The SPI clock in Hz
+*/
+static uint32_t calcAsciSpiClockHz(const Asci_Chain_S* chain, uint32_t spiPrescaler);
 
 /*!
   @brief   Load a command into the ASCI from a buffer. Verify the contents of the load queue
@@ -139,7 +614,7 @@ static bool readNextSpiMessage(uint8_t **data_p, uint32_t numBytesToRead);
   @param   numBytesToReceive - Number of bytes to be read into recvBuffer
   @return  True if successful transaction, false otherwise
 */
-static bool sendReceiveMessageAsci(uint8_t* sendBuffer, uint8_t** recvBuffer, const uint32_t numBytesToSend, const uint32_t numBytesToReceive);
+static bool sendReceiveMessageAsci(const uint8_t* sendBuffer, uint8_t** recvBuffer, const uint32_t numBytesToSend, const uint32_t numBytesToReceive);
 
 
 /* ==================================================================== */
@@ -148,18 +623,20 @@ static bool sendReceiveMessageAsci(uint8_t* sendBuffer, uint8_t** recvBuffer, co
 
 /*!
   @brief   Enable ASCI SPI by pulling chip select low
+  @param   chain - The ASCI daisy chain
 */
-static void csOn()
+static void csOn(Asci_Chain_S* chain)
 {
-	HAL_GPIO_WritePin(CS_ASCI_GPIO_Port, CS_ASCI_Pin, GPIO_PIN_RESET);
+	HAL_GPIO_WritePin(chain->csPort, chain->csPin, GPIO_PIN_RESET);
 }
 
 /*!
   @brief   Disable ASCI SPI by pulling chip select high
+  @param   chain - The ASCI daisy chain
 */
-static void csOff()
+static void csOff(Asci_Chain_S* chain)
 {
-	HAL_GPIO_WritePin(CS_ASCI_GPIO_Port, CS_ASCI_Pin, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(chain->csPort, chain->csPin, GPIO_PIN_SET);
 }
 
 /*!
@@ -169,9 +646,10 @@ static void csOff()
 */
 static void sendAsciSpi(uint8_t value)
 {
-	csOn();
-	SPI_TRANSMIT(HAL_SPI_Transmit_IT, &hspi1, TIMEOUT_SPI_COMPLETE_MS, sendAsciSpi, (uint8_t *)&value, 1);
-	csOff();
+	asciStats.numTransfers++;
+	csOn(activeChain);
+	SPI_TRANSMIT(ASCI_SPI_TRANSMIT_IT, activeChain->hspi, TIMEOUT_SPI_COMPLETE_MS, sendAsciSpi, (uint8_t *)&value, 1);
+	csOff(activeChain);
 }
 
 /*!
@@ -181,11 +659,12 @@ static void sendAsciSpi(uint8_t value)
 */
 static uint8_t readRegister(uint8_t registerAddress)
 {
-	csOn();
+	asciStats.numTransfers++;
+	csOn(activeChain);
 	const uint8_t sendBuffer[2] = {registerAddress + 1}; // Since reading add 1 to address
 	uint8_t recvBuffer[2] = {0};
-	SPI_TRANSMIT(HAL_SPI_TransmitReceive_IT, &hspi1, TIMEOUT_SPI_COMPLETE_MS, readRegister, (uint8_t *)&sendBuffer, (uint8_t *)&recvBuffer, 2);
-	csOff();
+	SPI_TRANSMIT(ASCI_SPI_TRANSMIT_RECEIVE_IT, activeChain->hspi, TIMEOUT_SPI_COMPLETE_MS, readRegister, (uint8_t *)&sendBuffer, (uint8_t *)&recvBuffer, 2);
+	csOff(activeChain);
 	return recvBuffer[1];
 }
 
@@ -196,10 +675,11 @@ static uint8_t readRegister(uint8_t registerAddress)
 */
 static void writeRegister(uint8_t registerAddress, uint8_t value)
 {
-	csOn();
+	asciStats.numTransfers++;
+	csOn(activeChain);
 	uint8_t sendBuffer[2] = {registerAddress, value};
-	SPI_TRANSMIT(HAL_SPI_Transmit_IT, &hspi1, TIMEOUT_SPI_COMPLETE_MS, writeRegister, (uint8_t *)&sendBuffer, 2);
-	csOff();
+	SPI_TRANSMIT(ASCI_SPI_TRANSMIT_IT, activeChain->hspi, TIMEOUT_SPI_COMPLETE_MS, writeRegister, (uint8_t *)&sendBuffer, 2);
+	csOff(activeChain);
 }
 
 /*!
@@ -211,16 +691,25 @@ static void writeRegister(uint8_t registerAddress, uint8_t value)
 */
 static bool writeAndVerifyRegister(uint8_t registerAddress, uint8_t value)
 {
-	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
+	if (shadowRegisterMatches(activeChain, registerAddress, value))
+	{
+		// Register already holds the value - skip the write and read back
+		asciStats.numConfigWritesSkipped++;
+		return true;
+	}
+
+	for (int32_t i = 0; (i < NUM_DATA_CHECKS) && !commsBudgetExpired(); i++)
 	{
 		writeRegister(registerAddress, value);
 		if (readRegister(registerAddress) == value)
 		{
 			// Data verified - exit
+			updateShadowRegister(activeChain, registerAddress, value);
 			return true;
 		}
 	}
 	DebugComm("Failed to write and verify register\n");
+	invalidateShadowRegisters(activeChain);
 	return false;
 }
 
@@ -232,41 +721,23 @@ static bool writeAndVerifyRegister(uint8_t registerAddress, uint8_t value)
 */
 static uint8_t calcCrc(uint8_t* byteArr, uint32_t numBytes)
 {
-	uint8_t crc = 0x00;
-	const uint8_t poly = 0xB2;
-	for (int32_t i = 0; i < numBytes; i++)
-	{
-		crc = crc ^ byteArr[i];
-		for (int32_t j = 0; j < 8; j++)
-		{
-			if (crc & 0x01)
-			{
-				crc = ((crc >> 1) ^ poly);
-			}
-			else
-			{
-				crc = (crc >> 1);
-			}
-		}
-	}
-	return crc;
+	return updateCrc(0x00, byteArr, numBytes);
 }
 
 /*!
-  @brief   Clears RX interrupt flags
-  @return  True if success, false otherwise
+  @brief   Continue a CRC calculation over a given set of bytes
+  @param   crc		The CRC of the bytes preceding byteArr
+  @param   byteArr	Pointer to array for which to continue the CRC
+  @param   numBytes	The number of bytes on which to continue the CRC
+  @return  uint8_t 	calculated CRC
 */
-static bool clearRxIntFlags()
+static uint8_t updateCrc(uint8_t crc, uint8_t* byteArr, uint32_t numBytes)
 {
-	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
+	for (uint32_t i = 0; i < numBytes; i++)
 	{
-		writeRegister(R_RX_INTERRUPT_FLAGS, 0x00);
-		uint8_t result = readRegister(R_RX_INTERRUPT_FLAGS);
-		// TODO - double check why this is necessary?
-		if ((result & ~(0x40)) == 0x00) { return true; }
+		crc = crcTable[crc ^ byteArr[i]];
 	}
-	DebugComm("Failed to clear Rx Interrupt Flags!\n");
-	return false;
+	return crc;
 }
 
 /*!
@@ -300,185 +771,1085 @@ static bool clearRxBusyFlag()
 }
 
 /*!
-  @brief   Check whether or not RX error interupt flags were set
-  @return  True if errors exist, false otherwise
+  @brief   Start the SPI transfer for a given ASCI transaction engine state
+  @param   chain - The ASCI daisy chain
+  @param   state - The state to transition the engine into
 */
-static bool rxErrorsExist()
+static void startAsciState(Asci_Chain_S* chain, Asci_State_E state)
 {
-	uint8_t rxIntFlags = readRegister(R_RX_INTERRUPT_FLAGS);
-	if (rxIntFlags & 0x88)
+	Asci_Message_S* message = &chain->engine.messages[chain->engine.messageIdx];
+	// Each message of a batch is loaded into its own load queue. Queue commands are spaced by 2
+	const uint8_t queueOffset = 2 * (chain->engine.messageIdx - chain->engine.batchStart);
+	uint8_t* txBuffer = chain->engine.txBuffer;
+	uint8_t* rxBuffer = chain->engine.rxBuffer;
+	uint32_t numBytes = 0;
+
+	chain->engine.state = state;
+	switch (state)
 	{
-		DebugComm("Detected errors during transmission!\n");
-		return true;
-	}
-	return false;
-}
+		case ASCI_CLR_RX_BUF:
+			txBuffer[0] = CMD_CLR_RX_BUF;
+			numBytes = 1;
+			break;
+
+		case ASCI_CLR_TX_BUF:
+			txBuffer[0] = CMD_CLR_TX_BUF;
+			numBytes = 1;
+			break;
+
+		case ASCI_LOAD_QUEUE:
+			numBytes = message->numBytesToSend;
+			if (queueOffset == 0)
+			{
+				// Load queue L0 frames are sent in place
+				txBuffer = (uint8_t*)message->sendFrame;
+			}
+			else
+			{
+				memcpy(txBuffer, message->sendFrame, numBytes);
+				txBuffer[0] += queueOffset;
+			}
+			break;
 
-/*!
-  @brief   Load the TX queue on the ASCI and verify that the content was
-  	  	   successfully written
-  @param   data_p - Array containing data to be written to the queue
-  @param   numBytes - Number of bytes to read from array to be written
-  	  	   	   	      to the queue
-  @return  True if success, false otherwise
-*/
-static bool loadAndVerifyTxQueue(uint8_t *data_p, uint32_t numBytes)
-{
-	uint8_t sendBuffer[numBytes];
-	memset(sendBuffer, 0, numBytes * sizeof(uint8_t));
-	uint8_t recvBuffer[numBytes];
-	memset(recvBuffer, 0, numBytes * sizeof(uint8_t));
-	// Attempt to load the queue a set number of times before giving up
-	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
-	{
-		bool queueDataVerified = false;
+		case ASCI_VERIFY_QUEUE:
+			// Read address is one greater than the write address
+			memset(txBuffer, 0, message->numBytesToSend);
+			txBuffer[0] = message->sendFrame[0] + queueOffset + 1;
+			numBytes = message->numBytesToSend;
+			break;
 
-		// Write queue
-		csOn();
-		INTERRUPT_STATUS_E spiStatus = SPI_TRANSMIT(HAL_SPI_Transmit_IT, &hspi1, TIMEOUT_SPI_COMPLETE_MS, loadAndVerifyTxQueue, data_p, numBytes);
-		
-		// Fail function if SPI transaction fails
-		if(!(spiStatus & INTERRUPT_SUCCESS))
-		{
-			csOff();
-			continue;
-		}
-		csOff();
+		case ASCI_WRITE_RX_INT_ENABLE:
+			if (shadowRegisterMatches(chain, R_RX_INTERRUPT_ENABLE, 0x8A))
+			{
+				// RX interrupts already enabled - skip the write and read back
+				asciStats.numConfigWritesSkipped++;
+				chain->engine.attemptNum = 0;
+				startAsciState(chain, ASCI_CLR_RX_INT_FLAGS);
+				return;
+			}
+			// Enable RX_Error, RX_Overflow and RX_Stop interrupts
+			txBuffer[0] = R_RX_INTERRUPT_ENABLE;
+			txBuffer[1] = 0x8A;
+			numBytes = 2;
+			break;
+
+		case ASCI_VERIFY_RX_INT_ENABLE:
+			txBuffer[0] = R_RX_INTERRUPT_ENABLE + 1;
+			txBuffer[1] = 0x00;
+			numBytes = 2;
+			break;
+
+		case ASCI_REARM_RX_STOP:
+			chain->engine.rxStopPending = false;
+			chain->engine.rxStopRearmed = true;
+			// fall through
+		case ASCI_CLR_RX_INT_FLAGS:
+			txBuffer[0] = R_RX_INTERRUPT_FLAGS;
+			txBuffer[1] = 0x00;
+			numBytes = 2;
+			break;
+
+		case ASCI_VERIFY_RX_INT_FLAGS:
+		case ASCI_CHECK_RX_ERRORS:
+		case ASCI_READ_RX_INT_FLAGS:
+			txBuffer[0] = R_RX_INTERRUPT_FLAGS + 1;
+			txBuffer[1] = 0x00;
+			numBytes = 2;
+			break;
+
+		case ASCI_SEND_MESSAGE:
+			if (queueOffset == 0)
+			{
+				chain->engine.rxStopPending = false;
+			}
+			txBuffer[0] = CMD_WR_NXT_LD_Q_L0 + queueOffset;
+			numBytes = 1;
+			break;
+
+		case ASCI_WAIT_RX_STOP:
+			// No SPI transfer - the engine is advanced by the ASCI external interrupt. If the interrupt
+			// already occured while the previous transfer was completing, continue immediately
+			if (chain->engine.rxStopPending)
+			{
+				startAsciState(chain, ASCI_READ_RX_STATUS);
+			}
+			return;
+
+		case ASCI_READ_RX_STATUS:
+		case ASCI_READ_NEXT_STATUS:
+			txBuffer[0] = R_RX_STATUS + 1;
+			txBuffer[1] = 0x00;
+			numBytes = 2;
+			break;
+
+		case ASCI_READ_MESSAGE:
+			// Read numBytesToReceive + 1 since we also need to send CMD_RD_NXT_MSG
+			numBytes = message->numBytesToReceive + READ_CMD_LENGTH;
+			memset(txBuffer, 0, numBytes);
+			txBuffer[0] = CMD_RD_NXT_MSG;
+			rxBuffer = message->recvBuffer;
+			break;
+
+		default:
+			return;
+	}
 
-		// Read queue
-		sendBuffer[0] = data_p[0] + 1;	// Read address is one greater than the write address
-		csOn();
-		spiStatus = SPI_TRANSMIT(HAL_SPI_TransmitReceive_IT, &hspi1, TIMEOUT_SPI_COMPLETE_MS, loadAndVerifyTxQueue, sendBuffer, recvBuffer, numBytes);
-		
-		// Fail function if SPI transaction fails
-		if(!(spiStatus & INTERRUPT_SUCCESS))
-		{
-			csOff();
-			continue;
-		}
-		csOff();
+#if ASCI_FRAME_CAPTURE
+	if (state == ASCI_LOAD_QUEUE)
+	{
+		captureAsciFrame(ASCI_FRAME_TX, txBuffer, numBytes);
+	}
+#endif
 
-		// Verify data in load queue - read back data should match data sent
-		queueDataVerified = !(bool)memcmp(&data_p[1], &recvBuffer[1], numBytes - 1);
-		if (queueDataVerified)
-		{
-			// Data integrity verified. Return true
-			return true;
-		}
+	asciStats.numTransfers++;
+	csOn(chain);
+	// Transfer is handled by DMA. Only the DMA complete interrupts are taken regardless of the message length
+	if (ASCI_SPI_TRANSMIT_RECEIVE_DMA(chain->hspi, txBuffer, rxBuffer, numBytes) != HAL_OK)
+	{
+		DebugComm("SPI transmission failed to start in ASCI state: %d!\n", state);
+		ASCI_SPI_ABORT_IT(chain->hspi);
+		csOff(chain);
+		finishAsciBatch(chain, false);
 	}
-	DebugComm("Failed to load and verify TX queue\n");
-	return false;
 }
 
 /*!
-  @brief   Read the next SPI message in ASCI receive queue
-  @param   data_p - Pointer to the array where data should
-   be written to
-  @param   numBytesToRead - Number of bytes to read from queue to array
-  @return  True if success, false otherwise
+  @brief   Retry a write and verify step of the ASCI transaction engine or fail the
+		   current message if out of attempts
+  @param   chain - The ASCI daisy chain
+  @param   state - The write state to return to
 */
-static bool readNextSpiMessage(uint8_t** data_p, uint32_t numBytesToRead)
+static void retryAsciState(Asci_Chain_S* chain, Asci_State_E state)
 {
-	int arraySize = numBytesToRead + 1;	// Array needs to have space for command
-	uint8_t sendBuffer[arraySize];
-	memset(sendBuffer, 0, arraySize * sizeof(uint8_t));
-
-	// Read numBytesToRead + 1 since we also need to send CMD_RD_NXT_MSG
-	sendBuffer[0] = CMD_RD_NXT_MSG;
-	csOn();
-	SPI_TRANSMIT(HAL_SPI_TransmitReceive_IT, &hspi1, TIMEOUT_SPI_COMPLETE_MS, readNextSpiMessage,  sendBuffer, *data_p, arraySize);
-	csOff();
-	// Return data should not include the CMD_RD_NXT_MSG
-	(*data_p)++;
-	return true;
+	chain->engine.attemptNum++;
+	if (chain->engine.attemptNum < NUM_DATA_CHECKS)
+	{
+		startAsciState(chain, state);
+	}
+	else
+	{
+		DebugComm("Failed to write and verify in ASCI state: %d!\n", state);
+		finishAsciBatch(chain, false);
+	}
 }
 
 /*!
-  @brief   Load a command into the ASCI from a buffer. Verify the contents of the load queue
-		   and receive response from BMB Daisy Chain. Return results in a receive Buffer
-  @param   sendBuffer - Pointer to the array containing data to be sent
-  @param   recvBuffer - Pointer to the array where received data will be written to
-  @param   numBytesToSend - Number of bytes to be sent from sendBuffer
-  @param   numBytesToReceive - Number of bytes to be read into recvBuffer
-  @return  True if successful transaction, false otherwise
+  @brief   Load the next message of the current batch into its load queue or continue to
+		   the RX interrupt setup once all messages of the batch are loaded
+  @param   chain - The ASCI daisy chain
 */
-static bool sendReceiveMessageAsci(uint8_t* sendBuffer, uint8_t** recvBuffer, const uint32_t numBytesToSend, const uint32_t numBytesToReceive)
+static void loadNextAsciQueue(Asci_Chain_S* chain)
 {
-	// TODO - see if there is a better way to do this
-	clearRxBuffer();
-	clearTxBuffer();
-	// Send command to ASCI and verify data integrity
-	if (!loadAndVerifyTxQueue(sendBuffer, numBytesToSend))
+	chain->engine.attemptNum = 0;
+	chain->engine.messageIdx++;
+	if (chain->engine.messageIdx < chain->engine.batchEnd)
 	{
-		return false;
+		startAsciState(chain, ASCI_LOAD_QUEUE);
 	}
-
-	// Enable RX_Error, RX_Overflow and RX_Stop interrupts
-	if(!writeAndVerifyRegister(R_RX_INTERRUPT_ENABLE, 0x8A))
+	else
 	{
-		return false;
+		startAsciState(chain, ASCI_WRITE_RX_INT_ENABLE);
 	}
+}
 
-	if (!clearRxIntFlags())
+/*!
+  @brief   Start the next batch of queued messages in the ASCI transaction engine
+  @param   chain - The ASCI daisy chain
+*/
+static void startAsciBatch(Asci_Chain_S* chain)
+{
+	chain->engine.batchStart = chain->engine.batchEnd;
+	chain->engine.batchEnd = chain->engine.batchStart + chain->engine.messagesPerBatch;
+	if (chain->engine.batchEnd > chain->engine.numMessages)
 	{
-		return false;
+		chain->engine.batchEnd = chain->engine.numMessages;
 	}
-	
-	sendAsciSpi(CMD_WR_NXT_LD_Q_L0);
-
-	// Wait for ASCI interrupt to occur
-	INTERRUPT_STATUS_E extIntStatus = WAIT_EXT_INT(TIMEOUT_SPI_COMPLETE_MS, sendReceiveMessageAsci);
+	chain->engine.messageIdx = chain->engine.batchStart;
+	chain->engine.attemptNum = 0;
+	chain->engine.rxStopRearmed = false;
+	asciStats.numBatches++;
+	startAsciState(chain, ASCI_CLR_RX_BUF);
+}
 
-	// Verify that interrupt was successful
-	if(!(extIntStatus & INTERRUPT_SUCCESS))
+/*!
+  @brief   Complete the current batch of messages and start the next batch. Notify the
+		   main task once all queued messages have been processed
+  @param   chain - The ASCI daisy chain
+  @param   success - True if the batch transaction succeeded, false otherwise
+*/
+static void finishAsciBatch(Asci_Chain_S* chain, bool success)
+{
+	if (!success)
 	{
-		return false;
+		// The ASCI may have been reset or misconfigured - rewrite the configuration on the next batch
+		invalidateShadowRegisters(chain);
 	}
 
-	// Verify that interrupt was caused by RX_Stop
-	if ((readRegister(R_RX_STATUS) & 0x02) != 0x02)
+	for (uint32_t i = chain->engine.batchStart; i < chain->engine.batchEnd; i++)
 	{
-		return false;
+		chain->engine.messages[i].complete = success;
 	}
 
-	// Read next SPI message.
-	if (!readNextSpiMessage(recvBuffer, numBytesToReceive))
+	if (chain->engine.batchEnd < chain->engine.numMessages)
 	{
-		return false;
+		// Start the next batch in the queue
+		startAsciBatch(chain);
+		return;
 	}
 
-	if (rxErrorsExist())
+	// Whole queue processed - wake the main task
+	chain->engine.state = ASCI_IDLE;
+	if (xPortIsInsideInterrupt())
 	{
-		// TODO - do we want to have an error routine?
-		return false;
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 	}
-	
-	return true;
 }
 
+/*!
+  @brief   Determine whether the load queue should be read back and verified according to
+		   the queue verification policy. Not consulted for a load following a failed verify
+  @return  True if the load queue should be verified, false otherwise
+*/
+static bool queueVerifyRequired()
+{
+	switch (queueVerifyPolicy)
+	{
+		case QUEUE_VERIFY_EVERY_NTH:
+			queueVerifyCount++;
+			if (queueVerifyCount >= queueVerifyInterval)
+			{
+				queueVerifyCount = 0;
+				return true;
+			}
+			return false;
+
+		case QUEUE_VERIFY_WHILE_ERRORS:
+			// Any recent failure leaves the bucket partially filled
+			return (asciCommsLeakyBucket.fillLevel > 0);
 
-/* ==================================================================== */
-/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
-/* ==================================================================== */
+		case QUEUE_VERIFY_ALWAYS:
+		default:
+			return true;
+	}
+}
 
 /*!
-  @brief   Power on ASCI
+  @brief   Determine whether an ASCI register is a configuration register held in the shadow cache
+  @param   registerAddress - The register address to check
+  @return  True if the register is shadowed, false otherwise
 */
-void enableASCI()
+static bool isShadowRegister(uint8_t registerAddress)
 {
-	HAL_GPIO_WritePin(SHDN_GPIO_Port, SHDN_Pin, GPIO_PIN_SET);
+	// Interrupt flag registers are set by hardware so they cannot be shadowed
+	return (registerAddress >= R_RX_INTERRUPT_ENABLE) && (registerAddress <= R_CONFIG_3) &&
+		   ((registerAddress & 0x01) == 0) &&
+		   (registerAddress != R_RX_INTERRUPT_FLAGS) && (registerAddress != R_TX_INTERRUPT_FLAGS);
 }
 
 /*!
-  @brief   Power off ASCI
+  @brief   Determine whether an ASCI configuration register is known to already hold a value
+  @param   chain - The ASCI daisy chain
+  @param   registerAddress - The register address to check
+  @param   value - The value to compare against
+  @return  True if the shadow cache holds the value for the register, false otherwise
 */
-void disableASCI()
+static bool shadowRegisterMatches(Asci_Chain_S* chain, uint8_t registerAddress, uint8_t value)
 {
-	HAL_GPIO_WritePin(SHDN_GPIO_Port, SHDN_Pin, GPIO_PIN_RESET);
+	if (!isShadowRegister(registerAddress))
+	{
+		return false;
+	}
+	const uint32_t idx = registerAddress >> 1;
+	return (chain->shadowRegistersValid & (1UL << idx)) && (chain->shadowRegisters[idx] == value);
 }
 
 /*!
-  @brief   Power cycle the ASCI
+  @brief   Record a value written and verified to an ASCI configuration register
+  @param   chain - The ASCI daisy chain
+  @param   registerAddress - The register address that was written
+  @param   value - The value that was written
+*/
+static void updateShadowRegister(Asci_Chain_S* chain, uint8_t registerAddress, uint8_t value)
+{
+	if (isShadowRegister(registerAddress))
+	{
+		const uint32_t idx = registerAddress >> 1;
+		chain->shadowRegisters[idx] = value;
+		chain->shadowRegistersValid |= (1UL << idx);
+	}
+}
+
+/*!
+  @brief   Invalidate all shadowed ASCI configuration registers so that the next writes are
+		   sent and verified
+  @param   chain - The ASCI daisy chain
+*/
+static void invalidateShadowRegisters(Asci_Chain_S* chain)
+{
+	chain->shadowRegistersValid = 0;
+}
+
+/*!
+  @brief   Start timing an ASCI command and make it the active command for error accounting
+  @param   timer - The timer to start
+  @param   type - The type of command being timed
+*/
+static void startCmdTimer(Cmd_Timer_S* timer, Asci_Cmd_Type_E type)
+{
+	timer->stats = &asciCmdStats[type];
+	timer->prevStats = activeCmdStats;
+	timer->startCycles = DWT->CYCCNT;
+	activeCmdStats = timer->stats;
+}
+
+/*!
+  @brief   Stop timing an ASCI command and record its latency, retries and result
+  @param   timer - The timer started for the command
+  @param   numAttempts - The number of attempts made by the command
+  @param   success - True if the command succeeded, false otherwise
+*/
+static void finishCmdTimer(Cmd_Timer_S* timer, uint32_t numAttempts, bool success)
+{
+	Asci_Cmd_Stats_S* stats = timer->stats;
+	const uint32_t latencyUs = (DWT->CYCCNT - timer->startCycles) / (SystemCoreClock / 1000000);
+
+	// Bucket index is the number of significant bits in the latency
+	uint32_t bucket = (latencyUs == 0) ? 0 : (32 - __CLZ(latencyUs));
+	if (bucket >= ASCI_LATENCY_HIST_BUCKETS)
+	{
+		bucket = ASCI_LATENCY_HIST_BUCKETS - 1;
+	}
+
+	stats->numCalls++;
+	stats->latencyHist[bucket]++;
+	if (latencyUs > stats->maxLatencyUs)
+	{
+		stats->maxLatencyUs = latencyUs;
+	}
+	if (numAttempts > 1)
+	{
+		stats->numRetries += numAttempts - 1;
+	}
+	if (!success)
+	{
+		stats->numFailures++;
+	}
+	activeCmdStats = timer->prevStats;
+}
+
+/*!
+  @brief   Stop timing an ASCI command that was abandoned because the communication time budget
+		   ran out. Only the abort is counted so that budget expiry is not reported as a link failure
+  @param   timer - The timer started for the command
+*/
+static void abortCmdTimer(Cmd_Timer_S* timer)
+{
+	timer->stats->numBudgetAborts++;
+	activeCmdStats = timer->prevStats;
+}
+
+/*!
+  @brief   Count CRC and alive-counter errors of a received frame against the active command
+  @param   crcValid - True if the frame CRC or command echo matched
+  @param   aliveCounterValid - True if the frame alive-counter matched
+*/
+static void recordFrameErrors(bool crcValid, bool aliveCounterValid)
+{
+	if (activeCmdStats == NULL)
+	{
+		return;
+	}
+	if (!crcValid)
+	{
+		activeCmdStats->numCrcErrors++;
+	}
+	if (!aliveCounterValid)
+	{
+		activeCmdStats->numAliveCounterErrors++;
+	}
+}
+
+/*!
+  @brief   Update the link error rate of a BMB on the selected chain with a frame known to have reached it
+  @param   bmbIdx - The daisy chain position of the BMB
+  @param   error - True if the frame was corrupted at this BMB, false otherwise
+*/
+static void updateLinkErrorRate(uint32_t bmbIdx, bool error)
+{
+	Bmb_Link_Stats_S* link = &bmbLinkStats[getAsciChain()][bmbIdx];
+	link->numFrames++;
+	// Exponentially weighted moving average. Saturates just below full scale so it can not overflow
+	link->errorRate -= link->errorRate >> LINK_STATS_DECAY_SHIFT;
+	if (error)
+	{
+		link->errorRate += LINK_ERROR_RATE_FULL_SCALE >> LINK_STATS_DECAY_SHIFT;
+	}
+}
+
+/*!
+  @brief   Record the result of a chain wide frame (readAll, writeAll) in the BMB link statistics.
+		   An alive-counter of k < numBmbs means BMB k did not process the frame
+  @param   aliveCount - The received alive-counter
+  @param   crcValid - True if the frame CRC or command echo matched
+  @param   numBmbs - The number of BMBs we expect to process the frame
+*/
+static void recordChainLinkStats(uint8_t aliveCount, bool crcValid, uint32_t numBmbs)
+{
+	if (aliveCount < numBmbs)
+	{
+		// Every BMB before the shortfall passed the frame on
+		for (uint32_t i = 0; (i < aliveCount) && (i < LINK_STATS_MAX_BMBS); i++)
+		{
+			updateLinkErrorRate(i, false);
+		}
+		if (aliveCount < LINK_STATS_MAX_BMBS)
+		{
+			bmbLinkStats[getAsciChain()][aliveCount].numAliveCounterShortfalls++;
+			updateLinkErrorRate(aliveCount, true);
+		}
+		return;
+	}
+
+	if (!crcValid || (aliveCount > numBmbs))
+	{
+		// The frame passed every BMB so the corruption can not be located
+		asciStats.numUnlocatedLinkErrors++;
+		return;
+	}
+
+	for (uint32_t i = 0; (i < numBmbs) && (i < LINK_STATS_MAX_BMBS); i++)
+	{
+		updateLinkErrorRate(i, false);
+	}
+}
+
+/*!
+  @brief   Record the result of a frame addressed to a single BMB (readDevice, writeDevice) in
+		   its link statistics
+  @param   bmbIdx - The daisy chain position of the addressed BMB
+  @param   crcValid - True if the frame CRC or command echo matched
+  @param   aliveCounterValid - True if the frame alive-counter matched
+*/
+static void recordDeviceLinkStats(uint32_t bmbIdx, bool crcValid, bool aliveCounterValid)
+{
+	if (bmbIdx >= LINK_STATS_MAX_BMBS)
+	{
+		return;
+	}
+	if (!crcValid)
+	{
+		bmbLinkStats[getAsciChain()][bmbIdx].numCrcErrors++;
+	}
+	if (!aliveCounterValid)
+	{
+		bmbLinkStats[getAsciChain()][bmbIdx].numAliveCounterShortfalls++;
+	}
+	updateLinkErrorRate(bmbIdx, !(crcValid && aliveCounterValid));
+}
+
+/*!
+  @brief   Determine whether the current communication time budget has been spent
+  @return  True if a budget is active and spent, false otherwise
+*/
+static bool commsBudgetExpired()
+{
+	if (!commsBudget.active)
+	{
+		return false;
+	}
+	if ((HAL_GetTick() - commsBudget.startTick) >= commsBudget.budgetMs)
+	{
+		commsBudget.exhausted = true;
+		return true;
+	}
+	return false;
+}
+
+/*!
+  @brief   Get the time left in the current communication time budget
+  @return  The remaining time in ms, UINT32_MAX if no budget is active
+*/
+static uint32_t commsBudgetRemainingMs()
+{
+	if (!commsBudget.active)
+	{
+		return UINT32_MAX;
+	}
+	const uint32_t elapsed = HAL_GetTick() - commsBudget.startTick;
+	return (elapsed < commsBudget.budgetMs) ? (commsBudget.budgetMs - elapsed) : 0;
+}
+
+#if ASCI_FRAME_CAPTURE
+/*!
+  @brief   Record a frame in the frame capture ring buffer, overwriting the oldest frame if full
+  @param   direction - Whether the frame was sent to or received from the daisy chain
+  @param   data - The frame data
+  @param   length - The number of bytes in the frame
+*/
+static void captureAsciFrame(Asci_Frame_Dir_E direction, const uint8_t* data, uint32_t length)
+{
+	if (!asciCapture.enabled)
+	{
+		return;
+	}
+
+	Asci_Frame_S* frame = &asciCapture.frames[asciCapture.head];
+	frame->timestampMs = HAL_GetTick();
+	frame->direction = direction;
+	frame->length = (length < SPI_BUFF_SIZE) ? length : SPI_BUFF_SIZE;
+	memcpy(frame->data, data, frame->length);
+
+	asciCapture.head = (asciCapture.head + 1) % ASCI_CAPTURE_NUM_FRAMES;
+	if (asciCapture.numFrames < ASCI_CAPTURE_NUM_FRAMES)
+	{
+		asciCapture.numFrames++;
+	}
+	else
+	{
+		asciCapture.numDropped++;
+	}
+}
+#endif
+
+/*!
+  @brief   Prepare the transaction engine of a chain to run the messages loaded into it
+  @param   chain - The ASCI daisy chain
+  @param   numMessages - The number of messages loaded into the engine
+  @param   messagesPerBatch - The max number of messages to load into the ASCI load queues
+		   and send back to back. Limited to ASCI_NUM_LOAD_QUEUES
+*/
+static void loadAsciEngine(Asci_Chain_S* chain, uint32_t numMessages, uint32_t messagesPerBatch)
+{
+	for (uint32_t i = 0; i < numMessages; i++)
+	{
+		chain->engine.messages[i].complete = false;
+	}
+	chain->engine.numMessages = numMessages;
+	chain->engine.messagesPerBatch = (messagesPerBatch == 0) ? 1 : messagesPerBatch;
+	if (chain->engine.messagesPerBatch > ASCI_NUM_LOAD_QUEUES)
+	{
+		chain->engine.messagesPerBatch = ASCI_NUM_LOAD_QUEUES;
+	}
+	chain->engine.batchEnd = 0;
+}
+
+/*!
+  @brief   Run the loaded transaction engines of a set of chains concurrently in the background
+		   and block until every engine has processed its whole queue
+  @param   chainMask - Bit n set to run the engine of chain n
+*/
+static void runAsciEngines(uint32_t chainMask)
+{
+	if (commsBudgetExpired())
+	{
+		// Out of time - leave every message incomplete without touching the link
+		return;
+	}
+
+	const uint32_t startCycles = DWT->CYCCNT;
+	const uint32_t startTransfers = asciStats.numTransfers;
+	const uint32_t startInterrupts = asciStats.numInterrupts;
+	const uint32_t startIsrCycles = asciStats.isrCycles;
+	const uint32_t startBytesSaved = asciStats.queueVerifyBytesSaved;
+
+	// The first transfers are started with interrupts masked so that the SPI callbacks cannot
+	// advance an engine before the HAL has released the SPI handle
+	uint32_t numMessages = 0;
+	uint32_t maxMessages = 0;
+	taskENTER_CRITICAL();
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (chainMask & (1UL << chainIdx))
+		{
+			Asci_Chain_S* chain = &asciChains[chainIdx];
+			numMessages += chain->engine.numMessages;
+			if (chain->engine.numMessages > maxMessages)
+			{
+				maxMessages = chain->engine.numMessages;
+			}
+			startAsciBatch(chain);
+		}
+	}
+	taskEXIT_CRITICAL();
+
+	// Block until every queue has been processed. Each message is allowed its own timeout,
+	// limited by the communication time budget. Chains run in parallel so the longest queue counts
+	uint32_t timeout = maxMessages * TIMEOUT_ASCI_MESSAGE_MS;
+	const uint32_t budgetRemainingMs = commsBudgetRemainingMs();
+	if (budgetRemainingMs < timeout)
+	{
+		timeout = (budgetRemainingMs > 0) ? budgetRemainingMs : 1;
+	}
+	const uint32_t startTick = HAL_GetTick();
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		Asci_Chain_S* chain = &asciChains[chainIdx];
+		if (!(chainMask & (1UL << chainIdx)))
+		{
+			continue;
+		}
+
+		// Every engine notifies the main task when it finishes so keep waiting until this one is idle
+		while (chain->engine.state != ASCI_IDLE)
+		{
+			uint32_t notificationFlags = 0;
+			const uint32_t elapsed = HAL_GetTick() - startTick;
+			if ((elapsed >= timeout) ||
+				(xTaskNotifyWait(TASK_NO_OP, TASK_CLEAR_FLAGS, &notificationFlags, timeout - elapsed) != pdTRUE))
+			{
+				// Transaction engine stalled - most likely due to a missing RX_Stop interrupt. Abort the
+				// transfer in progress. Messages that were not processed remain incomplete
+				DebugComm("ASCI transaction engine %lu TIMED OUT in message %lu! - Aborting!\n", chainIdx, chain->engine.messageIdx);
+				taskENTER_CRITICAL();
+				chain->engine.state = ASCI_IDLE;
+				taskEXIT_CRITICAL();
+				ASCI_SPI_ABORT(chain->hspi);
+				csOff(chain);
+				invalidateShadowRegisters(chain);
+				if (activeCmdStats != NULL)
+				{
+					activeCmdStats->numTimeouts++;
+				}
+				break;
+			}
+		}
+	}
+
+	// Record the cost of this run
+	asciStats.numRuns++;
+	asciStats.lastRunMessages = numMessages;
+	asciStats.lastRunTransfers = asciStats.numTransfers - startTransfers;
+	asciStats.lastRunInterrupts = asciStats.numInterrupts - startInterrupts;
+	asciStats.lastRunIsrCycles = asciStats.isrCycles - startIsrCycles;
+	asciStats.lastRunQueueVerifyBytesSaved = asciStats.queueVerifyBytesSaved - startBytesSaved;
+	asciStats.lastRunCycles = DWT->CYCCNT - startCycles;
+}
+
+/*!
+  @brief   Run all messages loaded into the transaction engine of the selected chain in the
+		   background and block until the whole queue has been processed
+  @param   numMessages - The number of messages loaded into the engine
+  @param   messagesPerBatch - The max number of messages to load into the ASCI load queues
+		   and send back to back. Limited to ASCI_NUM_LOAD_QUEUES
+*/
+static void runAsciEngine(uint32_t numMessages, uint32_t messagesPerBatch)
+{
+	loadAsciEngine(activeChain, numMessages, messagesPerBatch);
+	runAsciEngines(1UL << getAsciChain());
+}
+
+/*!
+  @brief   Load readAll messages for a set of requests into the transaction engine of a chain
+  @param   chain - The ASCI daisy chain to read from
+  @param   requests - Array of registers to read and buffers to read the data in to
+  @param   numRequests - The number of requests. Limited to ASCI_MESSAGE_QUEUE_SIZE
+  @param   numBmbs - The number of BMBs on the chain
+*/
+static void loadReadAllMessages(Asci_Chain_S* chain, ReadAllRequest_S* requests, uint32_t numRequests, uint32_t numBmbs)
+{
+	const uint32_t numBytesToReceive = 0x05 + numBmbs * BYTES_PER_BMB_REGISTER;
+	for (uint32_t i = 0; i < numRequests; i++)
+	{
+		Asci_Message_S* message = &chain->engine.messages[i];
+		message->sendFrame = getReadAllFrame(chain, requests[i].address, numBmbs, message->frameBuffer, &message->numBytesToSend);
+		message->recvBuffer = requests[i].data_p;
+		message->numBytesToReceive = numBytesToReceive;
+	}
+
+	// Send as many reads back to back as the load queues and the ASCI receive buffer can hold
+	loadAsciEngine(chain, numRequests, ASCI_RX_BUFFER_SIZE / numBytesToReceive);
+}
+
+/*!
+  @brief   Verify the readAll messages run by the transaction engine of the selected chain and
+		   retry any failed read with readAll
+  @param   requests - The requests loaded by loadReadAllMessages. Updated with the result of each read
+  @param   numRequests - The number of requests
+  @param   numBmbs - The number of BMBs on the chain
+  @param   success - Cleared if any read failed
+  @return  The number of reads that fell back to readAll
+*/
+static uint32_t verifyReadAllMessages(ReadAllRequest_S* requests, uint32_t numRequests, uint32_t numBmbs, bool* success)
+{
+	uint32_t numFallbacks = 0;
+
+	// Verify every message. Return data does not include the CMD_RD_NXT_MSG
+	for (uint32_t i = 0; i < numRequests; i++)
+	{
+		ReadAllRequest_S* request = &requests[i];
+		const Asci_Message_S* message = &activeChain->engine.messages[i];
+		// The message CRC was calculated by the transaction engine as the message was read
+		request->success = message->complete && readAllFrameValid(&request->data_p[READ_CMD_LENGTH], message->recvCrc, numBmbs);
+		if (request->success)
+		{
+			updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+		}
+		else if (!message->complete && commsBudgetExpired())
+		{
+			// Cut short by the communication time budget. Leave the read failed without a fallback
+			invalidateShadowRegisters(activeChain);
+		}
+		else
+		{
+			// Fall back to a blocking read with retries
+			invalidateShadowRegisters(activeChain);
+			numFallbacks++;
+			request->success = readAll(request->address, request->data_p, numBmbs);
+		}
+		*success &= request->success;
+	}
+	return numFallbacks;
+}
+
+/*!
+  @brief   Read a set of registers on the BMBs of one or more ASCI daisy chains. The reads are
+		   queued in the transaction engine of every chain ASCI_MESSAGE_QUEUE_SIZE at a time and
+		   the chains run concurrently. Any read that fails is retried with readAll on its chain.
+		   All queued read APIs go through here. Leaves the last chain read selected
+  @param   requests - Array of requests to run on each chain, NULL for a chain that is not read.
+		   Updated with the result of each read
+  @param   chainNumBmbs - The number of BMBs on each chain
+  @param   numRequests - The number of requests run on each chain
+  @return  True if all reads on all chains succeeded, false otherwise
+*/
+static bool readAllChains(ReadAllRequest_S* const* requests, const uint32_t* chainNumBmbs, uint32_t numRequests)
+{
+	bool readAllSuccess = true;
+	uint32_t numFallbacks = 0;
+
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_READ_ALL_QUEUED);
+
+	for (uint32_t start = 0; start < numRequests; start += ASCI_MESSAGE_QUEUE_SIZE)
+	{
+		if (commsBudgetExpired())
+		{
+			// Out of time - the reads not yet sent fail without being charged to the link
+			for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+			{
+				for (uint32_t i = start; (requests[chainIdx] != NULL) && (i < numRequests); i++)
+				{
+					requests[chainIdx][i].success = false;
+				}
+			}
+			abortCmdTimer(&timer);
+			return false;
+		}
+
+		const uint32_t numMessages = ((numRequests - start) < ASCI_MESSAGE_QUEUE_SIZE) ? (numRequests - start) : ASCI_MESSAGE_QUEUE_SIZE;
+
+		// Load the same chunk into the engine of every chain and run them all at once
+		uint32_t chainMask = 0;
+		for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+		{
+			if (requests[chainIdx] != NULL)
+			{
+				loadReadAllMessages(&asciChains[chainIdx], &requests[chainIdx][start], numMessages, chainNumBmbs[chainIdx]);
+				chainMask |= (1UL << chainIdx);
+			}
+		}
+		runAsciEngines(chainMask);
+
+		// Link statistics and fallback reads apply to the selected chain
+		for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+		{
+			if (chainMask & (1UL << chainIdx))
+			{
+				selectAsciChain(chainIdx);
+				numFallbacks += verifyReadAllMessages(&requests[chainIdx][start], numMessages, chainNumBmbs[chainIdx], &readAllSuccess);
+			}
+		}
+	}
+	if (!readAllSuccess && commsBudgetExpired())
+	{
+		// The last chunk was cut short by the communication time budget
+		abortCmdTimer(&timer);
+		return false;
+	}
+	// Each fallback readAll is counted as a retry of the queued read
+	finishCmdTimer(&timer, 1 + numFallbacks, readAllSuccess);
+	return readAllSuccess;
+}
+
+/*!
+  @brief   Calculate the SPI clock of a chain for a baud rate prescaler
+  @param   chain - The ASCI daisy chain
+  @param   spiPrescaler - The SPI baud rate prescaler (SPI_BAUDRATEPRESCALER_x)
+  @return  The SPI clock in Hz
+*/
+static uint32_t calcAsciSpiClockHz(const Asci_Chain_S* chain, uint32_t spiPrescaler)
+{
+	// SPI clock is PCLK / 2^(BR + 1). SPI1 and SPI4 are on APB2, SPI2 and SPI3 on APB1
+	const SPI_TypeDef* spi = chain->hspi->Instance;
+	const uint32_t pclkHz = ((spi == SPI1) || (spi == SPI4)) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+	return pclkHz >> (((spiPrescaler & SPI_CR1_BR) >> SPI_CR1_BR_Pos) + 1);
+}
+
+/*!
+  @brief   Find the ASCI daisy chain on an SPI bus
+  @param   hspi - The SPI handle
+  @return  The chain on the SPI bus, NULL if there is none
+*/
+static Asci_Chain_S* findAsciChainBySpi(SPI_HandleTypeDef* hspi)
+{
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (asciChains[chainIdx].hspi == hspi)
+		{
+			return &asciChains[chainIdx];
+		}
+	}
+	return NULL;
+}
+
+/*!
+  @brief   Load a command into the ASCI from a buffer. Verify the contents of the load queue
+		   and receive response from BMB Daisy Chain. Return results in a receive Buffer
+  @param   sendBuffer - Pointer to the array containing data to be sent
+  @param   recvBuffer - Pointer to the array where received data will be written to
+  @param   numBytesToSend - Number of bytes to be sent from sendBuffer
+  @param   numBytesToReceive - Number of bytes to be read into recvBuffer
+  @return  True if successful transaction, false otherwise
+*/
+static bool sendReceiveMessageAsci(const uint8_t* sendBuffer, uint8_t** recvBuffer, const uint32_t numBytesToSend, const uint32_t numBytesToReceive)
+{
+	// The send buffer is used in place. It remains valid since this function blocks until complete
+	Asci_Message_S* message = &activeChain->engine.messages[0];
+	message->sendFrame = sendBuffer;
+	message->recvBuffer = *recvBuffer;
+	message->numBytesToSend = numBytesToSend;
+	message->numBytesToReceive = numBytesToReceive;
+
+	runAsciEngine(1, 1);
+
+	// Return data should not include the CMD_RD_NXT_MSG
+	(*recvBuffer)++;
+	return message->complete;
+}
+
+/*!
+  @brief   Build the ASCI + BMB command frame for a readAll command
+  @param   sendBuffer - Buffer to build the command frame in
+  @param   address - BMB register address to read from
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  The number of bytes in the command frame
+*/
+static uint32_t buildReadAllFrame(uint8_t* sendBuffer, uint8_t address, uint32_t numBmbs)
+{
+	const uint32_t bmbCmdLength = 0x05;					// CMD, address, DATA_CHECK, CRC, ALIVE_COUNTER
+	const uint32_t asciCmdLength = 0x02;				// CMD, DATA_LENGTH
+	const uint32_t numBytesToReceive = bmbCmdLength + numBmbs * BYTES_PER_BMB_REGISTER;
+
+	uint8_t* asciCmdBuffer = sendBuffer;
+	uint8_t* bmbCmdBuffer  = &sendBuffer[asciCmdLength];
+
+	// ASCI Command Data
+	asciCmdBuffer[0] = CMD_WR_LD_Q_L0;				// Command for ASCI
+	asciCmdBuffer[1] = numBytesToReceive;			// Data length for ASCI
+
+	// BMB Command Data
+	bmbCmdBuffer[0] = CMD_READ_ALL;					// Command byte for BMBs
+	bmbCmdBuffer[1] = address;						// Register Address for BMBs
+	bmbCmdBuffer[2] = 0x00;							// Data check byte
+	bmbCmdBuffer[3] = calcCrc(bmbCmdBuffer, bmbCmdLength - 2);	// Calculate CRC on CMD, ADDRESS, DATA_CHECK
+	bmbCmdBuffer[4] = 0x00;							// Alive counter seed value for BMBs
+
+	return asciCmdLength + bmbCmdLength;
+}
+
+/*!
+  @brief   Build the ASCI + BMB command frame for a writeAll command
+  @param   sendBuffer - Buffer to build the command frame in. Must hold MAX_ASCI_CMD_LENGTH bytes
+  @param   address - BMB register address to write to
+  @param   value - Value to write to the BMB register
+  @return  The number of bytes in the command frame
+*/
+static uint32_t buildWriteAllFrame(uint8_t* sendBuffer, uint8_t address, uint16_t value)
+{
+	const uint32_t bmbCmdLength = 0x06;					// CMD, address, LSB, MSB, CRC, ALIVE_COUNTER
+	const uint32_t asciCmdLength = 0x02;				// CMD, DATA_LENGTH
+
+	uint8_t* asciCmdBuffer = sendBuffer;
+	uint8_t* bmbCmdBuffer  = &sendBuffer[asciCmdLength];
+
+	// ASCI Command Data
+	asciCmdBuffer[0] = CMD_WR_LD_Q_L0;				// Command for ASCI
+	asciCmdBuffer[1] = bmbCmdLength;				// Data length for ASCI
+
+	// BMB Command Data
+	bmbCmdBuffer[0] = CMD_WRITE_ALL;				// Command byte for BMBs
+	bmbCmdBuffer[1] = address;						// Register Address for BMBs
+	bmbCmdBuffer[2] = (uint8_t)(value & 0x00FF);	// LSB
+	bmbCmdBuffer[3] = (uint8_t)(value >> 8);		// MSB
+	if (frameTablesValid && (address < NUM_CACHED_REGISTERS))
+	{
+		// Complete the precomputed CMD, ADDRESS CRC over LSB, MSB
+		bmbCmdBuffer[4] = updateCrc(writeAllCrcSeedTable[address], &bmbCmdBuffer[2], 2);
+	}
+	else
+	{
+		bmbCmdBuffer[4] = calcCrc(bmbCmdBuffer, bmbCmdLength - 2);	// Calculate CRC on CMD, ADDRESS, LSB, MSB
+	}
+	bmbCmdBuffer[5] = 0x00;							// Alive counter seed value for BMBs
+
+	return asciCmdLength + bmbCmdLength;
+}
+
+/*!
+  @brief   Verify the CRC and alive-counter of a received readAll message
+  @param   recvBuffer - The received message, not including the read command byte
+  @param   calculatedCrc - The CRC calculated over the received message
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if the message is valid, false otherwise
+*/
+static bool readAllFrameValid(uint8_t* recvBuffer, uint8_t calculatedCrc, uint32_t numBmbs)
+{
+	uint8_t recvCrc = recvBuffer[3 + (BYTES_PER_BMB_REGISTER * numBmbs)];
+
+	// Verify data CRC and Alive-counter byte
+	const bool crcValid = (calculatedCrc == recvCrc);
+	const uint8_t aliveCount = recvBuffer[4 + (BYTES_PER_BMB_REGISTER * numBmbs)];
+	const bool aliveCounterValid = (aliveCount == numBmbs);
+	recordFrameErrors(crcValid, aliveCounterValid);
+	recordChainLinkStats(aliveCount, crcValid, numBmbs);
+	return crcValid && aliveCounterValid;
+}
+
+/*!
+  @brief   Verify the CRC lookup table against the bitwise CRC definition and the precomputed
+		   frame tables against the frames built by calcCrc
+  @return  True if all table entries match, false otherwise
+*/
+static bool checkFrameTables()
+{
+	// Check the CRC lookup table against the bitwise CRC definition
+	for (int32_t i = 0; i < 256; i++)
+	{
+		uint8_t crc = i;
+		for (int32_t j = 0; j < 8; j++)
+		{
+			crc = (crc & 0x01) ? ((crc >> 1) ^ CRC_POLY) : (crc >> 1);
+		}
+		if (crc != crcTable[i])
+		{
+			DebugComm("CRC table mismatch at index %ld!\n", i);
+			return false;
+		}
+	}
+
+	for (int32_t address = 0; address < NUM_CACHED_REGISTERS; address++)
+	{
+		uint8_t readAllCmd[3] = {CMD_READ_ALL, address, 0x00};
+		uint8_t writeAllCmd[2] = {CMD_WRITE_ALL, address};
+		if ((calcCrc(readAllCmd, 3) != readAllCrcTable[address]) ||
+			(calcCrc(writeAllCmd, 2) != writeAllCrcSeedTable[address]))
+		{
+			DebugComm("Frame CRC table mismatch at register 0x%02lX!\n", address);
+			return false;
+		}
+	}
+	return true;
+}
+
+/*!
+  @brief   Get a ready to send readAll command frame
+  @param   chain - The ASCI daisy chain the frame is sent on
+  @param   address - BMB register address to read from
+  @param   numBmbs - The number of BMBs we expect to read from
+  @param   frameBuffer - Buffer to build the command frame in if the register is not cached
+  @param   numBytesToSend - Updated with the number of bytes in the command frame
+  @return  Pointer to the command frame
+*/
+static const uint8_t* getReadAllFrame(Asci_Chain_S* chain, uint8_t address, uint32_t numBmbs, uint8_t* frameBuffer, uint32_t* numBytesToSend)
+{
+	if (address >= NUM_CACHED_REGISTERS)
+	{
+		// Build the frame from scratch
+		*numBytesToSend = buildReadAllFrame(frameBuffer, address, numBmbs);
+		return frameBuffer;
+	}
+
+	if (!chain->readAllFrameCacheValid || (chain->readAllFrameCacheNumBmbs != numBmbs))
+	{
+		// Rebuild the cache for the new chain length. Fall back to the frame builder if the CRC table is bad
+		for (int32_t i = 0; i < NUM_CACHED_REGISTERS; i++)
+		{
+			uint8_t* frame = chain->readAllFrameCache[i];
+			if (frameTablesValid)
+			{
+				frame[0] = CMD_WR_LD_Q_L0;
+				frame[1] = 0x05 + numBmbs * BYTES_PER_BMB_REGISTER;
+				frame[2] = CMD_READ_ALL;
+				frame[3] = i;
+				frame[4] = 0x00;
+				frame[5] = readAllCrcTable[i];
+				frame[6] = 0x00;
+			}
+			else
+			{
+				buildReadAllFrame(frame, i, numBmbs);
+			}
+		}
+		chain->readAllFrameCacheNumBmbs = numBmbs;
+		chain->readAllFrameCacheValid = true;
+	}
+	*numBytesToSend = 0x07;		// ASCI CMD, DATA_LENGTH, BMB CMD, address, DATA_CHECK, CRC, ALIVE_COUNTER
+	return chain->readAllFrameCache[address];
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Select the ASCI daisy chain that all following ASCI and BMB commands are sent on.
+		   BMB indexes passed to those commands are positions on the selected chain
+  @param   chainIdx - The index of the chain to select
+*/
+void selectAsciChain(uint32_t chainIdx)
+{
+	if (chainIdx < NUM_ASCI_CHAINS)
+	{
+		activeChain = &asciChains[chainIdx];
+	}
+}
+
+/*!
+  @brief   Get the ASCI daisy chain that commands are currently sent on
+  @return  The index of the selected chain
+*/
+uint32_t getAsciChain()
+{
+	return activeChain - asciChains;
+}
+
+/*!
+  @brief   Power on ASCI
+*/
+void enableASCI()
+{
+	HAL_GPIO_WritePin(activeChain->shdnPort, activeChain->shdnPin, GPIO_PIN_SET);
+#if ASCI_SIMULATION
+	simAsciSetPower(activeChain->hspi, true);
+#endif
+}
+
+/*!
+  @brief   Power off ASCI
+*/
+void disableASCI()
+{
+	HAL_GPIO_WritePin(activeChain->shdnPort, activeChain->shdnPin, GPIO_PIN_RESET);
+#if ASCI_SIMULATION
+	simAsciSetPower(activeChain->hspi, false);
+#endif
+}
+
+/*!
+  @brief   Power cycle the ASCI
 */
 void resetASCI()
 {
@@ -486,6 +1857,9 @@ void resetASCI()
 	vTaskDelay(50);
 	enableASCI();
 	vTaskDelay(10);
+
+	// ASCI registers return to their reset values
+	invalidateShadowRegisters(activeChain);
 }
 
 /*!
@@ -511,14 +1885,26 @@ void clearTxBuffer()
 bool initASCI()
 {
 	DebugComm("Initializing ASCI connection...\n");
+
+	// Enable the DWT cycle counter used for ASCI link instrumentation
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	// Only use the precomputed command frames if they match the frame builders
+	frameTablesValid = checkFrameTables();
+	activeChain->readAllFrameCacheValid = false;
+
+#if ASCI_SIMULATION
+	simAsciAttach(getAsciChain(), activeChain->hspi, activeChain->intPin);
+#endif
 	resetASCI();
-	csOff();
+	csOff(activeChain);
 	bool successfulConfig = true;
 	// dummy transaction since this chip sucks
 	readRegister(R_CONFIG_3);
 
-	// Set Keep_Alive to 0x05 = 160us
-	successfulConfig &= writeAndVerifyRegister(R_CONFIG_3, 0x05);
+	// Set Keep_Alive. Defaults to 0x05 = 160us
+	successfulConfig &= writeAndVerifyRegister(R_CONFIG_3, activeChain->linkConfig.keepAlive);
 
 	// Enable RX_Error, RX_Overflow and RX_Busy interrupts
 	successfulConfig &= writeAndVerifyRegister(R_RX_INTERRUPT_ENABLE, 0xA8);
@@ -568,6 +1954,89 @@ bool initASCI()
 	return successfulConfig;
 }
 
+/*!
+  @brief   Resynchronize with the ASCI without power cycling it. Clears the ASCI buffers and
+		   rewrites the operating configuration written by initASCI
+  @return  True if successful resynchronization, false otherwise
+*/
+bool resyncASCI()
+{
+	DebugComm("Resynchronizing ASCI connection...\n");
+
+	// The ASCI may have been reset by the fault - do not trust the shadowed configuration
+	invalidateShadowRegisters(activeChain);
+
+	clearTxBuffer();
+	clearRxBuffer();
+
+	bool successfulConfig = true;
+	// Set Keep_Alive. Defaults to 0x05 = 160us
+	successfulConfig &= writeAndVerifyRegister(R_CONFIG_3, activeChain->linkConfig.keepAlive);
+
+	// Enable RX_Stop INT
+	successfulConfig &= writeAndVerifyRegister(R_RX_INTERRUPT_ENABLE, 0x8A);
+
+	// Enable TX_Queue mode
+	successfulConfig &= writeAndVerifyRegister(R_CONFIG_2, 0x10);
+
+	// Clear any pending RX interrupt flags
+	writeRegister(R_RX_INTERRUPT_FLAGS, 0x00);
+
+	// Verify RX_Empty
+	successfulConfig &= ((readRegister(R_RX_STATUS) & 0x01) == 0x01);
+
+	return successfulConfig;
+}
+
+/*!
+  @brief   Set the SPI clock and keep-alive used on the ASCI link. The SPI clock is changed
+		   immediately. The keep-alive is written by the next initASCI or resyncASCI
+  @param   config - The link configuration to use
+  @return  True if the configuration was set, false if the SPI clock is too fast for the ASCI
+		   or a transaction is in progress
+*/
+bool setAsciLinkConfig(const Asci_Link_Config_S* config)
+{
+	const uint32_t spiClockHz = calcAsciSpiClockHz(activeChain, config->spiPrescaler);
+	if ((spiClockHz > ASCI_MAX_SPI_CLOCK_HZ) || (activeChain->engine.state != ASCI_IDLE) || (activeChain->hspi->State != HAL_SPI_STATE_READY))
+	{
+		return false;
+	}
+
+	// The baud rate can only be changed while the SPI is disabled. HAL re-enables it on the next transfer
+	__HAL_SPI_DISABLE(activeChain->hspi);
+	MODIFY_REG(activeChain->hspi->Instance->CR1, SPI_CR1_BR, config->spiPrescaler & SPI_CR1_BR);
+	activeChain->hspi->Init.BaudRatePrescaler = config->spiPrescaler & SPI_CR1_BR;
+
+	activeChain->linkConfig.spiPrescaler = config->spiPrescaler & SPI_CR1_BR;
+	activeChain->linkConfig.keepAlive = config->keepAlive;
+	return true;
+}
+
+/*!
+  @brief   Get the SPI clock and keep-alive currently used on the ASCI link
+  @param   config - Updated with the current link configuration
+*/
+void getAsciLinkConfig(Asci_Link_Config_S* config)
+{
+	*config = activeChain->linkConfig;
+}
+
+/*!
+  @brief   Estimate the time the SPI bus of the selected chain is busy for a readAllBlock at the
+		   current SPI clock. Time spent waiting on the daisy chain is not included
+  @param   numRegisters - The number of registers read
+  @param   numBmbs - The number of BMBs on the chain
+  @return  The estimated transfer time in us
+*/
+uint32_t estimateReadAllBlockUs(uint32_t numRegisters, uint32_t numBmbs)
+{
+	// Each register is loaded as a 7 byte readAll frame and its response is read back behind the read command
+	const uint32_t bytesPerRegister = 0x07 + READ_CMD_LENGTH + 0x05 + (numBmbs * BYTES_PER_BMB_REGISTER);
+	const uint64_t numBits = (uint64_t)numRegisters * bytesPerRegister * 8;
+	return (uint32_t)((numBits * 1000000) / calcAsciSpiClockHz(activeChain, activeChain->linkConfig.spiPrescaler));
+}
+
 /*!
   @brief   Initialize BMB Daisy Chain. Enumerate BMBs
   @param   numBmbs - The number of BMBs detected in the daisy chain
@@ -598,17 +2067,36 @@ bool helloAll(uint32_t* numBmbs)
 	bmbCmdBuffer[1] = 0x00;				// Register address
 	bmbCmdBuffer[2] = 0x00;				// Initialization address for HELLOALL
 
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_HELLO_ALL);
+
+	if (commsBudgetExpired())
+	{
+		// Out of time - nothing is sent so the link is not charged
+		abortCmdTimer(&timer);
+		return false;
+	}
+
 	uint8_t* pRecvBuffer = recvBuffer;
 	if (!sendReceiveMessageAsci(sendBuffer, &pRecvBuffer, numBytesToSend, numBytesToReceive))
 	{
 		DebugComm("Error in HelloAll!\n");
 		updateLeakyBucketFail(&asciCommsLeakyBucket);
+		finishCmdTimer(&timer, 1, false);
 		return false;
 	}
 	
 	// Number of BMBs is last byte in the received message
 	*numBmbs = pRecvBuffer[bmbCmdLength - 1];
+	if (*numBmbs > MAX_BMBS_PER_CHAIN)
+	{
+		// Responses from a chain this long overflow the ASCI receive buffer
+		DebugComm("HelloAll found %lu BMBs - at most %d are supported on a chain!\n", *numBmbs, MAX_BMBS_PER_CHAIN);
+		finishCmdTimer(&timer, 1, false);
+		return false;
+	}
 	updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+	finishCmdTimer(&timer, 1, true);
 	return true;
 }
 
@@ -626,29 +2114,27 @@ bool writeAll(uint8_t address, uint16_t value, uint32_t numBmbs)
 	const uint32_t numBytesToSend = bmbCmdLength + asciCmdLength;
 	const uint32_t numBytesToReceive = bmbCmdLength;
 
-	uint8_t sendBuffer[numBytesToSend];
-	memset(sendBuffer, 0, numBytesToSend * sizeof(uint8_t));
-	// Are these large enough? Because we need the command byte as well
+	uint8_t sendBuffer[MAX_ASCI_CMD_LENGTH] __ALIGNED(4);
+	buildWriteAllFrame(sendBuffer, address, value);
 	uint8_t recvBuffer[numBytesToReceive + READ_CMD_LENGTH];
 	memset(recvBuffer, 0, (numBytesToReceive + READ_CMD_LENGTH) * sizeof(uint8_t));
 
-	uint8_t* asciCmdBuffer = sendBuffer;
-	uint8_t* bmbCmdBuffer  = &sendBuffer[asciCmdLength];
+	const uint8_t* bmbCmdBuffer = &sendBuffer[asciCmdLength];
 
-	// ASCI Command Data
-	asciCmdBuffer[0] = CMD_WR_LD_Q_L0;				// Command for ASCI
-	asciCmdBuffer[1] = numBytesToReceive;			// Data length for ASCI
-
-	// BMB Command Data
-	bmbCmdBuffer[0] = CMD_WRITE_ALL;				// Command byte for BMBs
-	bmbCmdBuffer[1] = address;						// Register Address for BMBs
-	bmbCmdBuffer[2] = (uint8_t)(value & 0x00FF);	// LSB
-	bmbCmdBuffer[3] = (uint8_t)(value >> 8);		// MSB
-	bmbCmdBuffer[4] = calcCrc(bmbCmdBuffer, bmbCmdLength - 2);	// Calculate CRC on CMD, ADDRESS, LSB, MSB
-	bmbCmdBuffer[5] = 0x00;							// Alive counter seed value for BMBs
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_WRITE_ALL);
 
 	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
 	{
+		if (commsBudgetExpired())
+		{
+			// Out of time - give up without retrying. Attempts that were never made are not
+			// charged to the link
+			DebugComm("Write all abandoned - comms budget spent\n");
+			abortCmdTimer(&timer);
+			return false;
+		}
+
 		bool writeAllSuccess = true;
 
 		// ASCI message transaction
@@ -656,22 +2142,126 @@ bool writeAll(uint8_t address, uint16_t value, uint32_t numBmbs)
 		writeAllSuccess &= sendReceiveMessageAsci(sendBuffer, &pRecvBuffer, numBytesToSend, numBytesToReceive);
 
 		// Verify BMB Command Data. Do not check last byte (alive-counter) as this will be different
-		writeAllSuccess &= !(bool)memcmp(bmbCmdBuffer, pRecvBuffer, bmbCmdLength - 1);
+		const bool echoValid = !(bool)memcmp(bmbCmdBuffer, pRecvBuffer, bmbCmdLength - 1);
 
 		// Verify the alive counter
-		writeAllSuccess &= (pRecvBuffer[bmbCmdLength - 1] == numBmbs);
+		const bool aliveCounterValid = (pRecvBuffer[bmbCmdLength - 1] == numBmbs);
+
+		if (writeAllSuccess)
+		{
+			recordFrameErrors(echoValid, aliveCounterValid);
+			recordChainLinkStats(pRecvBuffer[bmbCmdLength - 1], echoValid, numBmbs);
+		}
+		writeAllSuccess &= echoValid && aliveCounterValid;
 
 		if (writeAllSuccess)
 		{
 			updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+			finishCmdTimer(&timer, i + 1, true);
 			return true;
 		}
 	}
 	DebugComm("Failed to write all\n");
 	updateLeakyBucketFail(&asciCommsLeakyBucket);
+	finishCmdTimer(&timer, NUM_DATA_CHECKS, false);
 	return false;
 }
 
+/*!
+  @brief   Write data to a list of registers on all BMBs without retrying. The writes are
+		   loaded into the ASCI load queues and sent back to back in a single transaction
+		   engine run. Echo and alive-counter errors are counted but not retried, so drift
+		   must be caught by reading the registers back later
+  @param   addresses - Array of BMB register addresses to write to, in the order to write them
+  @param   values - Array of values to write, one per address
+  @param   numWrites - The number of registers to write. Limited to ASCI_MESSAGE_QUEUE_SIZE
+  @param   numBmbs - The number of BMBs we expect to write to
+  @return  True if every write was echoed correctly, false otherwise
+*/
+bool writeAllUnverified(const uint8_t* addresses, const uint16_t* values, uint32_t numWrites, uint32_t numBmbs)
+{
+	const uint32_t bmbCmdLength = 0x06;					// CMD, address, LSB, MSB, CRC, ALIVE_COUNTER
+	const uint32_t asciCmdLength = 0x02;				// CMD, DATA_LENGTH
+	const uint32_t numBytesToReceive = bmbCmdLength;
+
+	if ((numWrites == 0) || (numWrites > ASCI_MESSAGE_QUEUE_SIZE))
+	{
+		return false;
+	}
+
+	uint8_t recvBuffers[ASCI_MESSAGE_QUEUE_SIZE][numBytesToReceive + READ_CMD_LENGTH];
+
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_WRITE_ALL);
+
+	if (commsBudgetExpired())
+	{
+		// Out of time - nothing is sent so the link is not charged
+		abortCmdTimer(&timer);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < numWrites; i++)
+	{
+		Asci_Message_S* message = &activeChain->engine.messages[i];
+		message->numBytesToSend = buildWriteAllFrame(message->frameBuffer, addresses[i], values[i]);
+		message->sendFrame = message->frameBuffer;
+		message->recvBuffer = recvBuffers[i];
+		message->numBytesToReceive = numBytesToReceive;
+	}
+
+	// Send as many writes back to back as the load queues and the ASCI receive buffer can hold
+	runAsciEngine(numWrites, ASCI_RX_BUFFER_SIZE / numBytesToReceive);
+
+	bool writeAllSuccess = true;
+	bool budgetAborted = false;
+	for (uint32_t i = 0; i < numWrites; i++)
+	{
+		const Asci_Message_S* message = &activeChain->engine.messages[i];
+		// Return data does not include the CMD_RD_NXT_MSG
+		const uint8_t* pRecvBuffer = &recvBuffers[i][READ_CMD_LENGTH];
+
+		bool echoValid = false;
+		bool aliveCounterValid = false;
+		if (message->complete)
+		{
+			// Do not check last byte (alive-counter) as this will be different
+			echoValid = !(bool)memcmp(&message->frameBuffer[asciCmdLength], pRecvBuffer, bmbCmdLength - 1);
+			aliveCounterValid = (pRecvBuffer[bmbCmdLength - 1] == numBmbs);
+			recordFrameErrors(echoValid, aliveCounterValid);
+			recordChainLinkStats(pRecvBuffer[bmbCmdLength - 1], echoValid, numBmbs);
+		}
+
+		if (echoValid && aliveCounterValid)
+		{
+			updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+		}
+		else if (!message->complete && commsBudgetExpired())
+		{
+			// Cut short by the communication time budget rather than the link
+			invalidateShadowRegisters(activeChain);
+			budgetAborted = true;
+			writeAllSuccess = false;
+		}
+		else
+		{
+			DebugComm("Unverified write all to 0x%02X failed\n", addresses[i]);
+			updateLeakyBucketFail(&asciCommsLeakyBucket);
+			invalidateShadowRegisters(activeChain);
+			writeAllSuccess = false;
+		}
+	}
+	if (budgetAborted)
+	{
+		abortCmdTimer(&timer);
+	}
+	else
+	{
+		finishCmdTimer(&timer, 1, writeAllSuccess);
+	}
+	return writeAllSuccess;
+}
+
 /*!
   @brief   Write data to register on single BMB
   @param   address - BMB register address to write to
@@ -707,8 +2297,20 @@ bool writeDevice(uint8_t address, uint16_t value, uint32_t bmbIndex)
 	bmbCmdBuffer[4] = calcCrc(bmbCmdBuffer, bmbCmdLength - 2);	// Calculate CRC on CMD, ADDRESS, LSB, MSB
 	bmbCmdBuffer[5] = 0x00;							// Alive counter seed value for BMBs
 
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_WRITE_DEVICE);
+
 	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
 	{
+		if (commsBudgetExpired())
+		{
+			// Out of time - give up without retrying. Attempts that were never made are not
+			// charged to the link
+			DebugComm("Write device abandoned - comms budget spent\n");
+			abortCmdTimer(&timer);
+			return false;
+		}
+
 		bool writeAllSuccess = true;
 
 		// ASCI message transaction
@@ -716,19 +2318,28 @@ bool writeDevice(uint8_t address, uint16_t value, uint32_t bmbIndex)
 		writeAllSuccess &= sendReceiveMessageAsci(sendBuffer, &pRecvBuffer, numBytesToSend, numBytesToReceive);
 
 		// Verify BMB Command Data. Do not check last byte (alive-counter) as this will be different
-		writeAllSuccess &= !(bool)memcmp(bmbCmdBuffer, pRecvBuffer, bmbCmdLength - 1);
+		const bool echoValid = !(bool)memcmp(bmbCmdBuffer, pRecvBuffer, bmbCmdLength - 1);
 
 		// Verify the alive counter
-		writeAllSuccess &= (pRecvBuffer[bmbCmdLength - 1] == 1);
+		const bool aliveCounterValid = (pRecvBuffer[bmbCmdLength - 1] == 1);
+
+		if (writeAllSuccess)
+		{
+			recordFrameErrors(echoValid, aliveCounterValid);
+			recordDeviceLinkStats(bmbIndex, echoValid, aliveCounterValid);
+		}
+		writeAllSuccess &= echoValid && aliveCounterValid;
 
 		if (writeAllSuccess)
 		{
 			updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+			finishCmdTimer(&timer, i + 1, true);
 			return true;
 		}
 	}
 	DebugComm("Failed to write device\n");
 	updateLeakyBucketFail(&asciCommsLeakyBucket);
+	finishCmdTimer(&timer, NUM_DATA_CHECKS, false);
 	return false;
 }
 
@@ -741,55 +2352,174 @@ bool writeDevice(uint8_t address, uint16_t value, uint32_t bmbIndex)
 */
 bool readAll(uint8_t address, uint8_t *data_p, uint32_t numBmbs)
 {
-	const uint32_t bmbCmdLength = 0x05;					// CMD, address, DATA_CHECK, CRC, ALIVE_COUNTER
-	const uint32_t asciCmdLength = 0x02;				// CMD, DATA_LENGTH
-	const uint32_t numBytesToSend = bmbCmdLength + asciCmdLength;
-	const uint32_t numBytesToReceive = bmbCmdLength + numBmbs * BYTES_PER_BMB_REGISTER;
-
-	uint8_t sendBuffer[numBytesToSend];
-	memset(sendBuffer, 0, numBytesToSend * sizeof(uint8_t));
-
-	uint8_t* asciCmdBuffer = sendBuffer;
-	uint8_t* bmbCmdBuffer  = &sendBuffer[asciCmdLength];
+	const uint32_t numBytesToReceive = 0x05 + numBmbs * BYTES_PER_BMB_REGISTER;
 
-	// ASCI Command Data
-	asciCmdBuffer[0] = CMD_WR_LD_Q_L0;				// Command for ASCI
-	asciCmdBuffer[1] = numBytesToReceive;			// Data length for ASCI
+	uint8_t frameBuffer[MAX_ASCI_CMD_LENGTH] __ALIGNED(4);
+	uint32_t numBytesToSend = 0;
+	const uint8_t* sendBuffer = getReadAllFrame(activeChain, address, numBmbs, frameBuffer, &numBytesToSend);
 
-	// BMB Command Data
-	bmbCmdBuffer[0] = CMD_READ_ALL;					// Command byte for BMBs
-	bmbCmdBuffer[1] = address;						// Register Address for BMBs
-	bmbCmdBuffer[2] = 0x00;							// Data check byte
-	bmbCmdBuffer[3] = calcCrc(bmbCmdBuffer, bmbCmdLength - 2);	// Calculate CRC on CMD, ADDRESS, DATA_CHECK
-	bmbCmdBuffer[4] = 0x00;							// Alive counter seed value for BMBs
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_READ_ALL);
 
 	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
 	{
+		if (commsBudgetExpired())
+		{
+			// Out of time - give up without retrying. Attempts that were never made are not
+			// charged to the link
+			DebugComm("Read all abandoned - comms budget spent\n");
+			abortCmdTimer(&timer);
+			return false;
+		}
+
 		bool readAllSuccess = true;
 
 		uint8_t* pRecvBuffer = data_p;
 		readAllSuccess &= sendReceiveMessageAsci(sendBuffer, &pRecvBuffer, numBytesToSend, numBytesToReceive);
 
-		// Calculate CRC code based on received data
-		const uint8_t calculatedCrc = calcCrc(pRecvBuffer, numBytesToReceive - 2); // Do not read PEC byte and alive counter byte
-		uint8_t recvCrc = pRecvBuffer[3 + (BYTES_PER_BMB_REGISTER * numBmbs)];
+		// Calculate CRC code based on received data. Do not read PEC byte and alive counter byte
+		const uint8_t calculatedCrc = calcCrc(pRecvBuffer, numBytesToReceive - 2);
 
-		// Verify data CRC
-		readAllSuccess &= (calculatedCrc == recvCrc);
-		// Verify Alive-counter byte
-		readAllSuccess &= (pRecvBuffer[4 + (BYTES_PER_BMB_REGISTER * numBmbs)] == numBmbs);
+		// Verify data CRC and Alive-counter byte. Frame errors are only counted for completed transactions
+		readAllSuccess = readAllSuccess && readAllFrameValid(pRecvBuffer, calculatedCrc, numBmbs);
 
 		if (readAllSuccess)
 		{
 			updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+			finishCmdTimer(&timer, i + 1, true);
 			return true;
 		}
 	}
 	DebugComm("Failed to read all\n");
 	updateLeakyBucketFail(&asciCommsLeakyBucket);
+	finishCmdTimer(&timer, NUM_DATA_CHECKS, false);
 	return false;
 }
 
+/*!
+  @brief   Read data from multiple registers on all BMBs. All reads are queued in the ASCI
+		   transaction engine and run back to back in the background, blocking the calling
+		   task only once. Any read that fails is retried with readAll
+  @param   requests - Array of registers to read and buffers to read the data in to. Each
+		   buffer must be able to hold the read command byte plus a full readAll message
+  @param   numRequests - The number of requests in the array
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if all reads succeeded, false otherwise
+*/
+bool readAllQueued(ReadAllRequest_S* requests, uint32_t numRequests, uint32_t numBmbs)
+{
+	// Only the selected chain is read
+	ReadAllRequest_S* chainRequests[NUM_ASCI_CHAINS] = { NULL };
+	uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = { 0 };
+	chainRequests[getAsciChain()] = requests;
+	chainNumBmbs[getAsciChain()] = numBmbs;
+	return readAllChains(chainRequests, chainNumBmbs, numRequests);
+}
+
+/*!
+  @brief   Read data from a list of registers on all BMBs. Up to ASCI_NUM_LOAD_QUEUES reads are
+		   preloaded into the ASCI load queues, sent back to back and drained from the receive
+		   buffer together. Any read that fails is retried with readAll
+  @param   addresses - Array of BMB register addresses to read from
+  @param   numAddresses - The number of registers to read
+  @param   data_p - Array of buffers to read the data in to, one per address. Each buffer must
+		   be able to hold the read command byte plus a full readAll message
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if all reads succeeded, false otherwise
+*/
+bool readAllBatch(const uint8_t* addresses, uint32_t numAddresses, uint8_t** data_p, uint32_t numBmbs)
+{
+	if (numAddresses == 0)
+	{
+		return true;
+	}
+
+	ReadAllRequest_S requests[numAddresses];
+	for (uint32_t i = 0; i < numAddresses; i++)
+	{
+		requests[i].address = addresses[i];
+		requests[i].data_p = data_p[i];
+	}
+	return readAllQueued(requests, numAddresses, numBmbs);
+}
+
+/*!
+  @brief   Read data from a contiguous range of registers on all BMBs. The MAX17823 has no
+		   block read command so the range is read with batched readAll commands queued in
+		   the ASCI transaction engine. Any read that fails is retried with readAll
+  @param   startAddress - The first BMB register address to read from
+  @param   numRegisters - The number of consecutive registers to read
+  @param   data_p - Array of buffers to read the data in to, one per register. Each buffer holds
+		   the read command byte followed by the readAll message for that register
+  @param   success_p - Array set with the result of each register read. May be NULL
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if all reads succeeded, false otherwise
+*/
+bool readAllBlock(uint8_t startAddress, uint32_t numRegisters, uint8_t (*data_p)[SPI_BUFF_SIZE], bool* success_p, uint32_t numBmbs)
+{
+	if (numRegisters == 0)
+	{
+		return true;
+	}
+
+	ReadAllRequest_S requests[numRegisters];
+	for (uint32_t i = 0; i < numRegisters; i++)
+	{
+		requests[i].address = startAddress + i;
+		requests[i].data_p = data_p[i];
+	}
+	const bool readAllSuccess = readAllQueued(requests, numRegisters, numBmbs);
+
+	for (uint32_t i = 0; (success_p != NULL) && (i < numRegisters); i++)
+	{
+		success_p[i] = requests[i].success;
+	}
+	return readAllSuccess;
+}
+
+/*!
+  @brief   Read data from a contiguous range of registers on all BMBs of every ASCI daisy chain.
+		   The chains are read concurrently, each by its own transaction engine, so the readout
+		   takes as long as the longest chain. Any read that fails is retried with readAll on its
+		   chain. Leaves the last chain read selected
+  @param   startAddress - The first BMB register address to read from
+  @param   numRegisters - The number of consecutive registers to read
+  @param   reads - Array of buffers and BMB counts, one per chain. See readAllBlock
+  @return  True if all reads on all chains succeeded, false otherwise
+*/
+bool readAllBlockChains(uint8_t startAddress, uint32_t numRegisters, Chain_Block_Read_S* reads)
+{
+	if (numRegisters == 0)
+	{
+		return true;
+	}
+
+	ReadAllRequest_S requests[NUM_ASCI_CHAINS][numRegisters];
+	ReadAllRequest_S* chainRequests[NUM_ASCI_CHAINS];
+	uint32_t chainNumBmbs[NUM_ASCI_CHAINS];
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		// Chains without BMBs are skipped
+		chainNumBmbs[chainIdx] = reads[chainIdx].numBmbs;
+		chainRequests[chainIdx] = (reads[chainIdx].numBmbs > 0) ? requests[chainIdx] : NULL;
+		for (uint32_t i = 0; i < numRegisters; i++)
+		{
+			requests[chainIdx][i].address = startAddress + i;
+			requests[chainIdx][i].data_p = reads[chainIdx].data_p[i];
+		}
+	}
+	const bool readAllSuccess = readAllChains(chainRequests, chainNumBmbs, numRegisters);
+
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		for (uint32_t i = 0; (chainRequests[chainIdx] != NULL) && (reads[chainIdx].success_p != NULL) && (i < numRegisters); i++)
+		{
+			reads[chainIdx].success_p[i] = requests[chainIdx][i].success;
+		}
+	}
+	return readAllSuccess;
+}
+
 /*!
   @brief   Read data from register on single BMB
   @param   address - BMB register address to read from
@@ -822,8 +2552,20 @@ bool readDevice(uint8_t address, uint8_t *data_p, uint32_t bmbIndex)
 	bmbCmdBuffer[3] = calcCrc(bmbCmdBuffer, bmbCmdLength - 2);	// Calculate CRC on CMD, ADDRESS, DATA_CHECK
 	bmbCmdBuffer[4] = 0x00;							// Alive counter seed value for BMBs
 
+	Cmd_Timer_S timer;
+	startCmdTimer(&timer, ASCI_CMD_READ_DEVICE);
+
 	for (int32_t i = 0; i < NUM_DATA_CHECKS; i++)
 	{
+		if (commsBudgetExpired())
+		{
+			// Out of time - give up without retrying. Attempts that were never made are not
+			// charged to the link
+			DebugComm("Read device abandoned - comms budget spent\n");
+			abortCmdTimer(&timer);
+			return false;
+		}
+
 		bool readAllSuccess = true;
 
 		uint8_t* pRecvBuffer = data_p;
@@ -834,17 +2576,425 @@ bool readDevice(uint8_t address, uint8_t *data_p, uint32_t bmbIndex)
 		uint8_t recvCrc = pRecvBuffer[numBytesToReceive - 2];
 
 		// Verify data CRC
-		readAllSuccess &= (calculatedCrc == recvCrc);
+		const bool crcValid = (calculatedCrc == recvCrc);
 		// Verify Alive-counter byte
-		readAllSuccess &= (pRecvBuffer[numBytesToReceive - 1] == 1);
+		const bool aliveCounterValid = (pRecvBuffer[numBytesToReceive - 1] == 1);
+
+		if (readAllSuccess)
+		{
+			recordFrameErrors(crcValid, aliveCounterValid);
+			recordDeviceLinkStats(bmbIndex, crcValid, aliveCounterValid);
+		}
+		readAllSuccess &= crcValid && aliveCounterValid;
 
 		if (readAllSuccess)
 		{
 			updateLeakyBucketSuccess(&asciCommsLeakyBucket);
+			finishCmdTimer(&timer, i + 1, true);
 			return true;
 		}
 	}
 	DebugComm("Failed to read device\n");
 	updateLeakyBucketFail(&asciCommsLeakyBucket);
+	finishCmdTimer(&timer, NUM_DATA_CHECKS, false);
+	return false;
+}
+
+/*!
+  @brief   Set the policy used to decide when the ASCI load queue is read back and verified
+		   after being written. BMB frames carry a CRC and alive-counter so a corrupted load
+		   queue is still detected when verification is skipped. A load following a failed
+		   verify is always verified. Defaults to DEFAULT_QUEUE_VERIFY_POLICY
+  @param   policy - The verification policy to use
+  @param   interval - Verify every interval transactions. Only used by QUEUE_VERIFY_EVERY_NTH
+*/
+void setQueueVerifyPolicy(Queue_Verify_Policy_E policy, uint32_t interval)
+{
+	queueVerifyPolicy = policy;
+	queueVerifyInterval = interval;
+	queueVerifyCount = 0;
+}
+
+/*!
+  @brief   Start a communication time budget shared by every BMB command and retry. Once the
+		   budget is spent commands fail without being sent so that the caller can abort cleanly
+  @param   budgetMs - The time allowed for all communication until endCommsBudget is called
+*/
+void startCommsBudget(uint32_t budgetMs)
+{
+	commsBudget.startTick = HAL_GetTick();
+	commsBudget.budgetMs = budgetMs;
+	commsBudget.exhausted = false;
+	commsBudget.active = true;
+}
+
+/*!
+  @brief   End the current communication time budget and record how much of it was used
+  @return  True if the budget was exhausted, false otherwise
+*/
+bool endCommsBudget()
+{
+	commsBudget.active = false;
+
+	const uint32_t usedMs = HAL_GetTick() - commsBudget.startTick;
+	asciStats.lastBudgetUsedMs = usedMs;
+	if (usedMs > asciStats.maxBudgetUsedMs)
+	{
+		asciStats.maxBudgetUsedMs = usedMs;
+	}
+	if (commsBudget.exhausted)
+	{
+		asciStats.numBudgetsExhausted++;
+	}
+	return commsBudget.exhausted;
+}
+
+/*!
+  @brief   Record a VERSION read that returned an unexpected model number against the link
+		   statistics of a BMB on the selected chain
+  @param   bmbIdx - The daisy chain position of the BMB, as used by readDevice
+*/
+void recordBmbVersionMismatch(uint32_t bmbIdx)
+{
+	if (bmbIdx >= LINK_STATS_MAX_BMBS)
+	{
+		return;
+	}
+	bmbLinkStats[getAsciChain()][bmbIdx].numVersionMismatches++;
+	updateLinkErrorRate(bmbIdx, true);
+}
+
+/*!
+  @brief   Find the BMB on the selected chain with the worst link error rate, if it is high enough to be suspect. An
+		   alive-counter shortfall is charged to the first BMB that did not process the frame, so
+		   the suspect is the BMB at the far end of the failing hop
+  @param   numBmbs - The number of BMBs in the daisy chain
+  @return  The daisy chain position of the suspect BMB, -1 if no link is suspect
+*/
+int32_t getSuspectBmbLink(uint32_t numBmbs)
+{
+	int32_t suspectIdx = -1;
+	uint16_t worstErrorRate = LINK_SUSPECT_ERROR_RATE - 1;
+	for (uint32_t i = 0; (i < numBmbs) && (i < LINK_STATS_MAX_BMBS); i++)
+	{
+		if (bmbLinkStats[getAsciChain()][i].errorRate > worstErrorRate)
+		{
+			worstErrorRate = bmbLinkStats[getAsciChain()][i].errorRate;
+			suspectIdx = i;
+		}
+	}
+	return suspectIdx;
+}
+
+/*!
+  @brief   Clear the link statistics of all BMBs on all chains. Should be called after a harness or BMB is replaced
+*/
+void resetBmbLinkStats()
+{
+	memset(bmbLinkStats, 0, sizeof(bmbLinkStats));
+	asciStats.numUnlocatedLinkErrors = 0;
+}
+
+/*!
+  @brief   Start or stop recording BMB frames into the frame capture ring buffer. Starting a
+		   capture clears the buffer. Only available when ASCI_FRAME_CAPTURE is set
+  @param   enabled - True to start recording, false to stop and keep the captured frames
+*/
+void setAsciFrameCapture(bool enabled)
+{
+#if ASCI_FRAME_CAPTURE
+	if (enabled && !asciCapture.enabled)
+	{
+		asciCapture.head = 0;
+		asciCapture.numFrames = 0;
+		asciCapture.numDropped = 0;
+	}
+	asciCapture.enabled = enabled;
+#else
+	(void)enabled;
+#endif
+}
+
+/*!
+  @brief   Determine whether an SPI bus has an ASCI on it
+  @param   hspi - The SPI handle to check
+  @return  True if the SPI bus belongs to an ASCI daisy chain, false otherwise
+*/
+bool isAsciSpi(SPI_HandleTypeDef* hspi)
+{
+	return findAsciChainBySpi(hspi) != NULL;
+}
+
+/*!
+  @brief   Determine whether a GPIO pin is the INT pin of an ASCI
+  @param   pin - The GPIO pin to check
+  @return  True if the pin is an ASCI INT pin, false otherwise
+*/
+bool isAsciInterruptPin(uint16_t pin)
+{
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (asciChains[chainIdx].intPin == pin)
+		{
+			return true;
+		}
+	}
 	return false;
 }
+
+/*!
+  @brief   Handle an SPI transfer completion for the ASCI transaction engine. Should be called
+		   from the SPI TX/RX complete callback
+  @param   hspi - The SPI handle the transfer completed on
+  @return  True if the transfer belonged to a transaction engine, false otherwise
+*/
+bool asciSpiCompleteCallback(SPI_HandleTypeDef* hspi)
+{
+	Asci_Chain_S* chain = findAsciChainBySpi(hspi);
+	if ((chain == NULL) || (chain->engine.state == ASCI_IDLE))
+	{
+		return false;
+	}
+
+	csOff(chain);
+
+	Asci_Message_S* message = &chain->engine.messages[chain->engine.messageIdx];
+	const uint8_t result = chain->engine.rxBuffer[1];
+	switch (chain->engine.state)
+	{
+		case ASCI_CLR_RX_BUF:
+			startAsciState(chain, ASCI_CLR_TX_BUF);
+			break;
+
+		case ASCI_CLR_TX_BUF:
+			chain->engine.attemptNum = 0;
+			startAsciState(chain, ASCI_LOAD_QUEUE);
+			break;
+
+		case ASCI_LOAD_QUEUE:
+			// A load following a failed verify is always verified, whatever the policy
+			if (chain->engine.queueVerifyFailed || queueVerifyRequired())
+			{
+				asciStats.numQueueVerifies++;
+				startAsciState(chain, ASCI_VERIFY_QUEUE);
+				break;
+			}
+			// Rely on the BMB frame CRC and alive-counter to catch a corrupted load queue
+			asciStats.numQueueVerifiesSkipped++;
+			asciStats.queueVerifyBytesSaved += message->numBytesToSend;
+			loadNextAsciQueue(chain);
+			break;
+
+		case ASCI_VERIFY_QUEUE:
+			// Do not check first byte. This is the read command echo
+			chain->engine.queueVerifyFailed = (memcmp(&message->sendFrame[1], &chain->engine.rxBuffer[1], message->numBytesToSend - 1) != 0);
+			if (!chain->engine.queueVerifyFailed)
+			{
+				loadNextAsciQueue(chain);
+			}
+			else
+			{
+				retryAsciState(chain, ASCI_LOAD_QUEUE);
+			}
+			break;
+
+		case ASCI_WRITE_RX_INT_ENABLE:
+			startAsciState(chain, ASCI_VERIFY_RX_INT_ENABLE);
+			break;
+
+		case ASCI_VERIFY_RX_INT_ENABLE:
+			if (result == 0x8A)
+			{
+				updateShadowRegister(chain, R_RX_INTERRUPT_ENABLE, 0x8A);
+				chain->engine.attemptNum = 0;
+				startAsciState(chain, ASCI_CLR_RX_INT_FLAGS);
+			}
+			else
+			{
+				invalidateShadowRegisters(chain);
+				retryAsciState(chain, ASCI_WRITE_RX_INT_ENABLE);
+			}
+			break;
+
+		case ASCI_CLR_RX_INT_FLAGS:
+			startAsciState(chain, ASCI_VERIFY_RX_INT_FLAGS);
+			break;
+
+		case ASCI_VERIFY_RX_INT_FLAGS:
+			// TODO - double check why this is necessary?
+			if ((result & ~(0x40)) == 0x00)
+			{
+				chain->engine.messageIdx = chain->engine.batchStart;
+				startAsciState(chain, ASCI_SEND_MESSAGE);
+			}
+			else
+			{
+				retryAsciState(chain, ASCI_CLR_RX_INT_FLAGS);
+			}
+			break;
+
+		case ASCI_SEND_MESSAGE:
+			// Release every loaded queue back to back before waiting for the responses
+			chain->engine.messageIdx++;
+			if (chain->engine.messageIdx < chain->engine.batchEnd)
+			{
+				startAsciState(chain, ASCI_SEND_MESSAGE);
+			}
+			else
+			{
+				chain->engine.messageIdx = chain->engine.batchStart;
+				startAsciState(chain, ASCI_WAIT_RX_STOP);
+			}
+			break;
+
+		case ASCI_READ_RX_STATUS:
+			// Verify that interrupt was caused by RX_Stop
+			if ((result & 0x02) == 0x02)
+			{
+				startAsciState(chain, ASCI_READ_MESSAGE);
+			}
+			else
+			{
+				finishAsciBatch(chain, false);
+			}
+			break;
+
+		case ASCI_READ_MESSAGE:
+			chain->engine.rxStopRearmed = false;
+			chain->engine.messageIdx++;
+			if (chain->engine.messageIdx < chain->engine.batchEnd)
+			{
+				// Responses arrive in the order the queues were sent
+				startAsciState(chain, ASCI_READ_NEXT_STATUS);
+			}
+			else
+			{
+				startAsciState(chain, ASCI_READ_RX_INT_FLAGS);
+			}
+			// Calculate the CRC of the received message while the next transfer is in progress
+			message->recvCrc = calcCrc(&message->recvBuffer[READ_CMD_LENGTH], message->numBytesToReceive - 2);
+#if ASCI_FRAME_CAPTURE
+			captureAsciFrame(ASCI_FRAME_RX, message->recvBuffer, message->numBytesToReceive + READ_CMD_LENGTH);
+#endif
+			break;
+
+		case ASCI_READ_NEXT_STATUS:
+			if ((result & 0x01) == 0x00)
+			{
+				// RX buffer not empty - next response available
+				startAsciState(chain, ASCI_READ_MESSAGE);
+			}
+			else if (!chain->engine.rxStopRearmed)
+			{
+				// Next response not yet received. Re-arm the RX_Stop interrupt and check again since
+				// the response may have completed before the interrupt flags were cleared
+				startAsciState(chain, ASCI_CHECK_RX_ERRORS);
+			}
+			else
+			{
+				startAsciState(chain, ASCI_WAIT_RX_STOP);
+			}
+			break;
+
+		case ASCI_CHECK_RX_ERRORS:
+			if (result & 0x88)
+			{
+				DebugComm("Detected errors during transmission!\n");
+				finishAsciBatch(chain, false);
+			}
+			else
+			{
+				startAsciState(chain, ASCI_REARM_RX_STOP);
+			}
+			break;
+
+		case ASCI_REARM_RX_STOP:
+			startAsciState(chain, ASCI_READ_NEXT_STATUS);
+			break;
+
+		case ASCI_READ_RX_INT_FLAGS:
+			if (result & 0x88)
+			{
+				DebugComm("Detected errors during transmission!\n");
+				finishAsciBatch(chain, false);
+			}
+			else
+			{
+				finishAsciBatch(chain, true);
+			}
+			break;
+
+		default:
+			break;
+	}
+	return true;
+}
+
+/*!
+  @brief   Handle an SPI transfer error for the ASCI transaction engine. Should be called
+		   from the SPI error callback
+  @param   hspi - The SPI handle the error occured on
+  @return  True if the transfer belonged to a transaction engine, false otherwise
+*/
+bool asciSpiErrorCallback(SPI_HandleTypeDef* hspi)
+{
+	Asci_Chain_S* chain = findAsciChainBySpi(hspi);
+	if ((chain == NULL) || (chain->engine.state == ASCI_IDLE))
+	{
+		return false;
+	}
+
+	csOff(chain);
+	finishAsciBatch(chain, false);
+	return true;
+}
+
+/*!
+  @brief   Handle the ASCI external interrupt for the ASCI transaction engine. Should be called
+		   from the GPIO EXTI callback for the ASCI INT pins
+  @param   pin - The GPIO pin that triggered the interrupt
+  @return  True if the interrupt was consumed by a transaction engine, false otherwise
+*/
+bool asciInterruptCallback(uint16_t pin)
+{
+	Asci_Chain_S* chain = NULL;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (asciChains[chainIdx].intPin == pin)
+		{
+			chain = &asciChains[chainIdx];
+		}
+	}
+	if (chain == NULL)
+	{
+		return false;
+	}
+
+	switch (chain->engine.state)
+	{
+		case ASCI_WAIT_RX_STOP:
+			startAsciState(chain, ASCI_READ_RX_STATUS);
+			return true;
+
+		case ASCI_SEND_MESSAGE:
+		case ASCI_REARM_RX_STOP:
+		case ASCI_READ_NEXT_STATUS:
+			// RX_Stop occured before the engine started waiting for it
+			chain->engine.rxStopPending = true;
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+/*!
+  @brief   Record an interrupt serviced on the ASCI link. Should be called at the end of the
+		   SPI1, SPI1 DMA and ASCI EXTI interrupt handlers
+  @param   startCycles - DWT cycle count sampled at the start of the interrupt handler
+*/
+void updateAsciIsrStats(uint32_t startCycles)
+{
+	asciStats.numInterrupts++;
+	asciStats.isrCycles += DWT->CYCCNT - startCycles;
+}
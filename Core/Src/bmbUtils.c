@@ -56,19 +56,19 @@ LookupTable_S zenerTable= { .length = TABLE_SIZE, .x = zenerVoltageArray, .y = t
   @param   arr - Pointer to the Brick_S array to be searched
   @param   l - Index of the left element of the array 
   @param   r - Index of the right element of the array
-  @param   v - The target voltage to be compared to the Brick_S struct voltage
+  @param   v - The target voltage code to be compared to the Brick_S struct voltage code
   @return  Index at which voltage is to be inserted
 */
-int32_t brickBinarySearch(Brick_S *arr, int l, int r, float v)
+int32_t brickBinarySearch(Brick_S *arr, int l, int r, uint16_t v)
 {
   while (l <= r)
   {
     int32_t m = l + (r - l) / 2;
-    if (fequals(arr[m].brickV, v))
+    if (arr[m].brickVCode == v)
     {
     	return m;
     }
-    if (arr[m].brickV < v)
+    if (arr[m].brickVCode < v)
     {
     	l = m + 1;
     }
@@ -96,7 +96,7 @@ void insertionSort(Brick_S *arr, int numBricks)
   {
     Brick_S temp = arr[unsortedIdx];
     int32_t sortedIdx = unsortedIdx - 1;
-    int32_t pos = brickBinarySearch(arr, 0, sortedIdx, temp.brickV);
+    int32_t pos = brickBinarySearch(arr, 0, sortedIdx, temp.brickVCode);
     while (sortedIdx >= pos)
     {
       arr[sortedIdx + 1] = arr[sortedIdx];
@@ -6,6 +6,7 @@
 #include "bms.h"
 #include "bmb.h"
 #include "bmbInterface.h"
+#include "nvConfig.h"
 #include "leakyBucket.h"
 #include "debug.h"
 #include "GopherCAN.h"
@@ -13,32 +14,22 @@
 #include "internalResistance.h"
 #include "gopher_sense.h"
 #include "charger.h"
+#include <math.h>
 
 /* ==================================================================== */
 /* ============================= DEFINES ============================== */
 /* ==================================================================== */
-#define MAX_BRICK_VOLTAGE_READING 5.0f
-#define MIN_BRICK_VOLTAGE_READING 0.0f
-
 #define MAX_TEMP_SENSE_READING 	  120.0f
 #define MIN_TEMP_SENSE_READING	  (-40.0f)
 
 #define EPAP_UPDATE_PERIOD_MS	  2000
 #define ALERT_MONITOR_PERIOD_MS	  10
 
+#define NUM_LINK_CAL_KEEP_ALIVES  (sizeof(linkCalKeepAlives) / sizeof(linkCalKeepAlives[0]))
+
 Bms_S gBms = 
 {
     .numBmbs = NUM_BMBS_IN_ACCUMULATOR,
-    .bmb = 
-	{
-        [0] = {.bmbIdx = 0},
-        [1] = {.bmbIdx = 1},
-        [2] = {.bmbIdx = 2},
-        [3] = {.bmbIdx = 3},
-        [4] = {.bmbIdx = 4},
-        [5] = {.bmbIdx = 5},
-        [6] = {.bmbIdx = 6}
-    },
 	/* Initially we can assume that the SOC by OCV method is reliable since pack was just initialized*/
 	.soc.socByOcvGoodTimer.timCount = SOC_BY_OCV_GOOD_QUALIFICATION_TIME_MS, 
 	.soc.socByOcvGoodTimer.lastUpdate = 0,
@@ -55,6 +46,24 @@ extern CAN_HandleTypeDef hcan2;
 
 extern bool newChargerMessage;
 extern LeakyBucket_S asciCommsLeakyBucket;
+extern Asci_Stats_S asciStats;
+extern Asci_Cmd_Stats_S asciCmdStats[NUM_ASCI_CMD_TYPES];
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+// ASCI keep-alive settings tried by the link calibration. 0x04 = 80us through 0x07 = 640us
+static const uint8_t linkCalKeepAlives[] = { 0x04, 0x05, 0x06, 0x07 };
+
+// The number of BMBs expected on each ASCI daisy chain
+static const uint32_t expectedChainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+// Target refresh period of each BMB scan data product, indexed by Scan_Product_E
+static const uint32_t scanPeriodMs[NUM_SCAN_PRODUCTS] =
+{
+	SCAN_CELL_V_PERIOD_MS, SCAN_CELL_EXTREMES_PERIOD_MS, SCAN_SEGMENT_V_PERIOD_MS, SCAN_BRICK_TEMP_PERIOD_MS, SCAN_BOARD_TEMP_PERIOD_MS, SCAN_DIAGNOSTICS_PERIOD_MS
+};
 
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DECLARATIONS ==================== */
@@ -62,6 +71,26 @@ extern LeakyBucket_S asciCommsLeakyBucket;
 
 static void disableBmbBalancing(Bmb_S* bmb);
 
+static uint32_t countAsciLinkErrors();
+
+static void startPackInit();
+
+static void resumePackMonitoring(uint32_t numBmbs);
+
+static void balanceAllChains();
+
+static bool setAllAsciLinkConfigs(const Asci_Link_Config_S* config);
+
+static bool resyncAllASCI();
+
+static bool runLinkCalibrationStep(const uint32_t* chainNumBmbs, uint32_t numScans, uint32_t* readoutCycles);
+
+static void planPackScans();
+
+static void updateAcqProfile();
+
+static void pollPackAlerts();
+
 
 /* ==================================================================== */
 /* =================== LOCAL FUNCTION DEFINITIONS ===================== */
@@ -82,6 +111,198 @@ static void setAmsFault(bool set)
 	return;
 }
 
+/*!
+  @brief   Count every frame error, timeout and failed command seen on the ASCI link
+  @returns The total number of errors
+*/
+static uint32_t countAsciLinkErrors()
+{
+	uint32_t numErrors = 0;
+	for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+	{
+		numErrors += asciCmdStats[i].numCrcErrors + asciCmdStats[i].numAliveCounterErrors +
+					 asciCmdStats[i].numTimeouts + asciCmdStats[i].numFailures;
+	}
+	return numErrors;
+}
+
+/*!
+  @brief   Assert the AMS fault and disable balancing and charging until the BMBs on every daisy
+		   chain are initialized
+*/
+static void startPackInit()
+{
+	setAmsFault(true);
+	gBms.balancingDisabled = true;
+	gBms.emergencyBleed    = false;
+	gBms.chargingDisabled  = true;
+	gBms.limpModeEnabled   = false;
+	gBms.amsFaultPresent   = false;
+}
+
+/*!
+  @brief   Resume monitoring the pack once the BMBs on every daisy chain are initialized or recovered
+  @param   numBmbs - The number of BMBs found on all daisy chains
+*/
+static void resumePackMonitoring(uint32_t numBmbs)
+{
+	gBms.numBmbs = numBmbs;
+	gBms.bmsHwState = BMS_NOMINAL;
+	planPackScans();
+}
+
+/*!
+  @brief   Apply the balance requests of every BMB on every ASCI daisy chain
+*/
+static void balanceAllChains()
+{
+	uint32_t firstBmbIdx = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		if (gBms.chainNumBmbs[chainIdx] > 0)
+		{
+			selectAsciChain(chainIdx);
+			balanceCells(&gBms.bmb[firstBmbIdx], gBms.chainNumBmbs[chainIdx]);
+		}
+		firstBmbIdx += gBms.chainNumBmbs[chainIdx];
+	}
+}
+
+/*!
+  @brief   Apply an ASCI link configuration to every daisy chain
+  @param   config - The configuration to apply
+  @returns bool True if every chain accepted the configuration, false otherwise
+*/
+static bool setAllAsciLinkConfigs(const Asci_Link_Config_S* config)
+{
+	bool success = true;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		selectAsciChain(chainIdx);
+		success &= setAsciLinkConfig(config);
+	}
+	return success;
+}
+
+/*!
+  @brief   Resynchronize the ASCI of every daisy chain
+  @returns bool True if every ASCI resynchronized, false otherwise
+*/
+static bool resyncAllASCI()
+{
+	bool success = true;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		selectAsciChain(chainIdx);
+		success &= resyncASCI();
+	}
+	return success;
+}
+
+/*!
+  @brief   Run scan readouts with the current ASCI link configuration and check for errors
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   numScans - The number of scan readouts to run
+  @param   readoutCycles - Updated with the average cycles taken per scan readout
+  @returns bool True if every readout completed without errors, false otherwise
+*/
+static bool runLinkCalibrationStep(const uint32_t* chainNumBmbs, uint32_t numScans, uint32_t* readoutCycles)
+{
+	resetLeakyBucket(&asciCommsLeakyBucket);
+	const uint32_t startErrors = countAsciLinkErrors();
+	const uint32_t startBudgetsExhausted = asciStats.numBudgetsExhausted;
+
+	uint32_t numReadouts = 0;
+	uint32_t totalCycles = 0;
+	for (uint32_t i = 0; i < numScans; i++)
+	{
+		if (runBmbScanToReadout(gBms.bmb, chainNumBmbs))
+		{
+			numReadouts++;
+			totalCycles += asciStats.lastUpdateCycles;
+		}
+		if (leakyBucketFilled(&asciCommsLeakyBucket))
+		{
+			// Link is unusable with this configuration
+			break;
+		}
+	}
+
+	*readoutCycles = (numReadouts > 0) ? (totalCycles / numReadouts) : UINT32_MAX;
+	return (numReadouts == numScans) &&
+		   (countAsciLinkErrors() == startErrors) &&
+		   (asciStats.numBudgetsExhausted == startBudgetsExhausted);
+}
+
+/*!
+  @brief   Plan the BMB scans for the target data rates at the current ASCI link configuration.
+		   Chains are read out concurrently so the longest chain sets the readout time
+*/
+static void planPackScans()
+{
+	uint32_t longestChain = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		longestChain = (gBms.chainNumBmbs[chainIdx] > longestChain) ? gBms.chainNumBmbs[chainIdx] : longestChain;
+	}
+
+	// All chains share the link configuration
+	selectAsciChain(0);
+	if (!planBmbScans(scanPeriodMs, longestChain))
+	{
+		Debug("BMB scan rates reduced to fit the ASCI link\n");
+	}
+}
+
+
+/*!
+  @brief   Select the acquisition profile from the tractive current. Under load cell voltages
+		   move quickly so fresh data is worth more than low noise. Fast scans are also used when
+		   the current is unknown
+*/
+static void updateAcqProfile()
+{
+	const float current = fabsf(gBms.tractiveSystemCurrent);
+	Acq_Profile_E profile = getAcqProfile();
+	if ((gBms.tractiveSystemCurrentStatus == BAD) || (current > ACQ_FAST_PROFILE_CURRENT_A))
+	{
+		profile = ACQ_PROFILE_FAST;
+	}
+	else if (current < ACQ_PRECISE_PROFILE_CURRENT_A)
+	{
+		profile = ACQ_PROFILE_PRECISE;
+	}
+	setAcqProfile(profile);
+}
+
+
+/*!
+  @brief   Read the BMB hardware brick alerts and pass them to the alert monitors. The OV and UV
+		   faults see a brick over its limit as soon as the scan that measured it completes. A
+		   BMB found reset has lost its OV/UV thresholds, so the BMB failure recovery is started
+		   to rewrite its configuration
+*/
+static void pollPackAlerts()
+{
+	pollBmbAlerts(gBms.bmb, gBms.chainNumBmbs);
+
+	bool ovFaultPresent = false;
+	bool uvFaultPresent = false;
+	for (int32_t i = 0; i < gBms.numBmbs; i++)
+	{
+		ovFaultPresent |= (gBms.bmb[i].ovBrickAlerts != 0);
+		uvFaultPresent |= (gBms.bmb[i].uvBrickAlerts != 0);
+	}
+	gBms.hwOvFaultPresent = ovFaultPresent;
+	gBms.hwUvFaultPresent = uvFaultPresent;
+
+	if (bmbReinitRequired(gBms.bmb, gBms.numBmbs))
+	{
+		Debug("BMB reset detected by alert poll - starting recovery\n");
+		gBms.bmsHwState = BMS_BMB_FAILURE;
+	}
+}
+
 
 /* ==================================================================== */
 /* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
@@ -97,99 +318,212 @@ void initBmsGopherCan(CAN_HandleTypeDef* hcan)
 }
 
 /*!
-  @brief   Initialization function for the battery pack
-  @param   numBmbs - The expected number of BMBs in the daisy chain
+  @brief   Initialization function for the battery pack. Every ASCI daisy chain is initialized
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
   @returns bool True if initialization successful, false otherwise
 */
 bool initBatteryPack(uint32_t* numBmbs)
 {
-	setAmsFault(true);
-	gBms.balancingDisabled = true;
-	gBms.emergencyBleed    = false;
-	gBms.chargingDisabled  = true;
-	gBms.limpModeEnabled   = false;
-	gBms.amsFaultPresent   = false;
-	
-	if (!initASCI())
+	startPackInit();
+	if (!initBmbChains(expectedChainNumBmbs, gBms.bmb, gBms.chainNumBmbs, numBmbs))
 	{
-		goto initializationError;
-	}			
-	helloAll(numBmbs);	// Ignore return value as it will be bad due to no loopback
-	
-	// Set internal loopback on final BMB
-	if (!setBmbInternalLoopback(NUM_BMBS_IN_ACCUMULATOR - 1, true))
+		// Set hardware error status
+		gBms.bmsHwState = BMS_BMB_FAILURE;
+		return false;
+	}
+
+	resumePackMonitoring(*numBmbs);
+	setAmsFault(false);
+	return true;
+}
+
+/*!
+  @brief   Recover the battery pack after a BMB communication failure. A soft resync is tried
+		   first, then a configuration rewrite of only the BMBs that were reset, and a full
+		   initialization of the battery pack only as a last resort
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @returns bool True if the pack recovered, false otherwise
+*/
+bool recoverBatteryPack(uint32_t* numBmbs)
+{
+	// A full initialization holds the AMS fault until it succeeds, the same as at start up
+	const bool coldInit = gBms.recovery.coldInitRequired;
+	if (coldInit)
+	{
+		startPackInit();
+	}
+
+	Recovery_Tier_E tier = RECOVERY_SOFT_RESYNC;
+	if (!recoverBmbChains(&gBms.recovery, expectedChainNumBmbs, gBms.bmb, gBms.chainNumBmbs, numBmbs, &tier))
+	{
+		return false;
+	}
+
+	resumePackMonitoring(*numBmbs);
+	if (coldInit)
 	{
-		goto initializationError;
+		setAmsFault(false);
 	}
+	return true;
+}
 
-	if (helloAll(numBmbs))
+/*!
+  @brief   Find the fastest ASCI SPI clock and keep-alive that read out scans without errors and
+		   store it in flash. The clock is backed off one step if a faster or equal clock saw
+		   errors. The previous configuration is restored if no configuration passes. All daisy
+		   chains share the configuration
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @returns bool True if a configuration was selected and stored, false otherwise
+*/
+bool calibrateAsciLink(const uint32_t* chainNumBmbs)
+{
+	Asci_Link_Config_S initialConfig;
+	selectAsciChain(0);
+	getAsciLinkConfig(&initialConfig);
+
+	// Step from the fastest SPI clock to the slowest. The first clock with an error free keep-alive
+	// is the fastest usable clock. Keep-alives are compared by the measured scan readout time
+	Asci_Link_Config_S fastestConfig = initialConfig;
+	bool configFound = false;
+	bool errorsSeen = false;
+	for (uint32_t prescaler = SPI_BAUDRATEPRESCALER_2; !configFound && (prescaler <= SPI_BAUDRATEPRESCALER_256); prescaler += SPI_CR1_BR_0)
 	{
-		// helloAll command succeeded - verify that the numBmbs was correctly set
-		if (*numBmbs != NUM_BMBS_IN_ACCUMULATOR)
+		uint32_t fastestCycles = UINT32_MAX;
+		for (uint32_t i = 0; i < NUM_LINK_CAL_KEEP_ALIVES; i++)
 		{
-			Debug("Number of BMBs detected (%lu) doesn't match expectation (%d)\n", *numBmbs, NUM_BMBS_IN_ACCUMULATOR);
-			goto initializationError;
+			Asci_Link_Config_S config = { .spiPrescaler = prescaler, .keepAlive = linkCalKeepAlives[i] };
+			if (!setAllAsciLinkConfigs(&config))
+			{
+				// SPI clock is faster than the ASCI supports
+				break;
+			}
+
+			uint32_t readoutCycles = UINT32_MAX;
+			const bool errorFree = resyncAllASCI() && runLinkCalibrationStep(chainNumBmbs, LINK_CAL_SCANS_PER_STEP, &readoutCycles);
+			DebugComm("Link calibration: prescaler 0x%02lX keep-alive 0x%02X - %s, %lu cycles per readout\n",
+				prescaler, config.keepAlive, errorFree ? "PASS" : "FAIL", readoutCycles);
+			if (!errorFree)
+			{
+				errorsSeen = true;
+			}
+			else if (readoutCycles < fastestCycles)
+			{
+				fastestCycles = readoutCycles;
+				fastestConfig = config;
+				configFound = true;
+			}
 		}
+	}
 
-		initBmbs(*numBmbs);
-		gBms.numBmbs = *numBmbs;
-		gBms.bmsHwState = BMS_NOMINAL;
-		setAmsFault(false);
-		// Leaky bucket was filled due to missing external loopback. Since we successfully initialized using
-		// internal loopback, we can reset the leaky bucket
-		resetLeakyBucket(&asciCommsLeakyBucket);
-		return true;
+	// Leave margin below the clock where errors start
+	Asci_Link_Config_S selectedConfig = fastestConfig;
+	if (errorsSeen && (selectedConfig.spiPrescaler < SPI_BAUDRATEPRESCALER_256))
+	{
+		selectedConfig.spiPrescaler += SPI_CR1_BR_0;
+	}
 
+	uint32_t readoutCycles = UINT32_MAX;
+	bool success = configFound && setAllAsciLinkConfigs(&selectedConfig) && resyncAllASCI() &&
+				   runLinkCalibrationStep(chainNumBmbs, LINK_CAL_CONFIRM_SCANS, &readoutCycles);
+	if (success)
+	{
+		Nv_Config_S nvConfig;
+		memset(&nvConfig, 0, sizeof(nvConfig));
+		nvConfig.asciLink = selectedConfig;
+		success = saveNvConfig(&nvConfig);
+		Debug("Link calibration selected prescaler 0x%02lX keep-alive 0x%02X - %lu cycles per readout\n",
+			selectedConfig.spiPrescaler, selectedConfig.keepAlive, readoutCycles);
 	}
 	else
 	{
-		goto initializationError;
-	}
-	
-// Routine if initialization error ocurs
-initializationError:
-	// Set hardware error status
-	gBms.bmsHwState = BMS_BMB_FAILURE;
-
-	// Determine if a chain break exists
-	initASCI();
-	helloAll(numBmbs);	// Ignore return value as it will be bad due to no loopback
-	uint32_t breakLocation = detectBmbDaisyChainBreak(gBms.bmb, NUM_BMBS_IN_ACCUMULATOR);
-	if (breakLocation != 0)
-	{
-		// A chain break exists
-		if (breakLocation == 1)
-		{
-			Debug("BMB Chain Break detected between BMS and BMB 1\n");
-		}
-		else
+		Debug("Link calibration failed - keeping the previous configuration\n");
+		setAllAsciLinkConfigs(&initialConfig);
+		if (!resyncAllASCI())
 		{
-			Debug("BMB Chain Break detected between BMB %lu and BMB %lu\n", breakLocation - 1, breakLocation);
+			gBms.bmsHwState = BMS_BMB_FAILURE;
 		}
 	}
-	else
+
+	// Readout times changed with the SPI clock
+	planPackScans();
+
+	// Errors provoked by the calibration say nothing about the harness
+	resetLeakyBucket(&asciCommsLeakyBucket);
+	resetBmbLinkStats();
+	return success;
+}
+
+/*!
+  @brief   Measure how the time spent on a scan readout, pack data aggregation and alert
+		   monitoring scales with the number of BMBs. The results are printed for every pack
+		   size up to MAX_BMBS_IN_ACCUMULATOR. Scan readout time is estimated from the bytes
+		   received at the current ASCI SPI clock
+*/
+void runPackScalingBenchmark()
+{
+	const uint32_t cyclesPerUs = SystemCoreClock / 1000000;
+	const uint32_t packNumBmbs = gBms.numBmbs;
+	selectAsciChain(0);
+
+	Debug("Pack scaling benchmark - %d iterations per pack size\n", PACK_BENCHMARK_ITERATIONS);
+	Debug("BMBs | Chains | Scan readout (us) | Aggregate (us) | Alerts (us)\n");
+	for (uint32_t numBmbs = 1; numBmbs <= MAX_BMBS_IN_ACCUMULATOR; numBmbs++)
 	{
-		// Break location is in the external loopback of the final BMB
-		// This is fixable by enabling the internal loopback on the final BMB which is 
-		// done in the detectBmbDaisyChainBreak function
-		if (helloAll(numBmbs))
+		// Packs longer than a chain are split evenly across chains which are read out concurrently
+		const uint32_t numChains = (numBmbs + MAX_BMBS_PER_CHAIN - 1) / MAX_BMBS_PER_CHAIN;
+		const uint32_t longestChain = (numBmbs + numChains - 1) / numChains;
+		const uint32_t scanReadoutUs = estimateScanReadoutUs(longestChain);
+
+		uint32_t startCycles = DWT->CYCCNT;
+		for (uint32_t i = 0; i < PACK_BENCHMARK_ITERATIONS; i++)
+		{
+			aggregatePackData(numBmbs);
+		}
+		const uint32_t aggregateCycles = (DWT->CYCCNT - startCycles) / PACK_BENCHMARK_ITERATIONS;
+
+		// Only the alert conditions depend on the pack size. The alert monitors are not run so no
+		// alert timers or statuses are disturbed
+		gBms.numBmbs = numBmbs;
+		startCycles = DWT->CYCCNT;
+		for (uint32_t i = 0; i < PACK_BENCHMARK_ITERATIONS; i++)
 		{
-			// helloAll command succeeded - verify that the numBmbs was correctly set
-			if (*numBmbs != NUM_BMBS_IN_ACCUMULATOR)
+			for (uint32_t j = 0; j < NUM_ALERTS; j++)
 			{
-				return false;
+				alerts[j]->alertConditionPresent(&gBms);
 			}
-			initBmbs(*numBmbs);
-			gBms.numBmbs = *numBmbs;
-			gBms.bmsHwState = BMS_NOMINAL;
-			setAmsFault(false);
-			// Leaky bucket was filled due to missing external loopback. Since we successfully initialized using
-			// internal loopback, we can reset the leaky bucket
-			resetLeakyBucket(&asciCommsLeakyBucket);
-			return true;
 		}
+		const uint32_t alertCycles = (DWT->CYCCNT - startCycles) / PACK_BENCHMARK_ITERATIONS;
+
+		Debug("%4lu | %6lu | %17lu | %14lu | %11lu\n", numBmbs, numChains, scanReadoutUs,
+			aggregateCycles / cyclesPerUs, alertCycles / cyclesPerUs);
 	}
-	return false;
+
+	// Restore the pack data of the BMBs actually in the pack
+	gBms.numBmbs = packNumBmbs;
+	aggregatePackData(packNumBmbs);
+}
+
+/*!
+  @brief   Measure the scan latency and the brick voltage noise of the first BMB with every
+		   acquisition profile. The results are printed as a table. Noise is estimated from the
+		   difference of successive samples so the pack must be at rest
+*/
+void runAcqProfileBenchmark()
+{
+	static const char* profileNames[NUM_ACQ_PROFILES] = { "Precise", "Fast" };
+	const Acq_Profile_E startProfile = getAcqProfile();
+
+	Debug("Acquisition profile benchmark - %d scans per profile\n", ACQ_BENCHMARK_SCANS);
+	Debug("Profile | Slot (ms) | Latency (ms) | Noise (uV rms)\n");
+	for (int32_t profile = 0; profile < NUM_ACQ_PROFILES; profile++)
+	{
+		Acq_Profile_Result_S result;
+		measureAcqProfile(profile, gBms.bmb, gBms.chainNumBmbs, ACQ_BENCHMARK_SCANS, &result);
+		Debug("%7s | %9lu | %12lu | %14lu\n", profileNames[profile], getScanSlotMs(profile), (uint32_t)result.latencyMs, (uint32_t)result.noiseUv);
+	}
+
+	setAcqProfile(startProfile);
+	resetLeakyBucket(&asciCommsLeakyBucket);
 }
 
 /*!
@@ -201,7 +535,8 @@ void updatePackData(uint32_t numBmbs)
 	static uint32_t lastPackUpdate = 0;
 	if(HAL_GetTick() - lastPackUpdate > VOLTAGE_DATA_UPDATE_PERIOD_MS)
 	{
-		updateBmbData(gBms.bmb, numBmbs);
+		updateAcqProfile();
+		updateBmbData(gBms.bmb, gBms.chainNumBmbs);
 		// // TODO: Get rid of this
 		// for (int i = 0; i < 12; i++)
 		// {
@@ -219,6 +554,25 @@ void updatePackData(uint32_t numBmbs)
 		aggregatePackData(numBmbs);
 		updateInternalResistanceCalcs(&gBms);
 	}
+
+	static uint32_t lastAlertPoll = 0;
+	if(HAL_GetTick() - lastAlertPoll >= BMB_ALERT_POLL_PERIOD_MS)
+	{
+		pollPackAlerts();
+		lastAlertPoll = HAL_GetTick();
+	}
+
+	static uint32_t lastLinkDiagnostic = 0;
+	if(HAL_GetTick() - lastLinkDiagnostic > BMB_LINK_DIAGNOSTIC_PERIOD_MS)
+	{
+		// Probe the BMB with the worst link error rate on each chain so a degrading harness is confirmed early
+		for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+		{
+			selectAsciChain(chainIdx);
+			diagnoseSuspectBmbLink(gBms.chainNumBmbs[chainIdx]);
+		}
+		lastLinkDiagnostic = HAL_GetTick();
+	}
 }
 
 /*!
@@ -237,7 +591,7 @@ void balancePack(uint32_t numBmbs, bool balanceRequested)
 		{
 			disableBmbBalancing(&gBms.bmb[i]);
 		}
-		balanceCells(gBms.bmb, numBmbs);
+		balanceAllChains();
 		return;
 	}
 
@@ -273,12 +627,13 @@ void balancePackToVoltage(uint32_t numBmbs, float targetBrickVoltage)
 	}
 
 	// Iterate through all BMBs and set bleed request
+	const uint16_t bleedThresholdCode = BRICK_V_TO_CODE(targetBrickVoltage + BALANCE_THRESHOLD_V);
 	for (int32_t i = 0; i < numBmbs; i++)
 	{
 		// Iterate through all bricks and determine whether they should be bled or not
 		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
 		{
-			if (gBms.bmb[i].brickV[j] > targetBrickVoltage + BALANCE_THRESHOLD_V)
+			if (SENSOR_CODE(gBms.bmb[i].brickVCode[j]) > bleedThresholdCode)
 			{
 				gBms.bmb[i].balSwRequested[j] = true;
 			}
@@ -289,7 +644,7 @@ void balancePackToVoltage(uint32_t numBmbs, float targetBrickVoltage)
 		}
 	}
 	
-	balanceCells(gBms.bmb, numBmbs);
+	balanceAllChains();
 }
 
 /*!
@@ -353,8 +708,8 @@ void aggregatePackData(uint32_t numBmbs)
 	// Update BMB level stats
 	aggregateBmbData(pBms->bmb, numBmbs);
 
-	float maxBrickV	   = MIN_BRICK_VOLTAGE_READING;
-	float minBrickV	   = MAX_BRICK_VOLTAGE_READING;
+	uint16_t maxBrickVCode = 0;
+	uint16_t minBrickVCode = SENSOR_CODE_MASK;
 	float avgBrickVSum = 0.0f;
 	float accumulatorVSum = 0.0f;
 
@@ -370,13 +725,13 @@ void aggregatePackData(uint32_t numBmbs)
 	{
 		Bmb_S* pBmb = &pBms->bmb[i];
 
-		if (pBmb->maxBrickV > maxBrickV)
+		if (pBmb->maxBrickVCode > maxBrickVCode)
 		{
-			maxBrickV = pBmb->maxBrickV;
+			maxBrickVCode = pBmb->maxBrickVCode;
 		}
-		if (pBmb->minBrickV < minBrickV)
+		if (pBmb->minBrickVCode < minBrickVCode)
 		{
-			minBrickV = pBmb->minBrickV;
+			minBrickVCode = pBmb->minBrickVCode;
 		}
 
 		if (pBmb->maxBrickTemp > maxBrickTemp)
@@ -403,15 +758,17 @@ void aggregatePackData(uint32_t numBmbs)
 		avgBoardTempSum += pBmb->avgBoardTemp;
 	}
 	pBms->accumulatorVoltage = accumulatorVSum;
-	pBms->maxBrickV = maxBrickV;
-	pBms->minBrickV = minBrickV;
-	pBms->avgBrickV = avgBrickVSum / NUM_BMBS_IN_ACCUMULATOR;
+	pBms->maxBrickVCode = maxBrickVCode;
+	pBms->minBrickVCode = minBrickVCode;
+	pBms->maxBrickV = convertBrickV(maxBrickVCode);
+	pBms->minBrickV = convertBrickV(minBrickVCode);
+	pBms->avgBrickV = (numBmbs > 0) ? (avgBrickVSum / numBmbs) : 0.0f;
 	pBms->maxBrickTemp = maxBrickTemp;
 	pBms->minBrickTemp = minBrickTemp;
-	pBms->avgBrickTemp = avgBrickTempSum / NUM_BMBS_IN_ACCUMULATOR;
+	pBms->avgBrickTemp = (numBmbs > 0) ? (avgBrickTempSum / numBmbs) : 0.0f;
 	pBms->maxBoardTemp = maxBoardTemp;
 	pBms->minBoardTemp = minBoardTemp;
-	pBms->avgBoardTemp = avgBoardTempSum / NUM_BMBS_IN_ACCUMULATOR;
+	pBms->avgBoardTemp = (numBmbs > 0) ? (avgBoardTempSum / numBmbs) : 0.0f;
 }
 
 /*!
@@ -561,11 +918,12 @@ void updateStateOfChargeAndEnergy()
 */
 void updateGopherCan()
 {
-	// This condition is to stop gcan sending if we are testing with less than the full accumulator
-	// Otherwise, it will try to reference bmb indices that dont exist
-	if((NUM_BMBS_IN_ACCUMULATOR == 7) && (NUM_BRICKS_PER_BMB == 12))
+	// Parameters only exist for the first NUM_GCAN_SEGMENTS BMBs. Only the BMBs found in the
+	// pack that have parameters are logged
+	const uint32_t numGcanBmbs = (gBms.numBmbs < NUM_GCAN_SEGMENTS) ? gBms.numBmbs : NUM_GCAN_SEGMENTS;
+	if(NUM_BRICKS_PER_BMB == 12)
 	{
-		static FLOAT_CAN_STRUCT *cellVoltageParams[NUM_BMBS_IN_ACCUMULATOR][NUM_BRICKS_PER_BMB] =
+		static FLOAT_CAN_STRUCT *cellVoltageParams[NUM_GCAN_SEGMENTS][NUM_BRICKS_PER_BMB] =
 		{
 			{&seg1Cell1Voltage_V, &seg1Cell2Voltage_V, &seg1Cell3Voltage_V, &seg1Cell4Voltage_V, &seg1Cell5Voltage_V, &seg1Cell6Voltage_V, &seg1Cell7Voltage_V, &seg1Cell8Voltage_V, &seg1Cell9Voltage_V, &seg1Cell10Voltage_V, &seg1Cell11Voltage_V, &seg1Cell12Voltage_V},
 			{&seg2Cell1Voltage_V, &seg2Cell2Voltage_V, &seg2Cell3Voltage_V, &seg2Cell4Voltage_V, &seg2Cell5Voltage_V, &seg2Cell6Voltage_V, &seg2Cell7Voltage_V, &seg2Cell8Voltage_V, &seg2Cell9Voltage_V, &seg2Cell10Voltage_V, &seg2Cell11Voltage_V, &seg2Cell12Voltage_V},
@@ -576,7 +934,7 @@ void updateGopherCan()
 			{&seg7Cell1Voltage_V, &seg7Cell2Voltage_V, &seg7Cell3Voltage_V, &seg7Cell4Voltage_V, &seg7Cell5Voltage_V, &seg7Cell6Voltage_V, &seg7Cell7Voltage_V, &seg7Cell8Voltage_V, &seg7Cell9Voltage_V, &seg7Cell10Voltage_V, &seg7Cell11Voltage_V, &seg7Cell12Voltage_V}
 		};
 
-		static FLOAT_CAN_STRUCT *cellTempParams[NUM_BMBS_IN_ACCUMULATOR][NUM_BRICKS_PER_BMB] =
+		static FLOAT_CAN_STRUCT *cellTempParams[NUM_GCAN_SEGMENTS][NUM_BRICKS_PER_BMB] =
 		{
 			{&seg1Cell1Temp_C, &seg1Cell2Temp_C, &seg1Cell3Temp_C, &seg1Cell4Temp_C, &seg1Cell5Temp_C, &seg1Cell6Temp_C, &seg1Cell7Temp_C, &seg1Cell8Temp_C, &seg1Cell9Temp_C, &seg1Cell10Temp_C, &seg1Cell11Temp_C, &seg1Cell12Temp_C},
 			{&seg2Cell1Temp_C, &seg2Cell2Temp_C, &seg2Cell3Temp_C, &seg2Cell4Temp_C, &seg2Cell5Temp_C, &seg2Cell6Temp_C, &seg2Cell7Temp_C, &seg2Cell8Temp_C, &seg2Cell9Temp_C, &seg2Cell10Temp_C, &seg2Cell11Temp_C, &seg2Cell12Temp_C},
@@ -587,7 +945,7 @@ void updateGopherCan()
 			{&seg7Cell1Temp_C, &seg7Cell2Temp_C, &seg7Cell3Temp_C, &seg7Cell4Temp_C, &seg7Cell5Temp_C, &seg7Cell6Temp_C, &seg7Cell7Temp_C, &seg7Cell8Temp_C, &seg7Cell9Temp_C, &seg7Cell10Temp_C, &seg7Cell11Temp_C, &seg7Cell12Temp_C}
 		};
 
-		static FLOAT_CAN_STRUCT *boardTempParams[NUM_BMBS_IN_ACCUMULATOR][NUM_BRICKS_PER_BMB] =
+		static FLOAT_CAN_STRUCT *boardTempParams[NUM_GCAN_SEGMENTS][NUM_BRICKS_PER_BMB] =
 		{
 			{&seg1BMBBoardTemp1_C, &seg1BMBBoardTemp2_C, &seg1BMBBoardTemp3_C, &seg1BMBBoardTemp4_C},
 			{&seg2BMBBoardTemp1_C, &seg2BMBBoardTemp2_C, &seg2BMBBoardTemp3_C, &seg2BMBBoardTemp4_C},
@@ -598,7 +956,7 @@ void updateGopherCan()
 			{&seg7BMBBoardTemp1_C, &seg7BMBBoardTemp2_C, &seg7BMBBoardTemp3_C, &seg7BMBBoardTemp4_C}
 		};
 
-		static FLOAT_CAN_STRUCT *cellVoltageStatsParams[NUM_BMBS_IN_ACCUMULATOR][4] =
+		static FLOAT_CAN_STRUCT *cellVoltageStatsParams[NUM_GCAN_SEGMENTS][4] =
 		{
 			{&seg1Voltage_V, &seg1AveCellVoltage_V, &seg1MaxCellVoltage_V, &seg1MinCellVoltage_V},
 			{&seg2Voltage_V, &seg2AveCellVoltage_V, &seg2MaxCellVoltage_V, &seg2MinCellVoltage_V},
@@ -609,7 +967,7 @@ void updateGopherCan()
 			{&seg7Voltage_V, &seg7AveCellVoltage_V, &seg7MaxCellVoltage_V, &seg7MinCellVoltage_V}
 		};
 
-		static FLOAT_CAN_STRUCT *cellTempStatsParams[NUM_BMBS_IN_ACCUMULATOR][3] =
+		static FLOAT_CAN_STRUCT *cellTempStatsParams[NUM_GCAN_SEGMENTS][3] =
 		{
 			{&seg1AveCellTemp_C, &seg1MaxCellTemp_C, &seg1MinCellTemp_C},
 			{&seg2AveCellTemp_C, &seg2MaxCellTemp_C, &seg2MinCellTemp_C},
@@ -620,7 +978,7 @@ void updateGopherCan()
 			{&seg7AveCellTemp_C, &seg7MaxCellTemp_C, &seg7MinCellTemp_C}
 		};
 
-		static FLOAT_CAN_STRUCT *boardTempStatsParams[NUM_BMBS_IN_ACCUMULATOR][3] =
+		static FLOAT_CAN_STRUCT *boardTempStatsParams[NUM_GCAN_SEGMENTS][3] =
 		{
 			{&seg1BMBAveBoardTemp_C, &seg1BMBMaxBoardTemp_C, &seg1BMBMinBoardTemp_C},
 			{&seg2BMBAveBoardTemp_C, &seg2BMBMaxBoardTemp_C, &seg2BMBMinBoardTemp_C},
@@ -631,7 +989,7 @@ void updateGopherCan()
 			{&seg7BMBAveBoardTemp_C, &seg7BMBMaxBoardTemp_C, &seg7BMBMinBoardTemp_C}
 		};
 
-		static U8_CAN_STRUCT *balswenParams[NUM_BMBS_IN_ACCUMULATOR][NUM_BRICKS_PER_BMB] =
+		static U8_CAN_STRUCT *balswenParams[NUM_GCAN_SEGMENTS][NUM_BRICKS_PER_BMB] =
 		{
 			{&seg1Cell1BalanceEnable_state, &seg1Cell2BalanceEnable_state, &seg1Cell3BalanceEnable_state, &seg1Cell4BalanceEnable_state, &seg1Cell5BalanceEnable_state, &seg1Cell6BalanceEnable_state, &seg1Cell7BalanceEnable_state, &seg1Cell8BalanceEnable_state, &seg1Cell9BalanceEnable_state, &seg1Cell10BalanceEnable_state, &seg1Cell11BalanceEnable_state, &seg1Cell12BalanceEnable_state},
 			{&seg2Cell1BalanceEnable_state, &seg2Cell2BalanceEnable_state, &seg2Cell3BalanceEnable_state, &seg2Cell4BalanceEnable_state, &seg2Cell5BalanceEnable_state, &seg2Cell6BalanceEnable_state, &seg2Cell7BalanceEnable_state, &seg2Cell8BalanceEnable_state, &seg2Cell9BalanceEnable_state, &seg2Cell10BalanceEnable_state, &seg2Cell11BalanceEnable_state, &seg2Cell12BalanceEnable_state},
@@ -659,8 +1017,12 @@ void updateGopherCan()
 				case GCAN_SEGMENT_5:
 				case GCAN_SEGMENT_6:
 				case GCAN_SEGMENT_7:
-					
-					update_and_queue_param_float(cellVoltageStatsParams[gcanUpdateState][0], gBms.bmb[gcanUpdateState].segmentV);
+					if (gcanUpdateState >= numGcanBmbs)
+					{
+						break;
+					}
+
+					update_and_queue_param_float(cellVoltageStatsParams[gcanUpdateState][0], convertSegmentV(gBms.bmb[gcanUpdateState].segmentVCode));
 					update_and_queue_param_float(cellVoltageStatsParams[gcanUpdateState][1], gBms.bmb[gcanUpdateState].avgBrickV);
 					update_and_queue_param_float(cellVoltageStatsParams[gcanUpdateState][2], gBms.bmb[gcanUpdateState].maxBrickV);
 					update_and_queue_param_float(cellVoltageStatsParams[gcanUpdateState][3], gBms.bmb[gcanUpdateState].minBrickV);
@@ -668,29 +1030,29 @@ void updateGopherCan()
 
 					for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
 					{
-						update_and_queue_param_float(cellVoltageParams[gcanUpdateState][i], gBms.bmb[gcanUpdateState].brickV[i]);
+						update_and_queue_param_float(cellVoltageParams[gcanUpdateState][i], convertBrickV(gBms.bmb[gcanUpdateState].brickVCode[i]));
 					}
 
 					for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
 					{
-						update_and_queue_param_float(cellTempParams[gcanUpdateState][i], gBms.bmb[gcanUpdateState].brickTemp[i]);
+						update_and_queue_param_float(cellTempParams[gcanUpdateState][i], convertBrickTemp(gBms.bmb[gcanUpdateState].brickTempCode[i]));
 					}
 
 					for (int32_t i = 0; i < NUM_BOARD_TEMP_PER_BMB; i++)
 					{
-						update_and_queue_param_float(boardTempParams[gcanUpdateState][i], gBms.bmb[gcanUpdateState].boardTemp[i]);
+						update_and_queue_param_float(boardTempParams[gcanUpdateState][i], convertBoardTemp(gBms.bmb[gcanUpdateState].boardTempCode[i]));
 					}
 					break;
 				
 				case GCAN_CELL_TEMP_STATS:
-					for (int32_t i = 0; i < NUM_BMBS_IN_ACCUMULATOR; i++)
+					for (int32_t i = 0; i < numGcanBmbs; i++)
 					{
 						update_and_queue_param_float(cellTempStatsParams[i][0], gBms.bmb[i].avgBrickTemp);
 						update_and_queue_param_float(cellTempStatsParams[i][1], gBms.bmb[i].maxBrickTemp);
 						update_and_queue_param_float(cellTempStatsParams[i][2], gBms.bmb[i].minBrickTemp);
 					}
 
-					for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+					for (int32_t i = 0; (numGcanBmbs > 0) && (i < NUM_BRICKS_PER_BMB); i++)
 					{
 						update_and_queue_param_u8(balswenParams[0][i], gBms.bmb[0].balSwEnabled[i]);
 					}
@@ -701,14 +1063,14 @@ void updateGopherCan()
 					break;
 
 				case GCAN_BOARD_TEMP_STATS:
-					for (int32_t i = 0; i < NUM_BMBS_IN_ACCUMULATOR; i++)
+					for (int32_t i = 0; i < numGcanBmbs; i++)
 					{
 						update_and_queue_param_float(boardTempStatsParams[i][0], gBms.bmb[i].avgBoardTemp);
 						update_and_queue_param_float(boardTempStatsParams[i][1], gBms.bmb[i].maxBoardTemp);
 						update_and_queue_param_float(boardTempStatsParams[i][2], gBms.bmb[i].minBoardTemp);
 					}
 
-					for (int32_t i = 0; i < NUM_BRICKS_PER_BMB; i++)
+					for (int32_t i = 0; (numGcanBmbs > 1) && (i < NUM_BRICKS_PER_BMB); i++)
 					{
 						update_and_queue_param_u8(balswenParams[1][i], gBms.bmb[1].balSwEnabled[i]);
 					}
@@ -719,7 +1081,7 @@ void updateGopherCan()
 					break;
 
 				case GCAN_BALSWEN:
-					for (int32_t i = 2; i < NUM_BMBS_IN_ACCUMULATOR; i++)
+					for (int32_t i = 2; i < numGcanBmbs; i++)
 					{
 						for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
 						{
@@ -0,0 +1,253 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include "main.h"
+#include "bmsRecovery.h"
+#include "bmbInterface.h"
+#include "leakyBucket.h"
+#include "debug.h"
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern LeakyBucket_S asciCommsLeakyBucket;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Initialize the BMBs on the selected ASCI daisy chain. A chain break is located if the
+		   chain can not be initialized
+  @param   expectedNumBmbs - The expected number of BMBs in the daisy chain
+  @param   bmb - The array containing BMB data of the selected daisy chain
+  @param   numBmbs - Updated with the number of BMBs found in the daisy chain
+  @returns bool True if initialization successful, false otherwise
+*/
+bool initBmbChain(uint32_t expectedNumBmbs, Bmb_S* bmb, uint32_t* numBmbs)
+{
+	if (!initASCI())
+	{
+		goto initializationError;
+	}
+	helloAll(numBmbs);	// Ignore return value as it will be bad due to no loopback
+
+	// Set internal loopback on final BMB
+	if (!setBmbInternalLoopback(expectedNumBmbs - 1, true))
+	{
+		goto initializationError;
+	}
+
+	if (helloAll(numBmbs))
+	{
+		// helloAll command succeeded - verify that the numBmbs was correctly set
+		if (*numBmbs != expectedNumBmbs)
+		{
+			Debug("Number of BMBs detected (%lu) doesn't match expectation (%lu)\n", (unsigned long)*numBmbs, (unsigned long)expectedNumBmbs);
+			goto initializationError;
+		}
+
+		initBmbs(*numBmbs);
+		return true;
+	}
+	else
+	{
+		goto initializationError;
+	}
+
+// Routine if initialization error ocurs
+initializationError:
+	// Determine if a chain break exists
+	initASCI();
+	helloAll(numBmbs);	// Ignore return value as it will be bad due to no loopback
+	uint32_t breakLocation = detectBmbDaisyChainBreak(bmb, expectedNumBmbs);
+	if (breakLocation != 0)
+	{
+		// A chain break exists
+		if (breakLocation == 1)
+		{
+			Debug("BMB Chain Break detected between BMS and BMB 1 on chain %lu\n", (unsigned long)getAsciChain());
+		}
+		else
+		{
+			Debug("BMB Chain Break detected between BMB %lu and BMB %lu on chain %lu\n", (unsigned long)breakLocation - 1,
+				(unsigned long)breakLocation, (unsigned long)getAsciChain());
+		}
+	}
+	else
+	{
+		// Break location is in the external loopback of the final BMB
+		// This is fixable by enabling the internal loopback on the final BMB which is
+		// done in the detectBmbDaisyChainBreak function
+		if (helloAll(numBmbs))
+		{
+			// helloAll command succeeded - verify that the numBmbs was correctly set
+			if (*numBmbs != expectedNumBmbs)
+			{
+				return false;
+			}
+			initBmbs(*numBmbs);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*!
+  @brief   Restore communication with the BMBs on the selected ASCI daisy chain without power
+		   cycling the ASCI. Only BMBs that were reset have their configuration rewritten
+  @param   expectedNumBmbs - The expected number of BMBs in the daisy chain
+  @param   bmb - The array containing BMB data of the selected daisy chain
+  @param   numBmbs - Updated with the number of BMBs found in the daisy chain
+  @param   tier - Updated with the recovery tier that was required
+  @returns bool True if the chain recovered, false otherwise
+*/
+bool recoverBmbChain(uint32_t expectedNumBmbs, Bmb_S* bmb, uint32_t* numBmbs, Recovery_Tier_E* tier)
+{
+	// Resync the ASCI without power cycling it and re-enumerate the chain once
+	*tier = RECOVERY_SOFT_RESYNC;
+	bool chainRestored = resyncASCI() && helloAll(numBmbs);
+	if (!chainRestored)
+	{
+		// The final BMB may have been reset and lost its internal loopback. helloAll still
+		// readdresses the chain even though its response can not return
+		*tier = RECOVERY_BMB_REINIT;
+		helloAll(numBmbs);
+		chainRestored = setBmbInternalLoopback(expectedNumBmbs - 1, true) && helloAll(numBmbs);
+	}
+	if (!chainRestored || (*numBmbs != expectedNumBmbs))
+	{
+		return false;
+	}
+
+	// Only rewrite the configuration of BMBs that were reset
+	const int32_t numReinitialized = reinitResetBmbs(bmb, *numBmbs);
+	if (numReinitialized > 0)
+	{
+		*tier = RECOVERY_BMB_REINIT;
+	}
+	return (numReinitialized >= 0);
+}
+
+/*!
+  @brief   Initialize the BMBs on every ASCI daisy chain. Chains expected to have no BMBs are skipped
+  @param   expectedChainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - Updated with the number of BMBs found on each daisy chain
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @returns bool True if every chain initialized, false otherwise
+*/
+bool initBmbChains(const uint32_t* expectedChainNumBmbs, Bmb_S* bmb, uint32_t* chainNumBmbs, uint32_t* numBmbs)
+{
+	*numBmbs = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		// Chains without BMBs are skipped
+		chainNumBmbs[chainIdx] = 0;
+		if (expectedChainNumBmbs[chainIdx] == 0)
+		{
+			continue;
+		}
+
+		selectAsciChain(chainIdx);
+		uint32_t numChainBmbs = 0;
+		if (!initBmbChain(expectedChainNumBmbs[chainIdx], &bmb[*numBmbs], &numChainBmbs))
+		{
+			return false;
+		}
+		chainNumBmbs[chainIdx] = numChainBmbs;
+		*numBmbs += numChainBmbs;
+	}
+
+	// Leaky bucket was filled due to missing external loopback. Since we successfully initialized using
+	// internal loopback, we can reset the leaky bucket
+	resetLeakyBucket(&asciCommsLeakyBucket);
+	return true;
+}
+
+/*!
+  @brief   Recover every ASCI daisy chain after a BMB communication failure. A soft resync is
+		   tried first, then a configuration rewrite of only the BMBs that were reset. Once a
+		   warm recovery fails, only a full initialization is tried. The time the pack went
+		   unmonitored is recorded against the highest tier any chain required. Chains expected
+		   to have no BMBs are skipped
+  @param   recovery - The recovery state, kept across attempts until the pack recovers
+  @param   expectedChainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - Updated with the number of BMBs found on each daisy chain
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @param   tier - Updated with the recovery tier that was required
+  @returns bool True if the pack recovered, false otherwise
+*/
+bool recoverBmbChains(Recovery_State_S* recovery, const uint32_t* expectedChainNumBmbs, Bmb_S* bmb,
+					  uint32_t* chainNumBmbs, uint32_t* numBmbs, Recovery_Tier_E* tier)
+{
+	if (!recovery->inProgress)
+	{
+		recovery->inProgress = true;
+		recovery->startTick = HAL_GetTick();
+	}
+
+	*tier = RECOVERY_COLD_INIT;
+	bool recovered = false;
+	if (!recovery->coldInitRequired)
+	{
+		// Every chain is recovered. The recovery is recorded against the highest tier any chain required
+		*tier = RECOVERY_SOFT_RESYNC;
+		recovered = true;
+		*numBmbs = 0;
+		for (uint32_t chainIdx = 0; recovered && (chainIdx < NUM_ASCI_CHAINS); chainIdx++)
+		{
+			chainNumBmbs[chainIdx] = 0;
+			if (expectedChainNumBmbs[chainIdx] == 0)
+			{
+				continue;
+			}
+
+			selectAsciChain(chainIdx);
+			uint32_t numChainBmbs = 0;
+			Recovery_Tier_E chainTier = RECOVERY_SOFT_RESYNC;
+			recovered = recoverBmbChain(expectedChainNumBmbs[chainIdx], &bmb[*numBmbs], &numChainBmbs, &chainTier);
+			if (chainTier > *tier)
+			{
+				*tier = chainTier;
+			}
+			chainNumBmbs[chainIdx] = numChainBmbs;
+			*numBmbs += numChainBmbs;
+		}
+		if (recovered)
+		{
+			resetLeakyBucket(&asciCommsLeakyBucket);
+		}
+	}
+	else
+	{
+		recovered = initBmbChains(expectedChainNumBmbs, bmb, chainNumBmbs, numBmbs);
+	}
+
+	if (!recovered)
+	{
+		// Warm recovery failed - fall back to a full initialization from now on
+		recovery->coldInitRequired = true;
+		return false;
+	}
+
+	// Record how long the pack went unmonitored
+	const uint32_t blackoutMs = HAL_GetTick() - recovery->startTick;
+	Recovery_Stats_S* stats = &recovery->stats;
+	stats->numRecoveries[*tier]++;
+	stats->lastBlackoutMs[*tier] = blackoutMs;
+	if (blackoutMs > stats->maxBlackoutMs[*tier])
+	{
+		stats->maxBlackoutMs[*tier] = blackoutMs;
+	}
+	Debug("BMB communication recovered by recovery tier %d after %lu ms\n", *tier, (unsigned long)blackoutMs);
+
+	recovery->inProgress = false;
+	recovery->coldInitRequired = false;
+	return true;
+}
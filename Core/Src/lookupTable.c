@@ -122,7 +122,7 @@ float lookup(float x, const LookupTable_S* table)
     uint32_t i = binarySearch(table->x, x, 0, table->length-1);
 
     //Return 0 if binary search error
-    if(i == -1)
+    if(i == (uint32_t)-1)
     {
         return 0;
     }
@@ -130,3 +130,27 @@ float lookup(float x, const LookupTable_S* table)
     //Interpolate temperature from lookup table
     return interpolate(x, table->x[i], table->x[i+1], table->y[i], table->y[i+1]);
 }
+
+/*!
+    @brief   Look up the input value of a function in a lookup table, given an output value. The
+             outputs must be monotonic but may be in either order
+    @param   y - The output value to look up in the table
+    @param   table - A pointer to the lookup table containing the function values
+    @return  The interpolated input value corresponding to the output value, clamped to the table
+*/
+float reverseLookup(float y, const LookupTable_S* table)
+{
+    for (uint32_t i = 0; i + 1 < table->length; i++)
+    {
+        const float y1 = table->y[i];
+        const float y2 = table->y[i+1];
+        if (((y <= y1) && (y >= y2)) || ((y >= y1) && (y <= y2)))
+        {
+            return interpolate(y, y1, y2, table->x[i], table->x[i+1]);
+        }
+    }
+
+    //Clamp to the end of the table closest to the output value
+    const bool beyondFirst = (table->y[0] > table->y[table->length-1]) ? (y > table->y[0]) : (y < table->y[0]);
+    return beyondFirst ? table->x[0] : table->x[table->length-1];
+}
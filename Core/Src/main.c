@@ -27,6 +27,7 @@
 #include "epaperTask.h"
 #include "idleTask.h"
 #include "bms.h"
+#include "bmbInterface.h"
 #include "gopher_sense.h"
 #include "utils.h"
 #include "charger.h"
@@ -56,6 +57,8 @@ CAN_HandleTypeDef hcan2;
 
 SPI_HandleTypeDef hspi1;
 SPI_HandleTypeDef hspi2;
+DMA_HandleTypeDef hdma_spi1_rx;
+DMA_HandleTypeDef hdma_spi1_tx;
 
 TIM_HandleTypeDef htim3;
 TIM_HandleTypeDef htim10;
@@ -157,7 +160,7 @@ void vApplicationStackOverflowHook( TaskHandle_t xTask, signed char *pcTaskName
 */
 void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
 {
-	if (hspi == &hspi1)
+	if (isAsciSpi(hspi))
 	{
 		static BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
@@ -178,8 +181,10 @@ void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
 */
 void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 {
-	if (hspi == &hspi1)
+	if (isAsciSpi(hspi))
 	{
+		// Transfers started by the ASCI transaction engines are handled in the background
+		if (asciSpiCompleteCallback(hspi)) { return; }
 		static BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 		xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
@@ -188,8 +193,9 @@ void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
 
 void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
 {
-  if (hspi == &hspi1)
+  if (isAsciSpi(hspi))
 	{
+		if (asciSpiErrorCallback(hspi)) { return; }
 		static BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_ERROR, eSetBits, &xHigherPriorityTaskWoken);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
@@ -204,8 +210,9 @@ void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
 
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
 {
-	if (GPIO_Pin == INT_Pin)
+	if (isAsciInterruptPin(GPIO_Pin))
 	{
+		if (asciInterruptCallback(GPIO_Pin)) { return; }
 		static BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
 		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
@@ -795,6 +802,12 @@ static void MX_DMA_Init(void)
   /* DMA2_Stream0_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 5, 0);
   HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+  /* DMA2_Stream2_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+  /* DMA2_Stream3_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA2_Stream3_IRQn, 5, 0);
+  HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
 
 }
 
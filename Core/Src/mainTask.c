@@ -7,6 +7,7 @@
 #include "mainTask.h"
 #include "bms.h"
 #include "bmbInterface.h"
+#include "nvConfig.h"
 #include "leakyBucket.h"
 #include "bmb.h"
 #include "epaper.h"
@@ -28,6 +29,12 @@ extern SPI_HandleTypeDef 	hspi2;
 extern Bms_S 				gBms;
 
 extern LeakyBucket_S asciCommsLeakyBucket;
+extern Asci_Stats_S asciStats;
+extern Asci_Cmd_Stats_S asciCmdStats[NUM_ASCI_CMD_TYPES];
+extern Bmb_Link_Stats_S bmbLinkStats[NUM_ASCI_CHAINS][LINK_STATS_MAX_BMBS];
+#if ASCI_FRAME_CAPTURE
+extern Asci_Frame_Capture_S asciCapture;
+#endif
 
 
 
@@ -53,6 +60,10 @@ void printActiveAlerts();
 void printSocAndSoe();
 void printImdState();
 void printChargerData();
+void printAsciStats();
+void printAsciCmdStats();
+void printAsciCapture();
+void printBmbLinkStats();
 
 
 /* ==================================================================== */
@@ -61,12 +72,35 @@ void printChargerData();
 
 void initMain()
 {
+	// Use the ASCI link configuration stored by the last link calibration on every chain
+	Nv_Config_S nvConfig;
+	if (loadNvConfig(&nvConfig))
+	{
+		for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+		{
+			selectAsciChain(chainIdx);
+			if (!setAsciLinkConfig(&nvConfig.asciLink))
+			{
+				Debug("Stored ASCI link configuration is invalid - using defaults\n");
+			}
+		}
+	}
+
 	for (int i = 0; i < initRetries; i++)
 	{
 		// Try to initialize the BMS HW
 		if (initBatteryPack(&numBmbs))
 		{
 			// Successfully initialized
+#if ASCI_LINK_CALIBRATION
+			calibrateAsciLink(gBms.chainNumBmbs);
+#endif
+#if PACK_SCALING_BENCHMARK
+			runPackScalingBenchmark();
+#endif
+#if ACQ_PROFILE_BENCHMARK
+			runAcqProfileBenchmark();
+#endif
 			return;
 		}
 	}
@@ -77,8 +111,8 @@ void runMain()
 {
 	if (gBms.bmsHwState == BMS_BMB_FAILURE)
 	{
-		// Retry initializing the BMBs
-		initBatteryPack(&numBmbs);
+		// Recover communication with the BMBs, escalating to a full initialization if required
+		recoverBatteryPack(&numBmbs);
 	}
 	else
 	{
@@ -129,7 +163,10 @@ void runMain()
 			printSocAndSoe();
 			printImdState();
 			printChargerData();
-
+			// printAsciStats();
+			// printAsciCmdStats();
+			// printAsciCapture();
+			// printBmbLinkStats();
 
 			printf("Leaky bucket filled: %d\n\n", leakyBucketFilled(&asciCommsLeakyBucket));
 
@@ -161,7 +198,7 @@ void printCellVoltages()
 		printf("|    %02ld   |", i + 1);
 		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
 		{
-			printf("  %5.3f", (double)gBms.bmb[i].brickV[j]);
+			printf("  %5.3f", (double)convertBrickV(gBms.bmb[i].brickVCode[j]));
 			if(gBms.bmb[i].balSwEnabled[j])
 			{
 				printf("*");
@@ -172,7 +209,7 @@ void printCellVoltages()
 			}
 			printf(" |");
 		}
-		printf("  %5.2f  |", (double)gBms.bmb[i].segmentV);
+		printf("  %5.2f  |", (double)convertSegmentV(gBms.bmb[i].segmentVCode));
 		printf("\n");
 	}
 	printf("\n");
@@ -188,7 +225,7 @@ void printCellTemperatures()
 		printf("|    %02ld   |", i + 1);
 		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
 		{
-			printf(" %5.1fC  |", (double)gBms.bmb[i].brickTemp[j]);
+			printf(" %5.1fC  |", (double)convertBrickTemp(gBms.bmb[i].brickTempCode[j]));
 		}
 		printf("\n");
 	}
@@ -221,7 +258,7 @@ void printBoardTemperatures()
 		printf("|    %02ld   |", i + 1);
 		for (int32_t j = 0; j < NUM_BOARD_TEMP_PER_BMB; j++)
 		{
-			printf(" %5.1fC  |", (double)gBms.bmb[i].boardTemp[j]);
+			printf(" %5.1fC  |", (double)convertBoardTemp(gBms.bmb[i].boardTempCode[j]));
 		}
 		printf("\n");
 	}
@@ -297,5 +334,92 @@ void printSocAndSoe()
 	printf("Remaining SOC by OCV qualification time ms: %lu\n", getTimeTilExpirationMs(&gBms.soc.socByOcvGoodTimer));
 }
 
+void printAsciStats()
+{
+	printf("ASCI Link:\n");
+	printf("Transfers: %lu\t Batches: %lu\t Interrupts: %lu\t ISR Cycles: %lu\n", asciStats.numTransfers, asciStats.numBatches, asciStats.numInterrupts, asciStats.isrCycles);
+	printf("Last run - Messages: %lu\t Transfers: %lu\t Interrupts: %lu\t ISR Cycles: %lu\t Total Cycles: %lu\n",
+		asciStats.lastRunMessages, asciStats.lastRunTransfers, asciStats.lastRunInterrupts, asciStats.lastRunIsrCycles, asciStats.lastRunCycles);
+	printf("Queue verifies: %lu\t Skipped: %lu\t Bytes saved: %lu\t Last run bytes saved: %lu\n",
+		asciStats.numQueueVerifies, asciStats.numQueueVerifiesSkipped, asciStats.queueVerifyBytesSaved, asciStats.lastRunQueueVerifyBytesSaved);
+	printf("Config writes skipped: %lu\t Last data update transfers: %lu\t Cycles: %lu\n",
+		asciStats.numConfigWritesSkipped, asciStats.lastUpdateTransfers, asciStats.lastUpdateCycles);
+	printf("Scan budgets exhausted: %lu\t Last used ms: %lu\t Max used ms: %lu\n",
+		asciStats.numBudgetsExhausted, asciStats.lastBudgetUsedMs, asciStats.maxBudgetUsedMs);
+	printf("\n");
+}
+
+void printAsciCmdStats()
+{
+	static const char* cmdNames[NUM_ASCI_CMD_TYPES] = { "READALL", "QUEUED", "WRALL", "READDEV", "WRDEV", "HELLO" };
+
+	printf("|  CMD  |  CALLS  |  FAIL  | RETRY |  CRC  | ALIVE | TMOUT | ABORT | MAX US |\n");
+	for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+	{
+		const Asci_Cmd_Stats_S* stats = &asciCmdStats[i];
+		printf("|%7s|%9lu|%8lu|%7lu|%7lu|%7lu|%7lu|%7lu|%8lu|\n", cmdNames[i], stats->numCalls, stats->numFailures,
+			stats->numRetries, stats->numCrcErrors, stats->numAliveCounterErrors, stats->numTimeouts, stats->numBudgetAborts,
+			stats->maxLatencyUs);
+	}
+
+	// Bucket 0 holds latencies under 1us and bucket n holds latencies in [2^(n-1), 2^n) us, so each
+	// column is labelled with its inclusive lower bound. The last bucket also holds everything longer
+	printf("Latency histogram (us, column >= label):\n");
+	printf("%7s:", "US");
+	for (int32_t bucket = 0; bucket < ASCI_LATENCY_HIST_BUCKETS; bucket++)
+	{
+		printf(" %6lu", (bucket == 0) ? 0UL : (1UL << (bucket - 1)));
+	}
+	printf("\n");
+	for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+	{
+		printf("%7s:", cmdNames[i]);
+		for (int32_t bucket = 0; bucket < ASCI_LATENCY_HIST_BUCKETS; bucket++)
+		{
+			printf(" %6lu", asciCmdStats[i].latencyHist[bucket]);
+		}
+		printf("\n");
+	}
+	printf("\n");
+}
 
+void printAsciCapture()
+{
+#if ASCI_FRAME_CAPTURE
+	// One frame per line, oldest first: CAP <tick ms> <TX|RX> <hex bytes>
+	const uint32_t oldest = (asciCapture.head + ASCI_CAPTURE_NUM_FRAMES - asciCapture.numFrames) % ASCI_CAPTURE_NUM_FRAMES;
+	printf("ASCI capture: %lu frames, %lu dropped\n", asciCapture.numFrames, asciCapture.numDropped);
+	for (int32_t i = 0; i < asciCapture.numFrames; i++)
+	{
+		const Asci_Frame_S* frame = &asciCapture.frames[(oldest + i) % ASCI_CAPTURE_NUM_FRAMES];
+		printf("CAP %lu %s", frame->timestampMs, (frame->direction == ASCI_FRAME_TX) ? "TX" : "RX");
+		for (int32_t j = 0; j < frame->length; j++)
+		{
+			printf(" %02X", frame->data[j]);
+		}
+		printf("\n");
+	}
+	printf("\n");
+#endif
+}
 
+void printBmbLinkStats()
+{
+	// BMBs are listed by daisy chain position. Rate is the decaying share of frames corrupted at that BMB
+	printf("BMB Links: Unlocated errors: %lu\n", asciStats.numUnlocatedLinkErrors);
+	printf("| CH |   POS   |  FRAMES  |  CRC  | ALIVE | VERSION |  RATE  |\n");
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		const int32_t chainNumBmbs = gBms.chainNumBmbs[chainIdx];
+		selectAsciChain(chainIdx);
+		const int32_t suspectIdx = getSuspectBmbLink(chainNumBmbs);
+		for (int32_t i = 0; (i < chainNumBmbs) && (i < LINK_STATS_MAX_BMBS); i++)
+		{
+			const Bmb_Link_Stats_S* link = &bmbLinkStats[chainIdx][i];
+			printf("| %2lu |    %02ld  %s|%10lu|%7lu|%7lu|%9lu|%6.2f%%|\n", chainIdx, i, (i == suspectIdx) ? "* " : "  ", link->numFrames,
+				link->numCrcErrors, link->numAliveCounterShortfalls, link->numVersionMismatches,
+				(double)(link->errorRate * 100.0f / LINK_ERROR_RATE_FULL_SCALE));
+		}
+	}
+	printf("\n");
+}
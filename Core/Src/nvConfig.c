@@ -0,0 +1,100 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stddef.h>
+#include <string.h>
+#include "main.h"
+#include "nvConfig.h"
+#include "debug.h"
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Calculate the checksum of a configuration. Covers every byte before the checksum field
+  @param   config - The configuration to calculate the checksum of
+  @return  The FNV-1a hash of the configuration
+*/
+static uint32_t calcNvChecksum(const Nv_Config_S* config);
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Calculate the checksum of a configuration. Covers every byte before the checksum field
+  @param   config - The configuration to calculate the checksum of
+  @return  The FNV-1a hash of the configuration
+*/
+static uint32_t calcNvChecksum(const Nv_Config_S* config)
+{
+	const uint8_t* bytes = (const uint8_t*)config;
+	uint32_t hash = 0x811C9DC5;
+	for (uint32_t i = 0; i < offsetof(Nv_Config_S, checksum); i++)
+	{
+		hash = (hash ^ bytes[i]) * 0x01000193;
+	}
+	return hash;
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Load the configuration stored in flash
+  @param   config - Updated with the stored configuration
+  @return  True if a valid configuration was stored, false otherwise
+*/
+bool loadNvConfig(Nv_Config_S* config)
+{
+	memcpy(config, (const void*)NV_CONFIG_ADDRESS, sizeof(Nv_Config_S));
+	return (config->magic == NV_CONFIG_MAGIC) &&
+		   (config->version == NV_CONFIG_VERSION) &&
+		   (config->checksum == calcNvChecksum(config));
+}
+
+/*!
+  @brief   Store a configuration in flash. Erasing the sector stalls the CPU for up to 2s so this
+		   must not be called while the car is running
+  @param   config - The configuration to store. The magic, version and checksum are filled in
+  @return  True if the configuration was stored and verified, false otherwise
+*/
+bool saveNvConfig(Nv_Config_S* config)
+{
+	config->magic = NV_CONFIG_MAGIC;
+	config->version = NV_CONFIG_VERSION;
+	config->checksum = calcNvChecksum(config);
+
+	FLASH_EraseInitTypeDef eraseInit =
+	{
+		.TypeErase = FLASH_TYPEERASE_SECTORS,
+		.Sector = NV_CONFIG_SECTOR,
+		.NbSectors = 1,
+		.VoltageRange = FLASH_VOLTAGE_RANGE_3
+	};
+	uint32_t sectorError = 0;
+
+	HAL_FLASH_Unlock();
+	bool success = (HAL_FLASHEx_Erase(&eraseInit, &sectorError) == HAL_OK);
+
+	// Nv_Config_S is a whole number of words
+	const uint32_t* words = (const uint32_t*)config;
+	for (uint32_t i = 0; success && (i < sizeof(Nv_Config_S) / sizeof(uint32_t)); i++)
+	{
+		success = (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, NV_CONFIG_ADDRESS + (i * sizeof(uint32_t)), words[i]) == HAL_OK);
+	}
+	HAL_FLASH_Lock();
+
+	success = success && (memcmp((const void*)NV_CONFIG_ADDRESS, config, sizeof(Nv_Config_S)) == 0);
+	if (!success)
+	{
+		Debug("Failed to store configuration in flash\n");
+	}
+	return success;
+}
@@ -0,0 +1,92 @@
+#ifndef SIM_BLOCKINGINTERFACE_H_
+#define SIM_BLOCKINGINTERFACE_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bmbInterface.h"
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Power on ASCI
+*/
+void blockingEnableASCI();
+
+/*!
+  @brief   Power off ASCI
+*/
+void blockingDisableASCI();
+
+/*!
+  @brief   Power cycle the ASCI
+*/
+void blockingResetASCI();
+
+/*!
+  @brief   Clears the RX buffer on the ASCI
+*/
+void blockingClearRxBuffer();
+
+/*!
+  @brief   Clears the TX buffer on the ASCI
+*/
+void blockingClearTxBuffer();
+
+/*!
+  @brief   Initialize ASCI and BMB daisy chain. Enumerate BMBs
+  @param   numBmbs - Updated with number of enumerated BMBs from HELLOALL command
+  @return  True if successful initialization, false otherwise
+*/
+bool blockingInitASCI();
+
+/*!
+  @brief   Initialize BMB Daisy Chain. Enumerate BMBs
+  @param   numBmbs - The number of BMBs detected in the daisy chain
+  @return  True if successful initialization, false otherwise
+*/
+bool blockingHelloAll(uint32_t* numBmbs);
+
+/*!
+  @brief   Write data to all registers on BMBs
+  @param   address - BMB register address to write to
+  @param   value - Value to write to BMB register
+  @param   numBmbs - The number of BMBs we expect to write to
+  @return  True if success, false otherwise
+*/
+bool blockingWriteAll(uint8_t address, uint16_t value, uint32_t numBmbs);
+
+/*!
+  @brief   Write data to a register on single a BMB
+  @param   address - BMB register address to write to
+  @param   value - Value to write to BMB register
+  @param   bmbIndex - The index of the target BMB to write to
+  @return  True if success, false otherwise
+*/
+bool blockingWriteDevice(uint8_t address, uint16_t value, uint32_t bmbIndex);
+
+/*!
+  @brief   Read data from a register on all BMBs
+  @param   address - BMB register address to read from
+  @param   data_p - Array to read in the data to
+  @param   numBmbs - The number of BMBs we expect to read from
+  @return  True if success, false otherwise
+*/
+bool blockingReadAll(uint8_t address, uint8_t *data_p, uint32_t numBmbs);
+
+/*!
+  @brief   Read data from a register on a single BMB
+  @param   address - BMB register address to read from
+  @param   data_p - Array to read in the data to
+  @param   bmbIndex - The index of the target BMB to read from
+  @return  True if success, false otherwise
+*/
+bool blockingReadDevice(uint8_t address, uint8_t *data_p, uint32_t bmbIndex);
+
+#endif /* SIM_BLOCKINGINTERFACE_H_ */
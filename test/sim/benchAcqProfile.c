@@ -0,0 +1,66 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include "simHarness.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Brick voltage noise of a single simulated sample. An assumed value, not a datasheet figure.
+// Oversampling averages it down and the 14 bit code quantizes it
+#define ACQ_SIM_NOISE_UV	1000.0f
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+static const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Run the acquisition profile benchmark of the BMS on the simulator. See
+		   runAcqProfileBenchmark in bms.c
+*/
+int main(void)
+{
+	static const char* profileNames[NUM_ACQ_PROFILES] = { "Precise", "Fast" };
+
+	uint32_t numBmbs = 0;
+	selectAsciChain(0);
+	if (!simInitPack(bmb, chainNumBmbs, &numBmbs))
+	{
+		printf("BMB chain failed to initialize\n");
+		return 1;
+	}
+	simPlanScans(numBmbs);
+	simSetMeasurementNoise(ACQ_SIM_NOISE_UV);
+
+	printf("Acquisition profiles - %lu BMBs, %d scans per profile, %.0f uV rms single sample noise\n", (unsigned long)numBmbs,
+		ACQ_BENCHMARK_SCANS, ACQ_SIM_NOISE_UV);
+	printf("  Profile | Slot (ms) | Latency (ms) | Noise (uV rms) | Samples\n");
+	Acq_Profile_Result_S results[NUM_ACQ_PROFILES];
+	bool success = true;
+	for (int32_t profile = 0; profile < NUM_ACQ_PROFILES; profile++)
+	{
+		Acq_Profile_Result_S* result = &results[profile];
+		measureAcqProfile(profile, bmb, chainNumBmbs, ACQ_BENCHMARK_SCANS, result);
+		printf("  %7s | %9lu | %12.1f | %14.0f | %7lu\n", profileNames[profile], (unsigned long)getScanSlotMs(profile),
+			result->latencyMs, result->noiseUv, (unsigned long)result->numSamples);
+		success &= (result->numSamples > 1);
+	}
+	setAcqProfile(ACQ_PROFILE_PRECISE);
+
+	// Eight times the oversamples should leave well under half the noise
+	success &= (results[ACQ_PROFILE_PRECISE].noiseUv < results[ACQ_PROFILE_FAST].noiseUv);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include "simHarness.h"
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Count every ASCI command issued
+  @return  The total number of commands
+*/
+static uint32_t countCommands(void)
+{
+	uint32_t numCommands = 0;
+	for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+	{
+		numCommands += asciCmdStats[i].numCalls;
+	}
+	return numCommands;
+}
+
+/*!
+  @brief   Bring the chain back up from a power cycle of every BMB and clear the last known break
+		   location with a search of the intact chain
+  @param   numBmbs - The number of BMBs on the chain
+  @return  True if the chain came back up, false otherwise
+*/
+static bool restoreChain(uint32_t numBmbs)
+{
+	simBreakHop(0, -1);
+	simSetExternalLoopback(0, false);
+	for (uint32_t i = 0; i < numBmbs; i++)
+	{
+		simPowerOnReset(0, i);
+	}
+
+	const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = { numBmbs };
+	uint32_t numFound = 0;
+	return simInitPack(bmb, chainNumBmbs, &numFound) && (detectBmbDaisyChainBreak(bmb, numBmbs) == 0);
+}
+
+/*!
+  @brief   Search for the chain break the way the BMS does after its start up fails
+  @param   numBmbs - The number of BMBs on the chain
+  @param   timeUs - Updated with the time the search took in us
+  @param   numTransfers - Updated with the number of SPI transfers the search took
+  @param   numCommands - Updated with the number of ASCI commands the search issued
+  @return  The break location returned by detectBmbDaisyChainBreak
+*/
+static int32_t searchBreak(uint32_t numBmbs, double* timeUs, uint32_t* numTransfers, uint32_t* numCommands)
+{
+	uint32_t numFound = 0;
+	initASCI();
+	helloAll(&numFound);	// Fails without a loopback
+
+	simResetStats();
+	const uint64_t startCycles = hostGetCycles();
+	const int32_t breakLocation = detectBmbDaisyChainBreak(bmb, numBmbs);
+	*timeUs = (double)(hostGetCycles() - startCycles) / (SystemCoreClock / 1000000);
+	*numTransfers = asciStats.numTransfers;
+	*numCommands = countCommands();
+	return breakLocation;
+}
+
+/*!
+  @brief   Break every hop of a chain in turn and time how long the BMS takes to locate it, first
+		   with no break location remembered and then searching for the same break again
+  @param   numBmbs - The number of BMBs on the chain
+  @return  True if every break was located correctly, false otherwise
+*/
+static bool benchChain(uint32_t numBmbs)
+{
+	simSetNumBmbs(0, numBmbs);
+	selectAsciChain(0);
+
+	printf("Break location - %lu BMBs\n", (unsigned long)numBmbs);
+	printf("  Break                | Found | First search (ms / transfers / cmds) | Repeated search (ms / transfers / cmds)\n");
+	bool success = true;
+	double worstUs = 0.0;
+	double totalUs = 0.0;
+	for (uint32_t hopIdx = 0; hopIdx <= numBmbs; hopIdx++)
+	{
+		if (!restoreChain(numBmbs))
+		{
+			printf("  Chain failed to come back up before breaking hop %lu\n", (unsigned long)hopIdx);
+			return false;
+		}
+
+		// Past the last BMB the break is in the external loopback, which the BMS replaces with the
+		// internal loopback of the last BMB
+		int32_t expectedLocation = hopIdx + 1;
+		if (hopIdx == numBmbs)
+		{
+			simSetExternalLoopback(0, true);
+			setBmbInternalLoopback(numBmbs - 1, false);
+			expectedLocation = 0;
+		}
+		simBreakHop(0, hopIdx);
+
+		double firstUs = 0.0;
+		double repeatUs = 0.0;
+		uint32_t firstTransfers = 0;
+		uint32_t repeatTransfers = 0;
+		uint32_t firstCommands = 0;
+		uint32_t repeatCommands = 0;
+		const int32_t firstLocation = searchBreak(numBmbs, &firstUs, &firstTransfers, &firstCommands);
+		const int32_t repeatLocation = searchBreak(numBmbs, &repeatUs, &repeatTransfers, &repeatCommands);
+		const bool located = (firstLocation == expectedLocation) && (repeatLocation == expectedLocation);
+
+		char breakName[32];
+		if (hopIdx == 0)
+		{
+			snprintf(breakName, sizeof(breakName), "BMS - BMB 1");
+		}
+		else if (hopIdx < numBmbs)
+		{
+			snprintf(breakName, sizeof(breakName), "BMB %lu - BMB %lu", (unsigned long)hopIdx, (unsigned long)hopIdx + 1);
+		}
+		else
+		{
+			snprintf(breakName, sizeof(breakName), "External loopback");
+		}
+		printf("  %-20s | %5ld | %12.2f / %9lu / %4lu | %15.2f / %9lu / %4lu%s\n", breakName, (long)firstLocation,
+			firstUs / 1000.0, (unsigned long)firstTransfers, (unsigned long)firstCommands, repeatUs / 1000.0,
+			(unsigned long)repeatTransfers, (unsigned long)repeatCommands, located ? "" : "  WRONG");
+		success &= located;
+		worstUs = (firstUs > worstUs) ? firstUs : worstUs;
+		totalUs += firstUs;
+	}
+	printf("  First search: %.2f ms average, %.2f ms worst case\n\n", totalUs / 1000.0 / (numBmbs + 1), worstUs / 1000.0);
+
+	success &= restoreChain(numBmbs);
+	return success;
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Time the daisy chain break search at every break position for the pack chain length
+		   and the longest chain
+*/
+int main(void)
+{
+	static const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+	// Connect the simulated chain before its length is changed
+	selectAsciChain(0);
+	initASCI();
+
+	bool success = benchChain(chainNumBmbs[0]);
+	success &= benchChain(MAX_BMBS_PER_CHAIN);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Included rather than linked so the static CRC functions can be called directly
+#include "bmbInterface.c"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// CRCs calculated per frame length and method
+#define CRC_BENCH_ITERATIONS	200000
+
+// Random bytes the frames are taken from, so the CRC inputs change every iteration
+#define CRC_BENCH_DATA_SIZE		4096
+
+// Longest daisy chain the ASCI can address, past the MAX_BMBS_PER_CHAIN the BMS uses
+#define CRC_BENCH_MAX_BMBS		32
+
+// Bytes of a readAll response covered by its CRC besides the register data. Command, address and
+// data check byte
+#define READ_ALL_CRC_OVERHEAD	3
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CRC_BENCH_TIME_UNIT		"cycle"
+#else
+#define CRC_BENCH_TIME_UNIT		"ns"
+#endif
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static uint8_t crcBenchData[CRC_BENCH_DATA_SIZE];
+
+// Keeps the compiler from dropping the CRC loops
+static volatile uint8_t crcSink;
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   The bitwise CRC of the blocking driver. See baseline/blockingInterface.c
+*/
+static uint8_t referenceCrc(uint8_t* byteArr, uint32_t numBytes)
+{
+	uint8_t crc = 0x00;
+	const uint8_t poly = 0xB2;
+	for (uint32_t i = 0; i < numBytes; i++)
+	{
+		crc = crc ^ byteArr[i];
+		for (int32_t j = 0; j < 8; j++)
+		{
+			if (crc & 0x01)
+			{
+				crc = ((crc >> 1) ^ poly);
+			}
+			else
+			{
+				crc = (crc >> 1);
+			}
+		}
+	}
+	return crc;
+}
+
+/*!
+  @brief   Read a free running host timestamp. TSC cycles where available, nanoseconds otherwise
+*/
+static uint64_t readTimestamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return hostGetCpuNs();
+#endif
+}
+
+/*!
+  @brief   Time a CRC function over frames of the given length
+  @param   crcFunc - The CRC function to time
+  @param   numBytes - The number of bytes in each frame
+  @return  The number of bytes processed per timestamp tick
+*/
+static double benchCrc(uint8_t (*crcFunc)(uint8_t*, uint32_t), uint32_t numBytes)
+{
+	const uint32_t numOffsets = CRC_BENCH_DATA_SIZE - numBytes;
+	uint8_t crc = 0;
+	const uint64_t start = readTimestamp();
+	for (uint32_t i = 0; i < CRC_BENCH_ITERATIONS; i++)
+	{
+		crc ^= crcFunc(&crcBenchData[(i * 61) % numOffsets], numBytes);
+	}
+	const uint64_t elapsed = readTimestamp() - start;
+	crcSink = crc;
+	return (double)CRC_BENCH_ITERATIONS * numBytes / (double)((elapsed > 0) ? elapsed : 1);
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Compare the table driven CRC against the bitwise CRC of the blocking driver over the
+		   readAll responses of 1 to 32 BMBs
+*/
+int main(void)
+{
+	srand(1);
+	for (uint32_t i = 0; i < CRC_BENCH_DATA_SIZE; i++)
+	{
+		crcBenchData[i] = (uint8_t)rand();
+	}
+
+	// Both methods must agree before their speed means anything
+	uint32_t numMismatches = 0;
+	for (uint32_t numBytes = 0; numBytes <= 255; numBytes++)
+	{
+		for (uint32_t offset = 0; offset < 64; offset++)
+		{
+			numMismatches += (calcCrc(&crcBenchData[offset], numBytes) != referenceCrc(&crcBenchData[offset], numBytes)) ? 1 : 0;
+		}
+	}
+	if (numMismatches != 0)
+	{
+		printf("Table CRC differs from the bitwise CRC %lu times\n", (unsigned long)numMismatches);
+		return 1;
+	}
+
+	printf("readAll response CRC - %d CRCs per length, bytes per host %s\n", CRC_BENCH_ITERATIONS, CRC_BENCH_TIME_UNIT);
+	printf("  BMBs | CRC bytes | Bitwise | Table  | Speedup\n");
+	double bitTotal = 0;
+	double tableTotal = 0;
+	for (uint32_t numBmbs = 1; numBmbs <= CRC_BENCH_MAX_BMBS; numBmbs++)
+	{
+		const uint32_t numBytes = READ_ALL_CRC_OVERHEAD + numBmbs * BYTES_PER_BMB_REGISTER;
+		const double bitRate = benchCrc(referenceCrc, numBytes);
+		const double tableRate = benchCrc(calcCrc, numBytes);
+		bitTotal += numBytes / bitRate;
+		tableTotal += numBytes / tableRate;
+		printf("  %4lu | %9lu | %7.3f | %6.3f | %6.1fx\n", (unsigned long)numBmbs, (unsigned long)numBytes, bitRate, tableRate, tableRate / bitRate);
+	}
+	printf("Over all lengths the table is %.1fx faster than the bitwise CRC\n", bitTotal / tableTotal);
+	return (tableTotal < bitTotal) ? 0 : 1;
+}
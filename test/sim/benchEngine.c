@@ -0,0 +1,167 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include <string.h>
+#include "simHarness.h"
+#include "blockingInterface.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// The data registers read out after a full scan. See DATA_BLOCK_START in bmb.c
+#define READOUT_START			CELLn
+#define READOUT_NUM_REGISTERS	(AIN2 - CELLn + 1)
+
+// Scan readouts measured per driver
+#define ENGINE_BENCH_READOUTS	100
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	const char* name;
+	bool (*readout)(void);
+	uint8_t data[READOUT_NUM_REGISTERS][SPI_BUFF_SIZE];
+} Readout_Driver_S;
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+static const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+static uint8_t (*readoutData)[SPI_BUFF_SIZE];
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Read out the scan data registers with the blocking driver. Every SPI transfer and the
+		   ASCI interrupt of every readAll block the task
+*/
+static bool readoutBlocking(void)
+{
+	bool success = true;
+	for (uint32_t i = 0; i < READOUT_NUM_REGISTERS; i++)
+	{
+		success &= blockingReadAll(READOUT_START + i, readoutData[i], chainNumBmbs[0]);
+	}
+	return success;
+}
+
+/*!
+  @brief   Read out the scan data registers with one transaction engine run per register
+*/
+static bool readoutSerial(void)
+{
+	bool success = true;
+	for (uint32_t i = 0; i < READOUT_NUM_REGISTERS; i++)
+	{
+		success &= readAll(READOUT_START + i, readoutData[i], chainNumBmbs[0]);
+	}
+	return success;
+}
+
+/*!
+  @brief   Read out the scan data registers with a single transaction engine run, as bmb.c does
+*/
+static bool readoutBlock(void)
+{
+	return readAllBlock(READOUT_START, READOUT_NUM_REGISTERS, readoutData, NULL, chainNumBmbs[0]);
+}
+
+/*!
+  @brief   Read out the scan data registers repeatedly and report the cost of a readout
+  @param   driver - The driver to read out with. Its data is updated with the last readout
+  @param   latencyUs - Updated with the average readout latency in us
+  @param   numWakeups - Updated with the average number of times the task was woken per readout
+  @return  True if every readout succeeded, false otherwise
+*/
+static bool benchReadout(Readout_Driver_S* driver, double* latencyUs, double* numWakeups)
+{
+	readoutData = driver->data;
+	simResetStats();
+	const uint64_t startCycles = hostGetCycles();
+	uint32_t numFailed = 0;
+	for (uint32_t i = 0; i < ENGINE_BENCH_READOUTS; i++)
+	{
+		numFailed += driver->readout() ? 0 : 1;
+	}
+	const uint64_t cpuNs = hostHalStats.taskCpuNs;
+
+	*latencyUs = (double)(hostGetCycles() - startCycles) / ENGINE_BENCH_READOUTS / (SystemCoreClock / 1000000);
+	*numWakeups = (double)hostHalStats.numTaskWakeups / ENGINE_BENCH_READOUTS;
+	printf("  %-22s | %12.1f | %13.1f | %10.1f | %12.1f | %13.2f | %6lu\n", driver->name, *latencyUs,
+		(double)asciSimStats.numTransfers / ENGINE_BENCH_READOUTS, (double)hostHalStats.numIsrRuns / ENGINE_BENCH_READOUTS,
+		*numWakeups, (double)cpuNs / ENGINE_BENCH_READOUTS / 1000.0, (unsigned long)numFailed);
+	return (numFailed == 0);
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(void)
+{
+	static Readout_Driver_S drivers[] =
+	{
+		{ .name = "Blocking (before)", .readout = readoutBlocking },
+		{ .name = "Engine, readAll each", .readout = readoutSerial },
+		{ .name = "Engine, readAllBlock", .readout = readoutBlock },
+	};
+	const uint32_t numDrivers = sizeof(drivers) / sizeof(drivers[0]);
+
+	// The BMBs are configured once. Without updateBmbData no new scans start, so every readout
+	// returns the same data
+	uint32_t numBmbs = 0;
+	selectAsciChain(0);
+	if (!simInitPack(bmb, chainNumBmbs, &numBmbs))
+	{
+		printf("BMB chain failed to initialize\n");
+		return 1;
+	}
+
+	printf("Scan readout - %lu BMBs, %d registers, %d readouts per driver\n", (unsigned long)numBmbs, READOUT_NUM_REGISTERS, ENGINE_BENCH_READOUTS);
+	printf("  Driver                 | Latency (us) | SPI transfers | Interrupts | Task wakeups | Task CPU (us) | Failed\n");
+	double latencyUs[numDrivers];
+	double numWakeups[numDrivers];
+	bool success = true;
+	for (uint32_t i = 0; i < numDrivers; i++)
+	{
+		// The blocking driver leaves the ASCI configured its own way
+		success &= (i == 0) ? blockingInitASCI() : initASCI();
+		success &= benchReadout(&drivers[i], &latencyUs[i], &numWakeups[i]);
+	}
+	printf("  Task CPU time is host time spent in the drivers outside the simulated interrupts\n\n");
+
+	// Every driver must read the same frames
+	const uint32_t frameLength = 1 + 5 + (2 * numBmbs);
+	for (uint32_t i = 1; i < numDrivers; i++)
+	{
+		for (uint32_t j = 0; j < READOUT_NUM_REGISTERS; j++)
+		{
+			if (memcmp(drivers[0].data[j], drivers[i].data[j], frameLength) != 0)
+			{
+				printf("%s read register 0x%02X differently from %s\n", drivers[i].name, READOUT_START + j, drivers[0].name);
+				success = false;
+			}
+		}
+	}
+
+	printf("readAllBlock vs blocking driver: %.1fx lower latency, %.1fx fewer task wakeups\n",
+		latencyUs[0] / latencyUs[2], numWakeups[0] / ((numWakeups[2] > 0) ? numWakeups[2] : 1));
+	success &= (latencyUs[2] < latencyUs[0]) && (numWakeups[2] < numWakeups[0]);
+	return success ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include "simHarness.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Readouts measured per plan, after the scan prediction has settled. Longer than the longest schedule
+#define EXTREMES_SETTLE_READOUTS	5
+#define EXTREMES_READOUTS			128
+
+// Brick voltages of the simulated pack. Every BMB has one high and one low brick
+#define EXTREMES_BRICK_V			3.70f
+#define EXTREMES_HIGH_BRICK_V		3.75f
+#define EXTREMES_LOW_BRICK_V		3.65f
+
+// Refresh period of the full brick readout when the extremes slots are measured. Long enough that
+// nearly every slot only refreshes the extremes
+#define EXTREMES_CELL_V_PERIOD_MS	1000
+
+// A full brick readout reads every brick and MINMAXCELL. The extremes slots have to save at least one
+// of those registers
+#define EXTREMES_MAX_READOUT_RATIO	((double)NUM_BRICKS_PER_BMB / (NUM_BRICKS_PER_BMB + 1))
+
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+	PATTERN_NARROW = 0,		// The high and low bricks of every BMB sit next to each other
+	PATTERN_SPREAD,			// The high and low bricks are spread so all BMBs together cover every brick
+	NUM_PATTERNS
+} Brick_Pattern_E;
+
+typedef enum
+{
+	PLAN_FULL = 0,			// Every slot reads all bricks
+	PLAN_EXTREMES,			// Slots only read MINMAXCELL and the bricks between the extremes
+	NUM_PLANS
+} Scan_Plan_E;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	uint32_t slotMs;
+	double readoutMs;
+	double transfers;
+} Plan_Result_S;
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+static const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Set the brick voltages of every simulated BMB
+  @param   pattern - Where the high and low bricks of each BMB sit
+  @param   numBmbs - The number of BMBs on the chain
+*/
+static void setBrickPattern(Brick_Pattern_E pattern, uint32_t numBmbs)
+{
+	for (uint32_t i = 0; i < numBmbs; i++)
+	{
+		const uint32_t highBrick = (pattern == PATTERN_NARROW) ? (4 + (i % 2)) : ((i * 5) % NUM_BRICKS_PER_BMB);
+		const uint32_t lowBrick = (pattern == PATTERN_NARROW) ? (6 + (i % 2)) : ((i * 5 + 6) % NUM_BRICKS_PER_BMB);
+		for (uint32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			const float voltage = (j == highBrick) ? EXTREMES_HIGH_BRICK_V : ((j == lowBrick) ? EXTREMES_LOW_BRICK_V : EXTREMES_BRICK_V);
+			simSetBrickVoltage(0, i, j, voltage);
+		}
+	}
+}
+
+/*!
+  @brief   Measure the scan readouts of a scan plan. The plans only differ in how often every
+		   brick is read
+  @param   plan - The scan plan
+  @param   numBmbs - The number of BMBs on the chain
+  @param   result - Updated with the slot period and the mean readout
+  @return  True if every readout succeeded, false otherwise
+*/
+static bool benchPlan(Scan_Plan_E plan, uint32_t numBmbs, Plan_Result_S* result)
+{
+	const uint32_t cellVPeriodMs = (plan == PLAN_FULL) ? SCAN_CELL_EXTREMES_PERIOD_MS : EXTREMES_CELL_V_PERIOD_MS;
+	const uint32_t periodMs[NUM_SCAN_PRODUCTS] =
+	{
+		cellVPeriodMs, SCAN_CELL_EXTREMES_PERIOD_MS, SCAN_SEGMENT_V_PERIOD_MS, SCAN_BRICK_TEMP_PERIOD_MS, SCAN_BOARD_TEMP_PERIOD_MS, SCAN_DIAGNOSTICS_PERIOD_MS
+	};
+	planBmbScans(periodMs, numBmbs);
+	for (uint32_t i = 0; i < EXTREMES_SETTLE_READOUTS; i++)
+	{
+		runBmbScanToReadout(bmb, chainNumBmbs);
+	}
+
+	simResetStats();
+	uint32_t numReadouts = 0;
+	uint64_t readoutCycles = 0;
+	for (uint32_t i = 0; i < EXTREMES_READOUTS; i++)
+	{
+		if (runBmbScanToReadout(bmb, chainNumBmbs))
+		{
+			numReadouts++;
+			readoutCycles += asciStats.lastUpdateCycles;
+		}
+	}
+	const uint32_t readoutDivisor = (numReadouts > 0) ? numReadouts : 1;
+	result->slotMs = getScanSlotMs(ACQ_PROFILE_PRECISE);
+	result->readoutMs = (double)readoutCycles / readoutDivisor / (SystemCoreClock / 1000);
+	result->transfers = (double)asciStats.numTransfers / readoutDivisor;
+	return (numReadouts == EXTREMES_READOUTS);
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Compare the readout of slots that only refresh the cell extremes against slots that
+		   read every brick, with the extreme bricks close together and spread over the BMB
+*/
+int main(void)
+{
+	static const char* patternNames[NUM_PATTERNS] = { "Narrow", "Spread" };
+	static const char* planNames[NUM_PLANS] = { "Full", "Extremes" };
+
+	uint32_t numBmbs = 0;
+	selectAsciChain(0);
+	if (!simInitPack(bmb, chainNumBmbs, &numBmbs))
+	{
+		printf("BMB chain failed to initialize\n");
+		return 1;
+	}
+
+	printf("Cell extremes readout - %lu BMBs, %d readouts per plan\n", (unsigned long)numBmbs, EXTREMES_READOUTS);
+	printf("  Bricks | Plan     | Slot (ms) | Readout (ms) | Transfers\n");
+	bool success = true;
+	for (int32_t pattern = 0; pattern < NUM_PATTERNS; pattern++)
+	{
+		setBrickPattern(pattern, numBmbs);
+		Plan_Result_S results[NUM_PLANS];
+		for (int32_t plan = 0; plan < NUM_PLANS; plan++)
+		{
+			Plan_Result_S* result = &results[plan];
+			success &= benchPlan(plan, numBmbs, result);
+			printf("  %6s | %-8s | %9lu | %12.3f | %9.1f\n", patternNames[pattern], planNames[plan], (unsigned long)result->slotMs,
+				result->readoutMs, result->transfers);
+		}
+
+		// The extremes slots have to be cheaper than reading every brick however the extremes lie
+		success &= (results[PLAN_EXTREMES].readoutMs <= results[PLAN_FULL].readoutMs * EXTREMES_MAX_READOUT_RATIO);
+	}
+	printf("  Extremes spanning more than CELL_EXTREMES_MAX_SPAN bricks are not read. The next full brick readout refreshes them\n");
+	return success ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include "simHarness.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Readouts and alert polls measured per chain length, after the scan prediction has settled
+#define SCALING_SETTLE_READOUTS		5
+#define SCALING_READOUTS			50
+#define SCALING_ALERT_POLLS			50
+
+// aggregateBmbData is only CPU time, so it is repeated to get a stable host measurement
+#define SCALING_AGGREGATE_CALLS		20000
+
+_Static_assert(SIM_MAX_BMBS >= MAX_BMBS_IN_ACCUMULATOR, "The simulated chains must hold MAX_BMBS_IN_ACCUMULATOR BMBs");
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Change the length of the simulated chains and bring them up from a power cycle of every BMB
+  @param   chainNumBmbs - The number of BMBs on each chain
+  @return  True if every chain came up, false otherwise
+*/
+static bool setChainLengths(const uint32_t* chainNumBmbs)
+{
+	uint32_t longestChain = 0;
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		simSetNumBmbs(chainIdx, chainNumBmbs[chainIdx]);
+		for (uint32_t i = 0; i < chainNumBmbs[chainIdx]; i++)
+		{
+			simPowerOnReset(chainIdx, i);
+		}
+		longestChain = (chainNumBmbs[chainIdx] > longestChain) ? chainNumBmbs[chainIdx] : longestChain;
+	}
+
+	uint32_t numBmbs = 0;
+	if (!simInitPack(bmb, chainNumBmbs, &numBmbs))
+	{
+		return false;
+	}
+	simPlanScans(longestChain);
+	return true;
+}
+
+/*!
+  @brief   Measure the scan loop, aggregation and alert poll for one pack size. Packs longer than
+		   a chain are split evenly across chains, as runPackScalingBenchmark in bms.c assumes
+  @param   numBmbs - The number of BMBs in the pack
+  @return  True if every readout and alert poll succeeded, false otherwise
+*/
+static bool benchPackSize(uint32_t numBmbs)
+{
+	const uint32_t numChains = (numBmbs + MAX_BMBS_PER_CHAIN - 1) / MAX_BMBS_PER_CHAIN;
+	uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = { 0 };
+	for (uint32_t chainIdx = 0; chainIdx < numChains; chainIdx++)
+	{
+		// The first chains take the extra BMBs when the pack does not split evenly
+		chainNumBmbs[chainIdx] = (numBmbs / numChains) + ((chainIdx < numBmbs % numChains) ? 1 : 0);
+	}
+	if (!setChainLengths(chainNumBmbs))
+	{
+		printf("  %4lu | %6lu | chains failed to initialize\n", (unsigned long)numBmbs, (unsigned long)numChains);
+		return false;
+	}
+	for (uint32_t i = 0; i < SCALING_SETTLE_READOUTS; i++)
+	{
+		runBmbScanToReadout(bmb, chainNumBmbs);
+	}
+
+	// Scan readouts back to back. The period covers the scan and its readout
+	simResetStats();
+	const uint64_t scanStartCycles = hostGetCycles();
+	uint32_t numReadouts = 0;
+	uint64_t readoutCycles = 0;
+	for (uint32_t i = 0; i < SCALING_READOUTS; i++)
+	{
+		if (runBmbScanToReadout(bmb, chainNumBmbs))
+		{
+			numReadouts++;
+			readoutCycles += asciStats.lastUpdateCycles;
+		}
+	}
+	const uint32_t readoutDivisor = (numReadouts > 0) ? numReadouts : 1;
+	const double periodMs = (double)(hostGetCycles() - scanStartCycles) / SCALING_READOUTS / (SystemCoreClock / 1000);
+	const double readoutMs = (double)readoutCycles / readoutDivisor / (SystemCoreClock / 1000);
+	const double readoutTransfers = (double)asciStats.numTransfers / readoutDivisor;
+	const double readoutCpuUs = (double)hostHalStats.taskCpuNs / readoutDivisor / 1000.0;
+
+	const uint64_t aggregateStartNs = hostGetCpuNs();
+	for (uint32_t i = 0; i < SCALING_AGGREGATE_CALLS; i++)
+	{
+		aggregateBmbData(bmb, numBmbs);
+	}
+	const double aggregateUs = (double)(hostGetCpuNs() - aggregateStartNs) / SCALING_AGGREGATE_CALLS / 1000.0;
+
+	simResetStats();
+	uint32_t numAlertPolls = 0;
+	const uint64_t alertStartCycles = hostGetCycles();
+	for (uint32_t i = 0; i < SCALING_ALERT_POLLS; i++)
+	{
+		numAlertPolls += pollBmbAlerts(bmb, chainNumBmbs) ? 1 : 0;
+	}
+	const double alertMs = (double)(hostGetCycles() - alertStartCycles) / SCALING_ALERT_POLLS / (SystemCoreClock / 1000);
+	const double alertTransfers = (double)asciStats.numTransfers / SCALING_ALERT_POLLS;
+
+	printf("  %4lu | %6lu | %11.2f | %12.3f | %9.1f | %13.2f | %14.3f | %10.3f | %9.1f\n", (unsigned long)numBmbs, (unsigned long)numChains,
+		periodMs, readoutMs, readoutTransfers, readoutCpuUs, aggregateUs, alertMs, alertTransfers);
+	return (numReadouts == SCALING_READOUTS) && (numAlertPolls == SCALING_ALERT_POLLS);
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Measure how the scan loop, aggregation and alert poll scale with the pack size, up to
+		   MAX_BMBS_IN_ACCUMULATOR
+*/
+int main(void)
+{
+	// Connect the simulated chains before their length is changed
+	for (uint32_t chainIdx = 0; chainIdx < NUM_ASCI_CHAINS; chainIdx++)
+	{
+		selectAsciChain(chainIdx);
+		initASCI();
+	}
+
+	printf("Scaling with pack size - %d readouts and %d alert polls per size\n", SCALING_READOUTS, SCALING_ALERT_POLLS);
+	printf("  BMBs | Chains | Period (ms) | Readout (ms) | Transfers | Task CPU (us) | Aggregate (us) | Alert (ms) | Transfers\n");
+	bool success = true;
+	for (uint32_t numBmbs = 1; numBmbs <= MAX_BMBS_IN_ACCUMULATOR; numBmbs++)
+	{
+		success &= benchPackSize(numBmbs);
+	}
+	printf("  Task CPU and aggregate times are host time. Period, readout and alert times are simulated bus time\n");
+	return success ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include <string.h>
+#include "simHarness.h"
+#include "leakyBucket.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Scan readouts measured per scenario
+#define THROUGHPUT_READOUTS	500
+#define RETRY_READOUTS		200
+
+// Longest a recovery scenario may take before it is counted as failed
+#define RECOVERY_TIMEOUT_MS	2000
+// How long an injected chain break is left in place
+#define BREAK_DURATION_MS	100
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern LeakyBucket_S asciCommsLeakyBucket;
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+static const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+// Recovery state and blackout statistics of the BMS. See gBms.recovery
+static Recovery_State_S recovery;
+static const char* recoveryTierNames[NUM_RECOVERY_TIERS] = { "Soft resync", "BMB reinit", "Cold init" };
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Make one recovery attempt the way recoverBatteryPack in bms.c does
+  @param   tier - Updated with the recovery tier that was required
+  @return  True if the pack recovered, false otherwise
+*/
+static bool recoverPack(Recovery_Tier_E* tier)
+{
+	uint32_t foundChainNumBmbs[NUM_ASCI_CHAINS];
+	uint32_t numBmbs = 0;
+	if (!recoverBmbChains(&recovery, chainNumBmbs, bmb, foundChainNumBmbs, &numBmbs, tier))
+	{
+		return false;
+	}
+	simPlanScans(numBmbs);
+	return true;
+}
+
+/*!
+  @brief   Check that the last readout decoded good voltages for every brick in the pack
+  @return  True if every brick voltage is good, false otherwise
+*/
+static bool allBrickVGood(void)
+{
+	for (uint32_t i = 0; i < chainNumBmbs[0]; i++)
+	{
+		for (int32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			if (SENSOR_STATUS(bmb[i].brickVCode[j]) != GOOD)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*!
+  @brief   Read out scans back to back and report the readout rate, the bus work per readout and
+		   how much faster than real time the simulation ran
+  @return  True if every scan was read out, false otherwise
+*/
+static bool benchThroughput(void)
+{
+	simResetStats();
+	const uint64_t startUs = hostGetUs();
+	const uint64_t startNs = hostGetCpuNs();
+	uint32_t numReadouts = 0;
+	uint64_t readoutCycles = 0;
+	for (uint32_t i = 0; i < THROUGHPUT_READOUTS; i++)
+	{
+		if (runBmbScanToReadout(bmb, chainNumBmbs))
+		{
+			numReadouts++;
+			readoutCycles += asciStats.lastUpdateCycles;
+		}
+	}
+	const uint64_t simUs = hostGetUs() - startUs;
+	const uint64_t hostNs = hostGetCpuNs() - startNs;
+	const uint32_t divisor = (numReadouts > 0) ? numReadouts : 1;
+
+	printf("Scan throughput - %lu BMBs, %d readouts\n", (unsigned long)chainNumBmbs[0], THROUGHPUT_READOUTS);
+	printf("  Readouts completed       %lu\n", (unsigned long)numReadouts);
+	printf("  Readouts/s               %.1f\n", (simUs > 0) ? (numReadouts * 1e6 / simUs) : 0.0);
+	printf("  Readout time (us)        %.1f\n", (double)readoutCycles / divisor / (SystemCoreClock / 1000000));
+	printf("  SPI transfers/readout    %.1f\n", (double)asciStats.numTransfers / divisor);
+	printf("  Interrupts/readout       %.1f\n", (double)asciStats.numInterrupts / divisor);
+	printf("  Task wakeups/readout     %.1f\n", (double)hostHalStats.numTaskWakeups / divisor);
+	printf("  Simulated time (ms)      %.1f\n", simUs / 1000.0);
+	printf("  Host CPU time (ms)       %.1f\n", hostNs / 1e6);
+	printf("  Speed-up vs real time    %.1fx\n\n", (hostNs > 0) ? (simUs * 1000.0 / hostNs) : 0.0);
+	return (numReadouts == THROUGHPUT_READOUTS);
+}
+
+/*!
+  @brief   Read out scans while a daisy chain hop corrupts frames and report the retries needed
+  @return  True if the link stayed usable at the lowest error rate, false otherwise
+*/
+static bool benchRetries(void)
+{
+	static const uint32_t errorPeriods[] = { 500, 100, 50, 20, 10 };
+	const uint32_t hopIdx = chainNumBmbs[0] / 2;
+	bool success = true;
+
+	printf("Retries - bit errors injected on hop %lu, %d readouts each\n", (unsigned long)hopIdx, RETRY_READOUTS);
+	printf("  1 in N frames | Readouts | Retries | CRC errors | Failures | Readout (us) | Bucket filled\n");
+	for (uint32_t p = 0; p < sizeof(errorPeriods) / sizeof(errorPeriods[0]); p++)
+	{
+		resetLeakyBucket(&asciCommsLeakyBucket);
+		simResetStats();
+		simInjectBitErrors(0, hopIdx, errorPeriods[p]);
+		uint32_t numReadouts = 0;
+		uint64_t readoutCycles = 0;
+		for (uint32_t i = 0; i < RETRY_READOUTS; i++)
+		{
+			if (runBmbScanToReadout(bmb, chainNumBmbs))
+			{
+				numReadouts++;
+				readoutCycles += asciStats.lastUpdateCycles;
+			}
+		}
+		simInjectBitErrors(0, hopIdx, 0);
+
+		uint32_t numCrcErrors = 0;
+		uint32_t numFailures = 0;
+		for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+		{
+			numCrcErrors += asciCmdStats[i].numCrcErrors;
+			numFailures += asciCmdStats[i].numFailures;
+		}
+		const bool bucketFilled = leakyBucketFilled(&asciCommsLeakyBucket);
+		printf("  %13lu | %8lu | %7lu | %10lu | %8lu | %12.1f | %s\n", (unsigned long)errorPeriods[p],
+			(unsigned long)numReadouts, (unsigned long)simCountRetries(), (unsigned long)numCrcErrors,
+			(unsigned long)numFailures, (double)readoutCycles / ((numReadouts > 0) ? numReadouts : 1) / (SystemCoreClock / 1000000),
+			bucketFilled ? "yes" : "no");
+		if (p == 0)
+		{
+			success &= (numReadouts == RETRY_READOUTS) && !bucketFilled;
+		}
+	}
+	printf("\n");
+
+	// Leave the chain the way the next scenario expects it
+	Recovery_Tier_E tier = RECOVERY_SOFT_RESYNC;
+	success &= recoverPack(&tier);
+	return success;
+}
+
+/*!
+  @brief   Run the BMS scan and alert loop until the pack is being monitored again after a fault.
+		   Recovery is started the same way the BMS starts it, once the comms leaky bucket fills
+		   or an alert poll finds a reset BMB
+  @param   repairTick - Tick at which an injected chain break is repaired. 0 if there is none
+  @param   numRecoveries - Updated with the number of recovery attempts
+  @param   tier - Updated with the recovery tier that restored communication
+  @return  The time until good brick voltages were read again in ms, -1 on timeout
+*/
+static int32_t runUntilRecovered(uint32_t repairTick, uint32_t* numRecoveries, Recovery_Tier_E* tier)
+{
+	const uint32_t startTick = HAL_GetTick();
+	uint32_t lastAlertPoll = startTick;
+	bool recoveryPending = false;
+	*numRecoveries = 0;
+	while ((HAL_GetTick() - startTick) < RECOVERY_TIMEOUT_MS)
+	{
+		if ((repairTick != 0) && (HAL_GetTick() >= repairTick))
+		{
+			simBreakHop(0, -1);
+			repairTick = 0;
+		}
+
+		if (recoveryPending)
+		{
+			(*numRecoveries)++;
+			if (recoverPack(tier))
+			{
+				recoveryPending = false;
+			}
+			else
+			{
+				osDelay(1);
+			}
+			continue;
+		}
+
+		if (runBmbScanToReadout(bmb, chainNumBmbs) && allBrickVGood())
+		{
+			return (int32_t)(HAL_GetTick() - startTick);
+		}
+		if ((HAL_GetTick() - lastAlertPoll) >= BMB_ALERT_POLL_PERIOD_MS)
+		{
+			pollBmbAlerts(bmb, chainNumBmbs);
+			lastAlertPoll = HAL_GetTick();
+		}
+
+		// Same triggers as pollPackAlerts in bms.c and runMain in mainTask.c
+		recoveryPending = bmbReinitRequired(bmb, chainNumBmbs[0]) || leakyBucketFilled(&asciCommsLeakyBucket);
+	}
+	return -1;
+}
+
+/*!
+  @brief   Print one recovery scenario
+  @param   fault - The fault that was injected
+  @param   numRecoveries - The number of recovery attempts
+  @param   tier - The recovery tier that restored communication
+  @param   blackoutMs - The time until good brick voltages were read again in ms, -1 on timeout
+*/
+static void printRecovery(const char* fault, uint32_t numRecoveries, Recovery_Tier_E tier, int32_t blackoutMs)
+{
+	printf("  %-22s | %8lu | %-11s | %13lu | %13ld\n", fault, (unsigned long)numRecoveries,
+		(numRecoveries > 0) ? recoveryTierNames[tier] : "-", (unsigned long)((numRecoveries > 0) ? recovery.stats.lastBlackoutMs[tier] : 0),
+		(long)blackoutMs);
+}
+
+/*!
+  @brief   Inject BMB power-on resets and daisy chain breaks and report how long the pack went
+		   unmonitored
+  @return  True if the pack recovered from every fault, false otherwise
+*/
+static bool benchRecovery(void)
+{
+	bool success = true;
+	memset(&recovery.stats, 0, sizeof(recovery.stats));
+
+	printf("Recovery - Recovery is the blackout the BMS records, Data is the time until good brick voltages are read again\n");
+	printf("  Fault                  | Attempts | Tier        | Recovery (ms) | Data (ms)\n");
+	for (uint32_t bmbIdx = 0; bmbIdx < chainNumBmbs[0]; bmbIdx++)
+	{
+		// Settle on good data first so the blackout only covers the fault
+		runBmbScanToReadout(bmb, chainNumBmbs);
+		simPowerOnReset(0, bmbIdx);
+		uint32_t numRecoveries = 0;
+		Recovery_Tier_E tier = RECOVERY_SOFT_RESYNC;
+		const int32_t blackoutMs = runUntilRecovered(0, &numRecoveries, &tier);
+		char fault[32];
+		snprintf(fault, sizeof(fault), "Power-on reset BMB %lu", (unsigned long)bmbIdx + 1);
+		printRecovery(fault, numRecoveries, tier, blackoutMs);
+		success &= (blackoutMs >= 0) && (numRecoveries > 0);
+	}
+
+	// The final BMB loops frames back internally so the external loopback hop is not exercised
+	for (uint32_t hopIdx = 0; hopIdx < chainNumBmbs[0]; hopIdx++)
+	{
+		runBmbScanToReadout(bmb, chainNumBmbs);
+		simBreakHop(0, (int32_t)hopIdx);
+		uint32_t numRecoveries = 0;
+		Recovery_Tier_E tier = RECOVERY_SOFT_RESYNC;
+		const int32_t blackoutMs = runUntilRecovered(HAL_GetTick() + BREAK_DURATION_MS, &numRecoveries, &tier);
+		char fault[32];
+		snprintf(fault, sizeof(fault), "%d ms break at hop %lu", BREAK_DURATION_MS, (unsigned long)hopIdx);
+		printRecovery(fault, numRecoveries, tier, blackoutMs);
+		simBreakHop(0, -1);
+		success &= (blackoutMs >= 0);
+	}
+
+	printf("  Tier        | Recoveries | Max blackout (ms)\n");
+	for (int32_t tier = 0; tier < NUM_RECOVERY_TIERS; tier++)
+	{
+		printf("  %-11s | %10lu | %17lu\n", recoveryTierNames[tier], (unsigned long)recovery.stats.numRecoveries[tier],
+			(unsigned long)recovery.stats.maxBlackoutMs[tier]);
+	}
+	printf("\n");
+	return success;
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+int main(void)
+{
+	uint32_t numBmbs = 0;
+	selectAsciChain(0);
+	if (!simInitPack(bmb, chainNumBmbs, &numBmbs))
+	{
+		printf("BMB chain failed to initialize\n");
+		return 1;
+	}
+	simPlanScans(numBmbs);
+
+	bool success = benchThroughput();
+	success &= benchRetries();
+	success &= benchRecovery();
+	return success ? 0 : 1;
+}
@@ -0,0 +1,379 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hostHal.h"
+#include "bmbInterface.h"
+#include "asciSim.h"
+#include "utils.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+#define CYCLES_PER_MS	(HOST_CORE_CLOCK_HZ / 1000)
+
+// Blocking forever is never expected from the BMB drivers. Give up on the simulation instead
+#define MAX_BLOCK_MS	60000
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DECLARATIONS ==================== */
+/* ==================================================================== */
+
+// Declared with the other interrupt handlers in stm32f4xx_it.h on the target
+void ASCI_SIM_IRQHandler(void);
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static uint64_t simCycles = 0;
+static bool simIrqPending = false;
+static bool simInIsr = false;
+
+static uint32_t taskNotifyValue = 0;
+static bool taskNotified = false;
+static uint64_t taskResumeCpuNs = 0;
+
+static uint32_t mainTaskDummy;
+
+
+/* ==================================================================== */
+/* ======================= GLOBAL VARIABLES =========================== */
+/* ==================================================================== */
+
+GPIO_TypeDef simGpioPorts[4];
+SPI_TypeDef simSpiPeripherals[4];
+DWT_Type simDwt;
+CoreDebug_Type simCoreDebug;
+uint32_t SystemCoreClock = HOST_CORE_CLOCK_HZ;
+
+SPI_HandleTypeDef hspi1 =
+{
+	.Instance = SPI1,
+	.Init = { .BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128 },
+	.State = HAL_SPI_STATE_READY
+};
+#if NUM_ASCI_CHAINS > 1
+SPI_HandleTypeDef hspi3 =
+{
+	.Instance = SPI3,
+	.Init = { .BaudRatePrescaler = SPI_BAUDRATEPRESCALER_128 },
+	.State = HAL_SPI_STATE_READY
+};
+#endif
+osThreadId mainTaskHandle = &mainTaskDummy;
+
+Host_Hal_Stats_S hostHalStats;
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Move the simulated clock forward. The DWT cycle counter follows it
+  @param   cycles - The number of core clock cycles to advance by
+*/
+static void advanceSimClock(uint64_t cycles)
+{
+	simCycles += cycles;
+	simDwt.CYCCNT = (uint32_t)simCycles;
+}
+
+/*!
+  @brief   Run the simulation interrupt if it is pending and its next event is due within a number
+		   of cycles. The clock is advanced to the event
+  @param   maxCycles - The most the clock may advance by
+  @return  True if the interrupt ran, false otherwise
+*/
+static bool runDueSimIsr(uint64_t maxCycles)
+{
+	if (!simIrqPending)
+	{
+		return false;
+	}
+
+	const uint64_t delayCycles = simPendingEventDelayCycles();
+	if (delayCycles > maxCycles)
+	{
+		return false;
+	}
+
+	advanceSimClock(delayCycles);
+	simIrqPending = false;
+	simInIsr = true;
+	ASCI_SIM_IRQHandler();
+	simInIsr = false;
+	hostHalStats.numIsrRuns++;
+	return true;
+}
+
+/*!
+  @brief   Account the host CPU time the task ran for since it last resumed
+*/
+static void taskBlocked(void)
+{
+	const uint64_t nowNs = hostGetCpuNs();
+	hostHalStats.taskCpuNs += nowNs - taskResumeCpuNs;
+}
+
+static void taskResumed(void)
+{
+	taskResumeCpuNs = hostGetCpuNs();
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+uint64_t hostGetCycles(void)
+{
+	return simCycles;
+}
+
+uint64_t hostGetUs(void)
+{
+	return simCycles / (HOST_CORE_CLOCK_HZ / 1000000);
+}
+
+uint64_t hostGetCpuNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+void hostAdvanceCycles(uint64_t cycles)
+{
+	// Interrupts that fall due while the task runs are serviced on time
+	const uint64_t endCycles = simCycles + cycles;
+	while (runDueSimIsr(endCycles - simCycles))
+	{
+	}
+	advanceSimClock(endCycles - simCycles);
+}
+
+void hostResetStats(void)
+{
+	hostHalStats = (Host_Hal_Stats_S){ 0 };
+	taskResumed();
+}
+
+void Error_Handler(void)
+{
+	fprintf(stderr, "Error_Handler called\n");
+	abort();
+}
+
+// ----------------------------- HAL ---------------------------------
+
+uint32_t HAL_GetTick(void)
+{
+	return (uint32_t)(simCycles / CYCLES_PER_MS);
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+	if (PinState == GPIO_PIN_SET)
+	{
+		GPIOx->ODR |= GPIO_Pin;
+	}
+	else
+	{
+		GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+	}
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+	(void)IRQn; (void)PreemptPriority; (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	(void)IRQn;
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+	if (IRQn == ASCI_SIM_IRQn)
+	{
+		simIrqPending = true;
+	}
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+	return HOST_PCLK1_HZ;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+	return HOST_PCLK2_HZ;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_IT(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size)
+{
+	return simAsciTransmit(hspi, pData, NULL, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size)
+{
+	return simAsciTransmit(hspi, pTxData, pRxData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size)
+{
+	return simAsciTransmit(hspi, pTxData, pRxData, Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef* hspi)
+{
+	return simAsciAbort(hspi);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort_IT(SPI_HandleTypeDef* hspi)
+{
+	return simAsciAbort(hspi);
+}
+
+// The ASCI part of the callbacks in main.c
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+	if (isAsciSpi(hspi))
+	{
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi)
+{
+	if (isAsciSpi(hspi))
+	{
+		if (asciSpiCompleteCallback(hspi)) { return; }
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi)
+{
+	if (isAsciSpi(hspi))
+	{
+		if (asciSpiErrorCallback(hspi)) { return; }
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_ERROR, eSetBits, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
+
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if (isAsciInterruptPin(GPIO_Pin))
+	{
+		if (asciInterruptCallback(GPIO_Pin)) { return; }
+		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+		xTaskNotifyFromISR(mainTaskHandle, INTERRUPT_SUCCESS, eSetBits, &xHigherPriorityTaskWoken);
+		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+	}
+}
+
+// ---------------------------- FreeRTOS ------------------------------
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t* pulNotificationValue, TickType_t xTicksToWait)
+{
+	taskBlocked();
+	if (!taskNotified)
+	{
+		taskNotifyValue &= ~ulBitsToClearOnEntry;
+	}
+
+	const uint64_t startCycles = simCycles;
+	const uint64_t waitMs = (xTicksToWait > MAX_BLOCK_MS) ? MAX_BLOCK_MS : xTicksToWait;
+	const uint64_t deadline = simCycles + (waitMs * CYCLES_PER_MS);
+	while (!taskNotified)
+	{
+		if (!runDueSimIsr(deadline - simCycles))
+		{
+			// Nothing left to wake the task before the timeout
+			advanceSimClock(deadline - simCycles);
+			break;
+		}
+	}
+
+	if (pulNotificationValue != NULL)
+	{
+		*pulNotificationValue = taskNotifyValue;
+	}
+
+	hostHalStats.blockedCycles += simCycles - startCycles;
+	BaseType_t result = pdFALSE;
+	if (taskNotified)
+	{
+		taskNotifyValue &= ~ulBitsToClearOnExit;
+		taskNotified = false;
+		hostHalStats.numTaskWakeups++;
+		result = pdTRUE;
+	}
+	else
+	{
+		hostHalStats.numTaskTimeouts++;
+	}
+	taskResumed();
+	return result;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t* pxHigherPriorityTaskWoken)
+{
+	(void)xTaskToNotify;
+	if (eAction == eSetBits)
+	{
+		taskNotifyValue |= ulValue;
+	}
+	else
+	{
+		taskNotifyValue = ulValue;
+	}
+	taskNotified = true;
+	if (pxHigherPriorityTaskWoken != NULL)
+	{
+		*pxHigherPriorityTaskWoken = pdTRUE;
+	}
+	return pdPASS;
+}
+
+BaseType_t xPortIsInsideInterrupt(void)
+{
+	return simInIsr ? pdTRUE : pdFALSE;
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+	taskBlocked();
+	const uint64_t delayCycles = (uint64_t)xTicksToDelay * CYCLES_PER_MS;
+	const uint64_t wakeCycles = simCycles + delayCycles;
+	while (runDueSimIsr(wakeCycles - simCycles))
+	{
+	}
+	advanceSimClock(wakeCycles - simCycles);
+	hostHalStats.blockedCycles += delayCycles;
+	taskResumed();
+}
+
+osStatus osDelay(uint32_t millisec)
+{
+	vTaskDelay(millisec);
+	return osOK;
+}
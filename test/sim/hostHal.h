@@ -0,0 +1,79 @@
+#ifndef SIM_HOSTHAL_H_
+#define SIM_HOSTHAL_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"
+#include "cmsis_os.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Core clock of the STM32F446 as configured by SystemClock_Config
+#define HOST_CORE_CLOCK_HZ		180000000UL
+#define HOST_PCLK1_HZ			45000000UL
+#define HOST_PCLK2_HZ			90000000UL
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	uint32_t numTaskWakeups;	// xTaskNotifyWait calls that returned with a notification
+	uint32_t numTaskTimeouts;	// xTaskNotifyWait calls that timed out
+	uint32_t numIsrRuns;		// Simulation interrupts serviced
+	uint64_t blockedCycles;		// Simulated cycles the task spent blocked
+	uint64_t taskCpuNs;			// Host CPU time spent running firmware between blocking calls
+} Host_Hal_Stats_S;
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern Host_Hal_Stats_S hostHalStats;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Get the simulated time since start up
+  @return  The number of core clock cycles
+*/
+uint64_t hostGetCycles(void);
+
+/*!
+  @brief   Get the simulated time since start up
+  @return  The time in us
+*/
+uint64_t hostGetUs(void);
+
+/*!
+  @brief   Get the host CPU time used by the process
+  @return  The time in ns
+*/
+uint64_t hostGetCpuNs(void);
+
+/*!
+  @brief   Charge simulated CPU time to the task. The simulated clock otherwise only moves while
+		   the task is blocked
+  @param   cycles - The number of core clock cycles the task ran for
+*/
+void hostAdvanceCycles(uint64_t cycles);
+
+/*!
+  @brief   Clear the host HAL statistics
+*/
+void hostResetStats(void);
+
+#endif /* SIM_HOSTHAL_H_ */
@@ -0,0 +1,363 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simHarness.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Longest capture that can be replayed
+#define REPLAY_MAX_FRAMES		8192
+
+// Captured RX frames start with the echo of the read command. See captureAsciFrame
+#define REPLAY_ECHO_LENGTH		1
+
+// Readouts run before and while the self test captures frames
+#define SELF_TEST_SETTLE_READOUTS	2
+#define SELF_TEST_READOUTS			20
+
+// Replay stops after this many readouts in a row with no captured frame left to replay
+#define REPLAY_IDLE_READOUTS		2
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	float minBrickV;
+	float maxBrickV;
+	float avgBrickV;
+	float maxBrickTemp;
+	float maxBoardTemp;
+} Pack_Summary_S;
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern Asci_Frame_Capture_S asciCapture;
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+static Bmb_S bmb[SIM_MAX_BMBS];
+static const uint32_t chainNumBmbs[NUM_ASCI_CHAINS] = ASCI_CHAIN_NUM_BMBS;
+
+static Asci_Frame_S replayFrames[REPLAY_MAX_FRAMES];
+static uint32_t numReplayFrames;
+
+// Next captured frame to look at for each register, so every register replays its frames in order
+static uint32_t replayCursor[0x100];
+static uint32_t numFramesReplayed;
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Read a capture dumped by printAsciCapture. Lines that are not frames are skipped, so a
+		   whole debug UART log can be replayed
+  @param   file - The capture
+  @return  The number of frames read
+*/
+static uint32_t readCapture(FILE* file)
+{
+	char line[16 + (3 * SPI_BUFF_SIZE) + 8];
+	numReplayFrames = 0;
+	while ((numReplayFrames < REPLAY_MAX_FRAMES) && (fgets(line, sizeof(line), file) != NULL))
+	{
+		unsigned long timestampMs = 0;
+		char direction[3] = { 0 };
+		int numChars = 0;
+		if (sscanf(line, "CAP %lu %2s%n", &timestampMs, direction, &numChars) != 2)
+		{
+			continue;
+		}
+
+		Asci_Frame_S* frame = &replayFrames[numReplayFrames];
+		frame->timestampMs = timestampMs;
+		frame->direction = (strcmp(direction, "TX") == 0) ? ASCI_FRAME_TX : ASCI_FRAME_RX;
+		frame->length = 0;
+		char* hex = &line[numChars];
+		char* end = NULL;
+		for (unsigned long byte = strtoul(hex, &end, 16); (end != hex) && (frame->length < SPI_BUFF_SIZE); byte = strtoul(hex, &end, 16))
+		{
+			frame->data[frame->length++] = (uint8_t)byte;
+			hex = end;
+		}
+		numReplayFrames++;
+	}
+	return numReplayFrames;
+}
+
+/*!
+  @brief   Write the frame capture ring buffer in the format of printAsciCapture
+  @param   file - The file to write to
+*/
+static void writeCapture(FILE* file)
+{
+	const uint32_t oldest = (asciCapture.head + ASCI_CAPTURE_NUM_FRAMES - asciCapture.numFrames) % ASCI_CAPTURE_NUM_FRAMES;
+	fprintf(file, "ASCI capture: %lu frames, %lu dropped\n", (unsigned long)asciCapture.numFrames, (unsigned long)asciCapture.numDropped);
+	for (uint32_t i = 0; i < asciCapture.numFrames; i++)
+	{
+		const Asci_Frame_S* frame = &asciCapture.frames[(oldest + i) % ASCI_CAPTURE_NUM_FRAMES];
+		fprintf(file, "CAP %lu %s", (unsigned long)frame->timestampMs, (frame->direction == ASCI_FRAME_TX) ? "TX" : "RX");
+		for (uint32_t j = 0; j < frame->length; j++)
+		{
+			fprintf(file, " %02X", frame->data[j]);
+		}
+		fprintf(file, "\n");
+	}
+}
+
+/*!
+  @brief   Replace a readAll response returning to the simulated ASCI with the next captured
+		   response of the same register. The model response is kept once a register has no
+		   captured frames left
+*/
+static void replayReturnFrame(uint32_t chainIdx, uint8_t* frame, uint32_t* length)
+{
+	if ((chainIdx != 0) || (frame[0] != CMD_READ_ALL))
+	{
+		return;
+	}
+
+	const uint8_t address = frame[1];
+	for (uint32_t i = replayCursor[address]; i < numReplayFrames; i++)
+	{
+		const Asci_Frame_S* captured = &replayFrames[i];
+		const uint8_t* capturedFrame = &captured->data[REPLAY_ECHO_LENGTH];
+		if ((captured->direction == ASCI_FRAME_RX) && (captured->length == *length + REPLAY_ECHO_LENGTH) &&
+			(capturedFrame[0] == CMD_READ_ALL) && (capturedFrame[1] == address))
+		{
+			memcpy(frame, capturedFrame, *length);
+			replayCursor[address] = i + 1;
+			numFramesReplayed++;
+			return;
+		}
+	}
+	replayCursor[address] = numReplayFrames;
+}
+
+/*!
+  @brief   Aggregate the BMB data and summarize the pack
+  @param   summary - Updated with the pack summary
+  @param   numBmbs - The number of BMBs in the pack
+*/
+static void summarizePack(Pack_Summary_S* summary, uint32_t numBmbs)
+{
+	aggregateBmbData(bmb, numBmbs);
+	summary->minBrickV = bmb[0].minBrickV;
+	summary->maxBrickV = bmb[0].maxBrickV;
+	summary->maxBrickTemp = bmb[0].maxBrickTemp;
+	summary->maxBoardTemp = bmb[0].maxBoardTemp;
+	float brickVSum = 0.0f;
+	for (uint32_t i = 0; i < numBmbs; i++)
+	{
+		summary->minBrickV = (bmb[i].minBrickV < summary->minBrickV) ? bmb[i].minBrickV : summary->minBrickV;
+		summary->maxBrickV = (bmb[i].maxBrickV > summary->maxBrickV) ? bmb[i].maxBrickV : summary->maxBrickV;
+		summary->maxBrickTemp = (bmb[i].maxBrickTemp > summary->maxBrickTemp) ? bmb[i].maxBrickTemp : summary->maxBrickTemp;
+		summary->maxBoardTemp = (bmb[i].maxBoardTemp > summary->maxBoardTemp) ? bmb[i].maxBoardTemp : summary->maxBoardTemp;
+		brickVSum += bmb[i].avgBrickV;
+	}
+	summary->avgBrickV = brickVSum / numBmbs;
+}
+
+/*!
+  @brief   Feed the captured frames through the BMS scan loop until none are left
+  @param   numBmbs - The number of BMBs in the pack
+  @param   summary - Updated with the pack summary after the last replayed readout
+  @return  The number of readouts replayed
+*/
+static uint32_t replayCapture(uint32_t numBmbs, Pack_Summary_S* summary)
+{
+	// Temperatures are read through the BMB mux channel the scan schedule selects, so they only
+	// decode correctly if the capture also started at the beginning of the schedule
+	simPlanScans(numBmbs);
+	memset(replayCursor, 0, sizeof(replayCursor));
+	numFramesReplayed = 0;
+	simSetReturnFrameHook(replayReturnFrame);
+
+	uint32_t numReadouts = 0;
+	uint32_t numIdleReadouts = 0;
+	while (numIdleReadouts < REPLAY_IDLE_READOUTS)
+	{
+		const uint32_t numFramesBefore = numFramesReplayed;
+		const bool readOut = runBmbScanToReadout(bmb, chainNumBmbs);
+		if (numFramesReplayed == numFramesBefore)
+		{
+			numIdleReadouts++;
+			continue;
+		}
+		numIdleReadouts = 0;
+		numReadouts++;
+
+		Pack_Summary_S readout;
+		summarizePack(&readout, numBmbs);
+		if (readOut)
+		{
+			*summary = readout;
+		}
+		printf("  %7lu | %6lu | %s | %6.3f | %6.3f | %6.3f | %7.1f | %7.1f\n", (unsigned long)numReadouts, (unsigned long)numFramesReplayed,
+			readOut ? "ok     " : "timeout", readout.minBrickV, readout.maxBrickV, readout.avgBrickV, readout.maxBrickTemp, readout.maxBoardTemp);
+	}
+
+	simSetReturnFrameHook(NULL);
+	return numReadouts;
+}
+
+/*!
+  @brief   Replay a capture and report the readouts decoded from it
+  @param   numBmbs - The number of BMBs in the pack
+  @param   summary - Updated with the pack summary after the last replayed readout
+  @return  True if any frames were replayed, false otherwise
+*/
+static bool runReplay(uint32_t numBmbs, Pack_Summary_S* summary)
+{
+	uint32_t numReadAllFrames = 0;
+	for (uint32_t i = 0; i < numReplayFrames; i++)
+	{
+		const Asci_Frame_S* frame = &replayFrames[i];
+		numReadAllFrames += ((frame->direction == ASCI_FRAME_RX) && (frame->data[REPLAY_ECHO_LENGTH] == CMD_READ_ALL)) ? 1 : 0;
+	}
+	const uint32_t captureMs = (numReplayFrames > 0) ? (replayFrames[numReplayFrames - 1].timestampMs - replayFrames[0].timestampMs) : 0;
+
+	printf("Replay - %lu BMBs, %lu frames, %lu readAll responses, %lu ms captured\n", (unsigned long)numBmbs,
+		(unsigned long)numReplayFrames, (unsigned long)numReadAllFrames, (unsigned long)captureMs);
+	printf("  Readout | Frames | Result  | Min V  | Max V  | Avg V  | Brick C | Board C\n");
+	const uint64_t startNs = hostGetCpuNs();
+	const uint32_t numReadouts = replayCapture(numBmbs, summary);
+	const double hostMs = (double)(hostGetCpuNs() - startNs) / 1000000.0;
+
+	printf("%lu of %lu readAll responses replayed in %lu readouts, %.1f ms host time (%.0fx real time)\n\n", (unsigned long)numFramesReplayed,
+		(unsigned long)numReadAllFrames, (unsigned long)numReadouts, hostMs, (hostMs > 0.0) ? captureMs / hostMs : 0.0);
+	return (numFramesReplayed > 0);
+}
+
+/*!
+  @brief   Capture frames from a pack set up with distinct brick voltages, change the pack, then
+		   check that replaying the capture decodes the original pack
+  @param   numBmbs - The number of BMBs in the pack
+  @return  True if the replayed readouts match the captured pack, false otherwise
+*/
+static bool runSelfTest(uint32_t numBmbs)
+{
+	for (uint32_t i = 0; i < numBmbs; i++)
+	{
+		for (uint32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			simSetBrickVoltage(0, i, j, 3.2f + 0.005f * (i * NUM_BRICKS_PER_BMB + j));
+			simSetBrickTemp(0, i, j, 20.0f + 0.25f * (i * NUM_BRICKS_PER_BMB + j));
+		}
+		for (uint32_t j = 0; j < NUM_BOARD_TEMP_PER_BMB; j++)
+		{
+			simSetBoardTemp(0, i, j, 25.0f + i + j);
+		}
+	}
+	for (uint32_t i = 0; i < SELF_TEST_SETTLE_READOUTS; i++)
+	{
+		runBmbScanToReadout(bmb, chainNumBmbs);
+	}
+
+	Pack_Summary_S captured;
+	simPlanScans(numBmbs);
+	setAsciFrameCapture(true);
+	for (uint32_t i = 0; i < SELF_TEST_READOUTS; i++)
+	{
+		runBmbScanToReadout(bmb, chainNumBmbs);
+	}
+	setAsciFrameCapture(false);
+	summarizePack(&captured, numBmbs);
+
+	// Round trip the capture through the dump format
+	FILE* file = tmpfile();
+	if (file == NULL)
+	{
+		printf("Failed to create the capture file\n");
+		return false;
+	}
+	writeCapture(file);
+	rewind(file);
+	readCapture(file);
+	fclose(file);
+
+	// Move the pack away from the captured one so only replayed frames can decode it
+	for (uint32_t i = 0; i < numBmbs; i++)
+	{
+		for (uint32_t j = 0; j < NUM_BRICKS_PER_BMB; j++)
+		{
+			simSetBrickVoltage(0, i, j, 3.7f);
+			simSetBrickTemp(0, i, j, 25.0f);
+		}
+		for (uint32_t j = 0; j < NUM_BOARD_TEMP_PER_BMB; j++)
+		{
+			simSetBoardTemp(0, i, j, 30.0f);
+		}
+	}
+	for (uint32_t i = 0; i < SELF_TEST_SETTLE_READOUTS; i++)
+	{
+		runBmbScanToReadout(bmb, chainNumBmbs);
+	}
+
+	Pack_Summary_S replayed = { 0 };
+	if (!runReplay(numBmbs, &replayed))
+	{
+		return false;
+	}
+
+	printf("Self test - captured pack %.3f to %.3f V, %.1f C max, replayed pack %.3f to %.3f V, %.1f C max\n", captured.minBrickV,
+		captured.maxBrickV, captured.maxBrickTemp, replayed.minBrickV, replayed.maxBrickV, replayed.maxBrickTemp);
+	return (asciCapture.numDropped == 0) && (replayed.minBrickV == captured.minBrickV) && (replayed.maxBrickV == captured.maxBrickV) &&
+		   (replayed.avgBrickV == captured.avgBrickV) && (replayed.maxBrickTemp == captured.maxBrickTemp) &&
+		   (replayed.maxBoardTemp == captured.maxBoardTemp);
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Feed frames captured with ASCI_FRAME_CAPTURE through the BMS scan loop on the simulator.
+		   The captured readAll responses replace the responses of the model register by register.
+		   With no capture file a capture is taken from the simulator and replayed as a self test
+*/
+int main(int argc, char** argv)
+{
+	uint32_t numBmbs = 0;
+	selectAsciChain(0);
+	if (!simInitPack(bmb, chainNumBmbs, &numBmbs))
+	{
+		printf("BMB chain failed to initialize\n");
+		return 1;
+	}
+	simPlanScans(numBmbs);
+
+	if (argc < 2)
+	{
+		return runSelfTest(numBmbs) ? 0 : 1;
+	}
+
+	FILE* file = fopen(argv[1], "r");
+	if (file == NULL)
+	{
+		printf("Failed to open %s\n", argv[1]);
+		return 1;
+	}
+	readCapture(file);
+	fclose(file);
+	Pack_Summary_S summary;
+	return runReplay(numBmbs, &summary) ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#ifndef SIM_CMSIS_OS_H_
+#define SIM_CMSIS_OS_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Only the parts of FreeRTOS and CMSIS-RTOS used by the BMB drivers are provided. There is a
+// single task. Blocking calls advance the simulated clock in hostHal.c and run the simulation
+// interrupt whenever a bus event falls due
+
+#define pdFALSE			((BaseType_t)0)
+#define pdTRUE			((BaseType_t)1)
+#define pdPASS			pdTRUE
+#define pdFAIL			pdFALSE
+#define portMAX_DELAY	((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ	((TickType_t)1000)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(xTimeInMs))
+
+#define portYIELD_FROM_ISR(x)			((void)(x))
+#define taskENTER_CRITICAL()			do { } while (0)
+#define taskEXIT_CRITICAL()				do { } while (0)
+#define taskENTER_CRITICAL_FROM_ISR()	((UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)	((void)(x))
+
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+typedef enum
+{
+	eNoAction = 0,
+	eSetBits,
+	eIncrement,
+	eSetValueWithOverwrite,
+	eSetValueWithoutOverwrite
+} eNotifyAction;
+
+typedef enum
+{
+	osOK = 0,
+	osErrorOS = 0xFF
+} osStatus;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef void* TaskHandle_t;
+typedef TaskHandle_t osThreadId;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t* pulNotificationValue, TickType_t xTicksToWait);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t* pxHigherPriorityTaskWoken);
+BaseType_t xPortIsInsideInterrupt(void);
+void vTaskDelay(TickType_t xTicksToDelay);
+osStatus osDelay(uint32_t millisec);
+
+#endif /* SIM_CMSIS_OS_H_ */
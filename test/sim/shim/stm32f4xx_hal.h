@@ -0,0 +1,186 @@
+#ifndef SIM_STM32F4XX_HAL_H_
+#define SIM_STM32F4XX_HAL_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Only the parts of the STM32F4 HAL and CMSIS used by the BMB drivers are provided. Peripherals
+// are plain host variables and the DWT cycle counter follows the simulated clock in hostHal.c
+
+#define __IO volatile
+#define __ALIGNED(x) __attribute__((aligned(x)))
+#define __CLZ(x) (((x) == 0) ? 32U : (uint32_t)__builtin_clz(x))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) ((REG) = (((REG) & (~(CLEARMASK))) | (SETMASK)))
+
+#define GPIO_PIN_0		((uint16_t)0x0001)
+#define GPIO_PIN_1		((uint16_t)0x0002)
+#define GPIO_PIN_2		((uint16_t)0x0004)
+#define GPIO_PIN_3		((uint16_t)0x0008)
+#define GPIO_PIN_4		((uint16_t)0x0010)
+#define GPIO_PIN_5		((uint16_t)0x0020)
+#define GPIO_PIN_6		((uint16_t)0x0040)
+#define GPIO_PIN_7		((uint16_t)0x0080)
+#define GPIO_PIN_8		((uint16_t)0x0100)
+#define GPIO_PIN_9		((uint16_t)0x0200)
+#define GPIO_PIN_10		((uint16_t)0x0400)
+#define GPIO_PIN_11		((uint16_t)0x0800)
+#define GPIO_PIN_12		((uint16_t)0x1000)
+#define GPIO_PIN_13		((uint16_t)0x2000)
+#define GPIO_PIN_14		((uint16_t)0x4000)
+#define GPIO_PIN_15		((uint16_t)0x8000)
+
+#define GPIOA			(&simGpioPorts[0])
+#define GPIOB			(&simGpioPorts[1])
+#define GPIOC			(&simGpioPorts[2])
+#define GPIOD			(&simGpioPorts[3])
+
+#define SPI1			(&simSpiPeripherals[0])
+#define SPI2			(&simSpiPeripherals[1])
+#define SPI3			(&simSpiPeripherals[2])
+#define SPI4			(&simSpiPeripherals[3])
+
+#define SPI_CR1_SPE_Pos				(6U)
+#define SPI_CR1_SPE					(0x1UL << SPI_CR1_SPE_Pos)
+#define SPI_CR1_BR_Pos				(3U)
+#define SPI_CR1_BR					(0x7UL << SPI_CR1_BR_Pos)
+#define SPI_BAUDRATEPRESCALER_2		(0x00000000U)
+#define SPI_BAUDRATEPRESCALER_4		(0x00000008U)
+#define SPI_BAUDRATEPRESCALER_8		(0x00000010U)
+#define SPI_BAUDRATEPRESCALER_16	(0x00000018U)
+#define SPI_BAUDRATEPRESCALER_32	(0x00000020U)
+#define SPI_BAUDRATEPRESCALER_64	(0x00000028U)
+#define SPI_BAUDRATEPRESCALER_128	(0x00000030U)
+#define SPI_BAUDRATEPRESCALER_256	(0x00000038U)
+#define __HAL_SPI_DISABLE(__HANDLE__) ((__HANDLE__)->Instance->CR1 &= (~SPI_CR1_SPE))
+
+// Pins of the second ASCI. CubeMX adds these to main.h once the second chain is set up on the target
+#define CS_ASCI2_Pin		GPIO_PIN_15
+#define CS_ASCI2_GPIO_Port	GPIOA
+#define SHDN2_Pin			GPIO_PIN_8
+#define SHDN2_GPIO_Port		GPIOC
+#define INT2_Pin			GPIO_PIN_9
+#define INT2_GPIO_Port		GPIOC
+
+#define DWT_CTRL_CYCCNTENA_Msk			(0x1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk		(0x1UL << 24U)
+#define DWT							(&simDwt)
+#define CoreDebug					(&simCoreDebug)
+
+
+/* ==================================================================== */
+/* ========================= ENUMERATED TYPES========================== */
+/* ==================================================================== */
+
+typedef enum
+{
+	HAL_OK = 0x00U,
+	HAL_ERROR = 0x01U,
+	HAL_BUSY = 0x02U,
+	HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+	GPIO_PIN_RESET = 0,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef enum
+{
+	HAL_SPI_STATE_RESET = 0x00U,
+	HAL_SPI_STATE_READY = 0x01U,
+	HAL_SPI_STATE_BUSY = 0x02U
+} HAL_SPI_StateTypeDef;
+
+typedef enum
+{
+	EXTI9_5_IRQn = 23,
+	SPDIF_RX_IRQn = 94
+} IRQn_Type;
+
+
+/* ==================================================================== */
+/* ============================== STRUCTS============================== */
+/* ==================================================================== */
+
+typedef struct
+{
+	uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+	__IO uint32_t CR1;
+} SPI_TypeDef;
+
+typedef struct
+{
+	uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct
+{
+	SPI_TypeDef* Instance;
+	SPI_InitTypeDef Init;
+	__IO HAL_SPI_StateTypeDef State;
+} SPI_HandleTypeDef;
+
+typedef struct
+{
+	uint32_t State;
+} CAN_HandleTypeDef;
+
+typedef struct
+{
+	__IO uint32_t CTRL;
+	__IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+	__IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern GPIO_TypeDef simGpioPorts[4];
+extern SPI_TypeDef simSpiPeripherals[4];
+extern DWT_Type simDwt;
+extern CoreDebug_Type simCoreDebug;
+extern uint32_t SystemCoreClock;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+uint32_t HAL_GetTick(void);
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_RCC_GetPCLK2Freq(void);
+HAL_StatusTypeDef HAL_SPI_Transmit_IT(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_IT(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive_DMA(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size);
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef* hspi);
+HAL_StatusTypeDef HAL_SPI_Abort_IT(SPI_HandleTypeDef* hspi);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi);
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef* hspi);
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef* hspi);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+#endif /* SIM_STM32F4XX_HAL_H_ */
@@ -0,0 +1,86 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <string.h>
+#include "simHarness.h"
+
+
+/* ==================================================================== */
+/* ========================= LOCAL VARIABLES ========================== */
+/* ==================================================================== */
+
+// Target data rates of the BMS. See bms.c
+static const uint32_t scanPeriodMs[NUM_SCAN_PRODUCTS] =
+{
+	SCAN_CELL_V_PERIOD_MS, SCAN_CELL_EXTREMES_PERIOD_MS, SCAN_SEGMENT_V_PERIOD_MS, SCAN_BRICK_TEMP_PERIOD_MS, SCAN_BOARD_TEMP_PERIOD_MS, SCAN_DIAGNOSTICS_PERIOD_MS
+};
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Initialize the BMBs on every daisy chain with the start up steps of the BMS. See
+		   initBmbChains in bmsRecovery.c
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @return  True if initialization successful, false otherwise
+*/
+bool simInitPack(Bmb_S* bmb, const uint32_t* chainNumBmbs, uint32_t* numBmbs)
+{
+	uint32_t foundChainNumBmbs[NUM_ASCI_CHAINS];
+	return initBmbChains(chainNumBmbs, bmb, foundChainNumBmbs, numBmbs);
+}
+
+/*!
+  @brief   Plan the BMB scans for the target data rates of the BMS
+  @param   numBmbs - The number of BMBs on the longest daisy chain
+*/
+void simPlanScans(uint32_t numBmbs)
+{
+	selectAsciChain(0);
+	planBmbScans(scanPeriodMs, numBmbs);
+}
+
+/*!
+  @brief   Count every retry of an ASCI command
+  @return  The total number of retries
+*/
+uint32_t simCountRetries(void)
+{
+	uint32_t numRetries = 0;
+	for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+	{
+		numRetries += asciCmdStats[i].numRetries;
+	}
+	return numRetries;
+}
+
+/*!
+  @brief   Count every frame error, timeout and failed command seen on the ASCI link
+  @return  The total number of errors
+*/
+uint32_t simCountLinkErrors(void)
+{
+	uint32_t numErrors = 0;
+	for (int32_t i = 0; i < NUM_ASCI_CMD_TYPES; i++)
+	{
+		numErrors += asciCmdStats[i].numCrcErrors + asciCmdStats[i].numAliveCounterErrors +
+					 asciCmdStats[i].numTimeouts + asciCmdStats[i].numFailures;
+	}
+	return numErrors;
+}
+
+/*!
+  @brief   Clear the ASCI, simulation and host statistics
+*/
+void simResetStats(void)
+{
+	memset(&asciStats, 0, sizeof(asciStats));
+	memset(asciCmdStats, 0, sizeof(asciCmdStats));
+	memset(&asciSimStats, 0, sizeof(asciSimStats));
+	hostResetStats();
+}
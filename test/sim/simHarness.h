@@ -0,0 +1,72 @@
+#ifndef SIM_SIMHARNESS_H_
+#define SIM_SIMHARNESS_H_
+
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bms.h"
+#include "bmb.h"
+#include "bmbInterface.h"
+#include "bmsRecovery.h"
+#include "asciSim.h"
+#include "hostHal.h"
+
+
+/* ==================================================================== */
+/* ============================= DEFINES ============================== */
+/* ==================================================================== */
+
+// Longest simulated pack. Every chain at the longest length
+#define SIM_MAX_BMBS	(MAX_BMBS_PER_CHAIN * NUM_ASCI_CHAINS)
+
+
+/* ==================================================================== */
+/* ======================= EXTERNAL VARIABLES ========================= */
+/* ==================================================================== */
+
+extern Asci_Stats_S asciStats;
+extern Asci_Cmd_Stats_S asciCmdStats[NUM_ASCI_CMD_TYPES];
+extern Asci_Sim_Stats_S asciSimStats;
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DECLARATIONS =================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Initialize the BMBs on every daisy chain with the start up steps of the BMS. See
+		   initBmbChains in bmsRecovery.c
+  @param   bmb - BMB array data. The BMBs of each chain follow those of the previous chain
+  @param   chainNumBmbs - The expected number of BMBs on each daisy chain
+  @param   numBmbs - Updated with the number of BMBs found on all daisy chains
+  @return  True if initialization successful, false otherwise
+*/
+bool simInitPack(Bmb_S* bmb, const uint32_t* chainNumBmbs, uint32_t* numBmbs);
+
+/*!
+  @brief   Plan the BMB scans for the target data rates of the BMS
+  @param   numBmbs - The number of BMBs on the longest daisy chain
+*/
+void simPlanScans(uint32_t numBmbs);
+
+/*!
+  @brief   Count every retry of an ASCI command
+  @return  The total number of retries
+*/
+uint32_t simCountRetries(void);
+
+/*!
+  @brief   Count every frame error, timeout and failed command seen on the ASCI link
+  @return  The total number of errors
+*/
+uint32_t simCountLinkErrors(void);
+
+/*!
+  @brief   Clear the ASCI, simulation and host statistics
+*/
+void simResetStats(void);
+
+#endif /* SIM_SIMHARNESS_H_ */
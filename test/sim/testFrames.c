@@ -0,0 +1,174 @@
+/* ==================================================================== */
+/* ============================= INCLUDES ============================= */
+/* ==================================================================== */
+
+#include <stdio.h>
+
+// Included rather than linked so the static frame builders can be called directly
+#include "bmbInterface.c"
+
+
+/* ==================================================================== */
+/* =================== LOCAL FUNCTION DEFINITIONS ===================== */
+/* ==================================================================== */
+
+/*!
+  @brief   The bitwise CRC of the blocking driver. See baseline/blockingInterface.c
+*/
+static uint8_t referenceCrc(uint8_t* byteArr, uint32_t numBytes)
+{
+	uint8_t crc = 0x00;
+	const uint8_t poly = 0xB2;
+	for (uint32_t i = 0; i < numBytes; i++)
+	{
+		crc = crc ^ byteArr[i];
+		for (int32_t j = 0; j < 8; j++)
+		{
+			if (crc & 0x01)
+			{
+				crc = ((crc >> 1) ^ poly);
+			}
+			else
+			{
+				crc = (crc >> 1);
+			}
+		}
+	}
+	return crc;
+}
+
+/*!
+  @brief   Build a readAll frame the way the blocking driver's readAll did
+  @return  The number of bytes in the frame
+*/
+static uint32_t referenceReadAllFrame(uint8_t* sendBuffer, uint8_t address, uint32_t numBmbs)
+{
+	const uint32_t bmbCmdLength = 0x05;
+	const uint32_t asciCmdLength = 0x02;
+	const uint32_t numBytesToSend = bmbCmdLength + asciCmdLength;
+	const uint32_t numBytesToReceive = bmbCmdLength + numBmbs * BYTES_PER_BMB_REGISTER;
+	memset(sendBuffer, 0, numBytesToSend * sizeof(uint8_t));
+
+	uint8_t* asciCmdBuffer = sendBuffer;
+	uint8_t* bmbCmdBuffer  = &sendBuffer[asciCmdLength];
+	asciCmdBuffer[0] = CMD_WR_LD_Q_L0;
+	asciCmdBuffer[1] = numBytesToReceive;
+	bmbCmdBuffer[0] = CMD_READ_ALL;
+	bmbCmdBuffer[1] = address;
+	bmbCmdBuffer[2] = 0x00;
+	bmbCmdBuffer[3] = referenceCrc(bmbCmdBuffer, bmbCmdLength - 2);
+	bmbCmdBuffer[4] = 0x00;
+	return numBytesToSend;
+}
+
+/*!
+  @brief   Build a writeAll frame the way the blocking driver's writeAll did
+  @return  The number of bytes in the frame
+*/
+static uint32_t referenceWriteAllFrame(uint8_t* sendBuffer, uint8_t address, uint16_t value)
+{
+	const uint32_t bmbCmdLength = 0x06;
+	const uint32_t asciCmdLength = 0x02;
+	const uint32_t numBytesToSend = bmbCmdLength + asciCmdLength;
+	memset(sendBuffer, 0, numBytesToSend * sizeof(uint8_t));
+
+	uint8_t* asciCmdBuffer = sendBuffer;
+	uint8_t* bmbCmdBuffer  = &sendBuffer[asciCmdLength];
+	asciCmdBuffer[0] = CMD_WR_LD_Q_L0;
+	asciCmdBuffer[1] = bmbCmdLength;
+	bmbCmdBuffer[0] = CMD_WRITE_ALL;
+	bmbCmdBuffer[1] = address;
+	bmbCmdBuffer[2] = (uint8_t)(value & 0x00FF);
+	bmbCmdBuffer[3] = (uint8_t)(value >> 8);
+	bmbCmdBuffer[4] = referenceCrc(bmbCmdBuffer, bmbCmdLength - 2);
+	bmbCmdBuffer[5] = 0x00;
+	return numBytesToSend;
+}
+
+/*!
+  @brief   Compare every readAll frame for every chain length against the reference builder
+  @return  The number of mismatched frames
+*/
+static uint32_t checkReadAllFrames(void)
+{
+	uint32_t numMismatches = 0;
+	Asci_Chain_S chain = { 0 };
+	for (uint32_t numBmbs = 1; numBmbs <= MAX_BMBS_PER_CHAIN; numBmbs++)
+	{
+		for (uint32_t address = 0; address <= 0xFF; address++)
+		{
+			uint8_t expected[MAX_ASCI_CMD_LENGTH];
+			uint8_t frameBuffer[MAX_ASCI_CMD_LENGTH];
+			uint32_t numBytes = 0;
+			const uint32_t expectedBytes = referenceReadAllFrame(expected, address, numBmbs);
+			const uint8_t* frame = getReadAllFrame(&chain, address, numBmbs, frameBuffer, &numBytes);
+			if ((numBytes != expectedBytes) || (memcmp(frame, expected, expectedBytes) != 0))
+			{
+				if (numMismatches++ < 10)
+				{
+					printf("readAll frame mismatch: register 0x%02lX, %lu BMBs\n", (unsigned long)address, (unsigned long)numBmbs);
+				}
+			}
+		}
+	}
+	return numMismatches;
+}
+
+/*!
+  @brief   Compare the writeAll frame of every register and value against the reference builder
+  @return  The number of mismatched frames
+*/
+static uint32_t checkWriteAllFrames(void)
+{
+	uint32_t numMismatches = 0;
+	for (uint32_t address = 0; address <= 0xFF; address++)
+	{
+		for (uint32_t value = 0; value <= 0xFFFF; value++)
+		{
+			uint8_t expected[MAX_ASCI_CMD_LENGTH];
+			uint8_t frame[MAX_ASCI_CMD_LENGTH];
+			const uint32_t expectedBytes = referenceWriteAllFrame(expected, address, value);
+			const uint32_t numBytes = buildWriteAllFrame(frame, address, value);
+			if ((numBytes != expectedBytes) || (memcmp(frame, expected, expectedBytes) != 0))
+			{
+				if (numMismatches++ < 10)
+				{
+					printf("writeAll frame mismatch: register 0x%02lX, value 0x%04lX\n", (unsigned long)address, (unsigned long)value);
+				}
+			}
+		}
+	}
+	return numMismatches;
+}
+
+
+/* ==================================================================== */
+/* =================== GLOBAL FUNCTION DEFINITIONS ==================== */
+/* ==================================================================== */
+
+/*!
+  @brief   Check the cached readAll frames and the precomputed writeAll CRCs byte for byte against
+		   frames built the way the blocking driver built them
+*/
+int main(void)
+{
+	frameTablesValid = checkFrameTables();
+	if (!frameTablesValid)
+	{
+		printf("Precomputed frame tables do not match calcCrc\n");
+		return 1;
+	}
+
+	// Both the precomputed tables and the fallback used when they fail their start up check
+	uint32_t numMismatches = 0;
+	for (int32_t tablesValid = 1; tablesValid >= 0; tablesValid--)
+	{
+		frameTablesValid = tablesValid;
+		const uint32_t readAllMismatches = checkReadAllFrames();
+		const uint32_t writeAllMismatches = checkWriteAllFrames();
+		printf("%s: %lu readAll and %lu writeAll frames differ from the blocking driver\n",
+			tablesValid ? "Frame tables" : "Frame builder", (unsigned long)readAllMismatches, (unsigned long)writeAllMismatches);
+		numMismatches += readAllMismatches + writeAllMismatches;
+	}
+	return (numMismatches == 0) ? 0 : 1;
+}